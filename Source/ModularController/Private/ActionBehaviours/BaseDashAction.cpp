@@ -5,7 +5,7 @@
 
 
 
-bool UBaseDashAction::CheckDash(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus,
+bool UBaseDashAction::CheckDash(FDashActionRuntime& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus,
 	const float inDelta, UModularControllerComponent* controller)
 {
 	FVector currentPosition = inDatas.InitialTransform.GetLocation();
@@ -15,7 +15,7 @@ bool UBaseDashAction::CheckDash(const FKinematicInfos& inDatas, const FVector mo
 	if (!inputs)
 		return false;
 
-	if (!IsSimulated() && controller)
+	if (!runtime.bIsSimulated && controller)
 	{
 		const auto actions = controller->GetCurrentControllerAction();
 		if (actions == this && !bCanTransitionToSelf)
@@ -24,17 +24,17 @@ bool UBaseDashAction::CheckDash(const FKinematicInfos& inDatas, const FVector mo
 		}
 	}
 
-	if (inputs->ReadInput(DashInputCommand, bDebugAction, controller).Phase == EInputEntryPhase::InputEntryPhase_Pressed)
+	if (inputs->ReadInput(_dashInputHandle, IsDebugging(), controller).Phase == EInputEntryPhase::InputEntryPhase_Pressed)
 	{
-		inputs->ConsumeInput(DashInputCommand, bDebugAction, controller);
-		_dashToLocation = inDatas.InitialTransform.GetLocation() + (moveInput.Length() > 0 ? moveInput : inDatas.InitialTransform.GetRotation().GetForwardVector()) * DashDistance;
+		inputs->ConsumeInput(_dashInputHandle, IsDebugging(), controller);
+		runtime.DashToLocation = inDatas.InitialTransform.GetLocation() + (moveInput.Length() > 0 ? moveInput : inDatas.InitialTransform.GetRotation().GetForwardVector()) * DashDistance;
 		if (!DashLocationInput.IsNone())
 		{
 			const FVector dashLocation = inputs->ConsumeInput(DashLocationInput).Axis;
-			_dashToLocation = dashLocation;
+			runtime.DashToLocation = dashLocation;
 		}
 		
-		controllerStatusParam.ActionsModifiers1 = _dashToLocation;
+		controllerStatusParam.ActionsModifiers1 = runtime.DashToLocation;
 
 		currentStatus = controllerStatusParam;
 		return true;
@@ -71,9 +71,7 @@ FVector UBaseDashAction::GetFourDirectionnalVector(FTransform bodyTransform, FVe
 
 void UBaseDashAction::OnAnimationEnded(UAnimMontage* Montage, bool bInterrupted)
 {
-	_EndDelegate.Unbind();
-
-	if (bDebugAction)
+	if (IsDebugging())
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Unbond Montage"), *GetDescriptionName().ToString()), true, true, FColor::Red, 5, FName(FString::Printf(TEXT("%s"), *GetDescriptionName().ToString())));
 	}
@@ -88,70 +86,85 @@ void UBaseDashAction::OnAnimationEnded(UAnimMontage* Montage, bool bInterrupted)
 //*//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-bool UBaseDashAction::CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseDashAction::InitializeAction()
+{
+	Super::InitializeAction();
+	_dashInputHandle = UInputEntryPool::RegisterInput(DashInputCommand);
+}
+
+bool UBaseDashAction::CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
-	return CheckDash(inDatas, moveInput, inputs, controllerStatusParam, currentStatus, inDelta, controller);
+	return CheckDash(runtime.Get<FDashActionRuntime>(), inDatas, moveInput, inputs, controllerStatusParam, currentStatus, inDelta, controller);
+}
+
+void UBaseDashAction::GetActionTriggerInputs(TArray<FName>& outInputs) const
+{
+	Super::GetActionTriggerInputs(outInputs);
+	if (!bAlwaysEvaluate && !DashInputCommand.IsNone())
+		outInputs.AddUnique(DashInputCommand);
 }
 
-FVelocity UBaseDashAction::OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseDashAction::OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
+	const FDashActionRuntime& dashRuntime = runtime.Get<FDashActionRuntime>();
 	FVelocity move = inDatas.InitialVelocities;
 	move.InstantLinearVelocity = fromVelocity.InstantLinearVelocity;
 
-	move.Rotation = FQuat::Slerp(move.Rotation, _initialRot, FMath::Clamp(inDelta * 50, 0, 1));
+	move.Rotation = FQuat::Slerp(move.Rotation, dashRuntime.InitialRot, FMath::Clamp(inDelta * 50, 0, 1));
 	move.ConstantLinearVelocity = UStructExtensions::AccelerateTo(move.ConstantLinearVelocity, FVector(0), 50, inDelta);
 	return move;
 }
 
-FVelocity UBaseDashAction::OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseDashAction::OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
+	FDashActionRuntime& dashRuntime = runtime.Get<FDashActionRuntime>();
 	FVelocity move = inDatas.InitialVelocities;
 	move.InstantLinearVelocity = fromVelocity.InstantLinearVelocity;
 
-	if (!_dashed)
+	if (!dashRuntime.bDashed)
 	{
-		_propulsionLocation = inDatas.InitialTransform.GetLocation();
+		dashRuntime.PropulsionLocation = inDatas.InitialTransform.GetLocation();
 
-		if (!IsSimulated() && controller)
+		if (!dashRuntime.bIsSimulated && controller)
 		{
 			if (inDatas.bUsePhysic && controller->GetCurrentSurface().GetSurfacePrimitive() != nullptr)
 			{
 				//Push Objects
 				if (controller->GetCurrentSurface().GetSurfacePrimitive()->IsSimulatingPhysics())
 				{
-					controller->GetCurrentSurface().GetSurfacePrimitive()->AddImpulseAtLocation(-(_dashToLocation - inDatas.InitialTransform.GetLocation()) * inDatas.GetMass() * inDelta, controller->GetCurrentSurface().GetHitResult().ImpactPoint, controller->GetCurrentSurface().GetHitResult().BoneName);
+					controller->GetCurrentSurface().GetSurfacePrimitive()->AddImpulseAtLocation(-(dashRuntime.DashToLocation - inDatas.InitialTransform.GetLocation()) * inDatas.GetMass() * inDelta, controller->GetCurrentSurface().GetHitResult().ImpactPoint, controller->GetCurrentSurface().GetHitResult().BoneName);
 				}
 			}
 		}
-		_dashed = true;
+		dashRuntime.bDashed = true;
 	}
 
 	//Handle rotation
 	{
-		move.Rotation = _initialRot;
+		move.Rotation = dashRuntime.InitialRot;
 	}
 
 	//Movement
 	const FVector initialLocation = inDatas.InitialTransform.GetLocation();
-	const FVector nextLocation = FMath::Lerp(initialLocation, _dashToLocation, inDelta * (1 / ActivePhaseDuration));
+	const FVector nextLocation = FMath::Lerp(initialLocation, dashRuntime.DashToLocation, inDelta * (1 / dashRuntime.ActivePhaseDuration));
 	move.ConstantLinearVelocity = (nextLocation - initialLocation) / inDelta;
 
-	if (bDebugAction)
+	if (IsDebugging())
 	{
-		UKismetSystemLibrary::DrawDebugPoint(this, _propulsionLocation, 500, FColor::Green, 5);
-		UKismetSystemLibrary::DrawDebugPoint(this, _dashToLocation, 500, FColor::Red, 5);
-		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Dash Speed: (%f); Location: (%s), Distance: (%f)"), *GetDescriptionName().ToString(), move.ConstantLinearVelocity.Length(), *_dashToLocation.ToCompactString(), (_dashToLocation - _propulsionLocation).Length()), true, true, FColor::Yellow, 10, "DashProcess");
+		UKismetSystemLibrary::DrawDebugPoint(this, dashRuntime.PropulsionLocation, 500, FColor::Green, 5);
+		UKismetSystemLibrary::DrawDebugPoint(this, dashRuntime.DashToLocation, 500, FColor::Red, 5);
+		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Dash Speed: (%f); Location: (%s), Distance: (%f)"), *GetDescriptionName().ToString(), move.ConstantLinearVelocity.Length(), *dashRuntime.DashToLocation.ToCompactString(), (dashRuntime.DashToLocation - dashRuntime.PropulsionLocation).Length()), true, true, FColor::Yellow, 10, "DashProcess");
 	}
 
 	return move;
 }
 
-FVelocity UBaseDashAction::OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseDashAction::OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
@@ -162,41 +175,43 @@ FVelocity UBaseDashAction::OnActionProcessRecoveryPhase_Implementation(FStatusPa
 	return move;
 }
 
-void UBaseDashAction::OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState)
+void UBaseDashAction::OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState)
 {
 	const FName stateName = newState != nullptr ? newState->GetDescriptionName() : "";
 	if (ActionCompatibilityMode == ActionCompatibilityMode_OnCompatibleStateOnly || ActionCompatibilityMode == ActionCompatibilityMode_OnBothCompatiblesStateAndAction)
 	{
 		if (!CompatibleStates.Contains(stateName))
 		{
-			_remainingActivationTimer = 0;
+			runtime.Get<FDashActionRuntime>().RemainingActivationTimer = 0;
 		}
 	}
 }
 
-void UBaseDashAction::OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseDashAction::OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
-	Super::OnActionEnds_Implementation(inDatas, moveInput, controller, controllerStatusParam, currentStatus, inDelta);
+	Super::OnActionEnds_Implementation(runtime, inDatas, moveInput, controller, controllerStatusParam, currentStatus, inDelta);
 }
 
-void UBaseDashAction::OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseDashAction::OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
+	FDashActionRuntime& dashRuntime = runtime.Get<FDashActionRuntime>();
 	FVector closestDir = inDatas.InitialTransform.GetRotation().Vector();
 	
 	if (controllerStatusParam.ActionsModifiers1.SquaredLength() > 0)
-		_dashToLocation = controllerStatusParam.ActionsModifiers1;
+		dashRuntime.DashToLocation = controllerStatusParam.ActionsModifiers1;
 
 	currentStatus = controllerStatusParam;
 
-	const FVector moveDirection = (_dashToLocation - inDatas.InitialTransform.GetLocation()).GetSafeNormal();
+	const FVector moveDirection = (dashRuntime.DashToLocation - inDatas.InitialTransform.GetLocation()).GetSafeNormal();
 
-	if (!IsSimulated() && controller)
+	if (!dashRuntime.bIsSimulated && controller)
 	{
 		//Bind montage needs call back
+		FOnMontageEnded endDelegate;
 		if (bUseMontageDuration)
-			_EndDelegate.BindUObject(this, &UBaseDashAction::OnAnimationEnded);
+			endDelegate.BindUObject(this, &UBaseDashAction::OnAnimationEnded);
 
 		//Select montage
 		auto selectedMontage = FwdDashMontage;
@@ -225,22 +240,22 @@ void UBaseDashAction::OnActionBegins_Implementation(const FKinematicInfos& inDat
 		if (bMontageShouldBePlayerOnStateAnimGraph)
 		{
 			if (const auto currentState = controller->GetCurrentControllerState())
-				montageDuration = controller->PlayAnimationMontageOnState_Internal(selectedMontage, currentState->GetDescriptionName(), -1, bUseMontageDuration, _EndDelegate);
+				montageDuration = controller->PlayAnimationMontageOnState_Internal(selectedMontage, currentState->GetDescriptionName(), -1, bUseMontageDuration, endDelegate);
 		}
 		else
 		{
-			montageDuration = controller->PlayAnimationMontage_Internal(selectedMontage, -1, bUseMontageDuration, _EndDelegate);
+			montageDuration = controller->PlayAnimationMontage_Internal(selectedMontage, -1, bUseMontageDuration, endDelegate);
 		}
 
 
-		if (bDebugAction)
+		if (IsDebugging())
 		{
 			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Montage duration: %f"), *GetDescriptionName().ToString(), montageDuration), true, true, FColor::Emerald, 5, "DashMontageDuration");
 		}
 
 		if (bUseMontageDuration && montageDuration > 0)
 		{
-			RemapDuration(montageDuration);
+			RemapDuration(runtime, montageDuration);
 		}
 	}
 
@@ -248,29 +263,13 @@ void UBaseDashAction::OnActionBegins_Implementation(const FKinematicInfos& inDat
 	const FVector up = -inDatas.Gravity.GetSafeNormal();
 	FVector movefwd = FVector::VectorPlaneProject(moveDirection.GetSafeNormal(), up);
 	FVector bodyfwd = FVector::VectorPlaneProject(closestDir.GetSafeNormal(), up);
-	_initialRot = inDatas.InitialTransform.GetRotation();
+	dashRuntime.InitialRot = inDatas.InitialTransform.GetRotation();
 	if (movefwd.Normalize() && bodyfwd.Normalize())
 	{
 		FQuat bodyFwdRot = UKismetMathLibrary::MakeRotationFromAxes(bodyfwd, FVector::CrossProduct(up, bodyfwd), up).Quaternion();
 		const FQuat moveFwdRot = UKismetMathLibrary::MakeRotationFromAxes(movefwd, FVector::CrossProduct(up, movefwd), up).Quaternion();
 		bodyFwdRot.EnforceShortestArcWith(moveFwdRot);
 		const FQuat diff = bodyFwdRot.Inverse() * moveFwdRot;
-		_initialRot *= diff;
+		dashRuntime.InitialRot *= diff;
 	}
 }
-
-void UBaseDashAction::SaveActionSnapShot_Internal()
-{
-	_dashToLocation_saved = _dashToLocation;
-	_propulsionLocation_saved = _propulsionLocation;
-	_dashed_saved = _dashed;
-	_initialRot_saved = _initialRot;
-}
-
-void UBaseDashAction::RestoreActionFromSnapShot_Internal()
-{
-	_dashToLocation = _dashToLocation_saved;
-	_propulsionLocation = _propulsionLocation_saved;
-	_dashed = _dashed_saved;
-	_initialRot = _initialRot_saved;
-}
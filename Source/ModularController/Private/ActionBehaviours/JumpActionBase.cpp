@@ -18,31 +18,62 @@
 /// </summary>
 /// <param name="controller"></param>
 /// <returns></returns>
-bool UJumpActionBase::CheckJump(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, const float inDelta, UModularControllerComponent* controller)
+bool UJumpActionBase::CheckJump(FJumpActionRuntime& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, const float inDelta, UModularControllerComponent* controller)
 {
-	FVector currentPosition = inDatas.InitialTransform.GetLocation();
-	FQuat currentRotation = inDatas.InitialTransform.GetRotation();
-	FVector gravityDir = inDatas.Gravity.GetSafeNormal();
+	if (!inputs)
+		return false;
+
+	//Probe the ceiling only when there is a jump to do.
+	const bool jumpPressed = inputs->ReadInput(_jumpInputHandle, IsDebugging(), controller).Phase == EInputEntryPhase::InputEntryPhase_Pressed;
+	if (CheckCeiling(runtime, inDatas, inDelta, controller, jumpPressed))
+		return false;
+
+	if (jumpPressed)
+	{
+		inputs->ConsumeInput(_jumpInputHandle, IsDebugging(), controller);
+		return true;
+	}
+
+	return false;
+}
+
+
+bool UJumpActionBase::CheckCeiling(FJumpActionRuntime& runtime, const FKinematicInfos& inDatas, const float inDelta, UModularControllerComponent* controller, bool probe)
+{
+	if (!controller)
+		return false;
+
+	const FVector currentPosition = inDatas.InitialTransform.GetLocation();
+	const FQuat currentRotation = inDatas.InitialTransform.GetRotation();
+	const FVector gravityDir = inDatas.Gravity.GetSafeNormal();
 
 	FHitResult ceilHitRes;
-	if (controller->ComponentTraceCastSingle(ceilHitRes, currentPosition - gravityDir, -gravityDir * MaxJumpHeight, currentRotation))
+	bool haveHit = false;
+	bool probed = false;
+	if (bUseAsyncCeilingCheck && controller->CanUseAsyncProbes())
 	{
-		if ((ceilHitRes.Location - currentPosition).Length() < MinJumpHeight)
-		{
-			return false;
-		}
+		//Last frame probe. The ceiling height is measured from the current position, so only a close start is required.
+		FTraceHandle lastProbe;
+		lastProbe._Handle = runtime.AsyncCeilingCheckHandle;
+		probed = controller->QueryAsyncComponentTraceCast(lastProbe, ceilHitRes)
+			&& FVector::Dist(runtime.AsyncCeilingCheckStart, currentPosition) <= MinJumpHeight * 0.5f;
+		haveHit = probed && ceilHitRes.IsValidBlockingHit();
+
+		//Next frame probe
+		runtime.AsyncCeilingCheckStart = currentPosition + inDatas.GetInitialMomentum() * inDelta;
+		runtime.AsyncCeilingCheckHandle = controller->AsyncComponentTraceCast(runtime.AsyncCeilingCheckStart - gravityDir, -gravityDir * MaxJumpHeight, currentRotation)._Handle;
 	}
 
-	if (!inputs)
+	if (!probe)
 		return false;
 
-	if (inputs->ReadInput(JumpInputCommand, bDebugAction, controller).Phase == EInputEntryPhase::InputEntryPhase_Pressed)
+	if (!probed)
 	{
-		inputs->ConsumeInput(JumpInputCommand, bDebugAction, controller);
-		return true;
+		const FComponentSweepRequest ceilingProbe(currentPosition - gravityDir, -gravityDir * MaxJumpHeight);
+		haveHit = controller->ComponentTraceCastBatch(MakeArrayView(&ceilHitRes, 1), MakeArrayView(&ceilingProbe, 1), currentRotation) > 0;
 	}
 
-	return false;
+	return haveHit && (ceilHitRes.Location - currentPosition).Length() < MinJumpHeight;
 }
 
 #pragma endregion
@@ -55,7 +86,7 @@ bool UJumpActionBase::CheckJump(const FKinematicInfos& inDatas, const FVector mo
 /// </summary>
 /// <param name="controller"></param>
 /// <returns></returns>
-FVector UJumpActionBase::Jump(const FKinematicInfos inDatas, FVector moveInput, const FVelocity momentum, const float inDelta, FVector customJumpLocation)
+FVector UJumpActionBase::Jump(const FJumpActionRuntime& runtime, const FKinematicInfos inDatas, FVector moveInput, const FVelocity momentum, const float inDelta, FVector customJumpLocation)
 {
 	//Get the maximum jump height
 	FVector currentPosition = inDatas.InitialTransform.GetLocation();
@@ -65,7 +96,7 @@ FVector UJumpActionBase::Jump(const FKinematicInfos inDatas, FVector moveInput,
 	float jumpHeight = MaxJumpHeight;
 
 	//Get the forward vector
-	FVector forwardVector = UseSurfaceNormalOnNoDirection ? _jumpSurfaceNormal : FVector(0);
+	FVector forwardVector = UseSurfaceNormalOnNoDirection ? runtime.JumpSurfaceNormal : FVector(0);
 	FVector inputVector = moveInput;
 	if (inputVector.Length() > 0)
 	{
@@ -84,7 +115,7 @@ FVector UJumpActionBase::Jump(const FKinematicInfos inDatas, FVector moveInput,
 		forwardVector.Normalize();
 	}
 
-	if (bDebugAction)
+	if (IsDebugging())
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Custom Jump Location: Location(%s)  Distance(%f), Height(%f)"), *GetDescriptionName().ToString(), *customJumpLocation.ToCompactString(), jumpLocationDist, jumpHeight), true, true, FColor::Black, 10, "customJumpLocation");
 	}
@@ -126,15 +157,28 @@ FVector UJumpActionBase::Jump(const FKinematicInfos inDatas, FVector moveInput,
 #pragma region Functions
 
 
-bool UJumpActionBase::CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UJumpActionBase::InitializeAction()
+{
+	Super::InitializeAction();
+	_jumpInputHandle = UInputEntryPool::RegisterInput(JumpInputCommand);
+}
+
+bool UJumpActionBase::CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
-	return CheckJump(inDatas, moveInput, inputs, inDelta, controller);
+	return CheckJump(runtime.Get<FJumpActionRuntime>(), inDatas, moveInput, inputs, inDelta, controller);
 }
 
+void UJumpActionBase::GetActionTriggerInputs(TArray<FName>& outInputs) const
+{
+	Super::GetActionTriggerInputs(outInputs);
+	if (!bAlwaysEvaluate && !JumpInputCommand.IsNone())
+		outInputs.AddUnique(JumpInputCommand);
+}
 
 
-FVelocity UJumpActionBase::OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+
+FVelocity UJumpActionBase::OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
@@ -143,14 +187,15 @@ FVelocity UJumpActionBase::OnActionProcessAnticipationPhase_Implementation(FStat
 	return move;
 }
 
-FVelocity UJumpActionBase::OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UJumpActionBase::OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
+	FJumpActionRuntime& jumpRuntime = runtime.Get<FJumpActionRuntime>();
 	FVelocity move = fromVelocity;
 	move.InstantLinearVelocity = FVector(0);	
 
-	if (_jumped)
+	if (jumpRuntime.bJumped)
 	{
 		return move;
 	}
@@ -169,16 +214,16 @@ FVelocity UJumpActionBase::OnActionProcessActivePhase_Implementation(FStatusPara
 		}
 	}
 
-	const FVector jumpLocation = IsSimulated() ? FVector(NAN) :
-		(JumpLocationInput.IsNone() ? FVector(NAN) : controller->ReadAxisInput(JumpLocationInput, true, bDebugAction, this));
-	if (!IsSimulated() && controller) 
+	const FVector jumpLocation = jumpRuntime.bIsSimulated ? FVector(NAN) :
+		(JumpLocationInput.IsNone() ? FVector(NAN) : controller->ReadAxisInput(JumpLocationInput, true, IsDebugging(), this));
+	if (!jumpRuntime.bIsSimulated && controller) 
 	{
-		_startMomentum.InstantLinearVelocity = controller->GetCurrentSurface().GetSurfaceLinearVelocity();
+		jumpRuntime.StartMomentum.InstantLinearVelocity = controller->GetCurrentSurface().GetSurfaceLinearVelocity();
 	}
-	const auto jumpForce = Jump(inDatas, moveInput, _startMomentum, inDelta, jumpLocation);
+	const auto jumpForce = Jump(jumpRuntime, inDatas, moveInput, jumpRuntime.StartMomentum, inDelta, jumpLocation);
 	move.ConstantLinearVelocity = jumpForce;
 
-	if (bDebugAction)
+	if (IsDebugging())
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Propulsion Vector: (%s); Velocity: (%s)"), *GetDescriptionName().ToString(), *jumpForce.ToCompactString(), *move.ConstantLinearVelocity.ToCompactString()), true, true, FColor::Yellow, 10, "");
 	}
@@ -195,7 +240,7 @@ FVelocity UJumpActionBase::OnActionProcessActivePhase_Implementation(FStatusPara
 		}
 	}
 
-	if (!IsSimulated())
+	if (!jumpRuntime.bIsSimulated)
 	{
 		if (inDatas.bUsePhysic && controller->GetCurrentSurface().GetSurfacePrimitive() != nullptr)
 		{
@@ -207,27 +252,25 @@ FVelocity UJumpActionBase::OnActionProcessActivePhase_Implementation(FStatusPara
 		}
 	}
 
-	_jumped = true;
+	jumpRuntime.bJumped = true;
 
 	return move;
 }
 
-FVelocity UJumpActionBase::OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UJumpActionBase::OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
 	FVelocity move = fromVelocity;
 	move.InstantLinearVelocity = FVector(0);
-	_jumped = false;
+	runtime.Get<FJumpActionRuntime>().bJumped = false;
 	return move;
 }
 
 
 void UJumpActionBase::OnAnimationEnded(UAnimMontage* Montage, bool bInterrupted)
 {
-	_EndDelegate.Unbind();
-
-	if (bDebugAction)
+	if (IsDebugging())
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Unbond Montage"), *GetDescriptionName().ToString()), true, true, FColor::Red, 5, FName(FString::Printf(TEXT("%s"), *GetDescriptionName().ToString())));
 	}
@@ -240,66 +283,53 @@ void UJumpActionBase::OnAnimationEnded(UAnimMontage* Montage, bool bInterrupted)
 
 
 
-void UJumpActionBase::OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UJumpActionBase::OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
-	if (!IsSimulated() && controller)
+	FJumpActionRuntime& jumpRuntime = runtime.Get<FJumpActionRuntime>();
+	if (!jumpRuntime.bIsSimulated && controller)
 	{
 		//Bind montage neds call back
+		FOnMontageEnded endDelegate;
 		if (bUseMontageDuration)
-			_EndDelegate.BindUObject(this, &UJumpActionBase::OnAnimationEnded);
+			endDelegate.BindUObject(this, &UJumpActionBase::OnAnimationEnded);
 
 		//Play montage
 		float montageDuration = 0;
 		if (bMontageShouldBePlayerOnStateAnimGraph)
 		{
 			if (const auto currentState = controller->GetCurrentControllerState())
-				montageDuration = controller->PlayAnimationMontageOnState_Internal(JumpMontage, currentState->GetDescriptionName(), -1, bUseMontageDuration, _EndDelegate);
+				montageDuration = controller->PlayAnimationMontageOnState_Internal(JumpMontage, currentState->GetDescriptionName(), -1, bUseMontageDuration, endDelegate);
 		}
 		else
 		{
-			montageDuration = controller->PlayAnimationMontage_Internal(JumpMontage, -1, bUseMontageDuration, _EndDelegate);
+			montageDuration = controller->PlayAnimationMontage_Internal(JumpMontage, -1, bUseMontageDuration, endDelegate);
 		}
 
 
-		if (bDebugAction)
+		if (IsDebugging())
 		{
 			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("(%s) -> Montage duration: %f"), *GetDescriptionName().ToString(), montageDuration), true, true, FColor::Emerald, 5, "JumpMontageDuration");
 		}
 
 		if (bUseMontageDuration && montageDuration > 0)
 		{
-			RemapDuration(montageDuration);
+			RemapDuration(runtime, montageDuration);
 		}
 	}
 
-	_jumped = false;
-	_startMomentum = inDatas.InitialVelocities;
-}
-
-
-void UJumpActionBase::SaveActionSnapShot_Internal()
-{
-	_jumped_saved = _jumped;
-	_jumpSurfaceNormal_saved = _jumpSurfaceNormal;
-	_startMomentum_saved = _startMomentum;
-}
-
-void UJumpActionBase::RestoreActionFromSnapShot_Internal()
-{
-	_jumped = _jumped_saved;
-	_jumpSurfaceNormal = _jumpSurfaceNormal_saved;
-	_startMomentum = _startMomentum_saved;
+	jumpRuntime.bJumped = false;
+	jumpRuntime.StartMomentum = inDatas.InitialVelocities;
 }
 
 
-void UJumpActionBase::OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UJumpActionBase::OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
 }
 
 
-void UJumpActionBase::OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState)
+void UJumpActionBase::OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState)
 {
 	FName stateName = newState != nullptr ? newState->GetDescriptionName() : "";
 	if (CompatibleStates.Contains(stateName))
@@ -13,98 +13,160 @@
 
 void UBaseControllerAction::InitializeAction()
 {
-	_startingDurations = FVector(AnticipationPhaseDuration, ActivePhaseDuration, RecoveryPhaseDuration);
+	//Native events without a blueprint override can be called directly.
+	const UClass* actionClass = GetClass();
+	_checkActionInScript = actionClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerAction, CheckAction));
+	_anticipationPhaseInScript = actionClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerAction, OnActionProcessAnticipationPhase));
+	_activePhaseInScript = actionClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerAction, OnActionProcessActivePhase));
+	_recoveryPhaseInScript = actionClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerAction, OnActionProcessRecoveryPhase));
 }
 
 
-void UBaseControllerAction::OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState)
+void UBaseControllerAction::InitializeRuntime(FBehaviourSnapShotRing& runtime, int snapShotDepth) const
+{
+	const UScriptStruct* runtimeStruct = GetRuntimeStruct();
+	if (!ensureMsgf(runtimeStruct && runtimeStruct->IsChildOf(FControllerActionRuntime::StaticStruct()), TEXT("The runtime struct of the action %s must derive FControllerActionRuntime"), *GetName()))
+		runtimeStruct = FControllerActionRuntime::StaticStruct();
+	runtime.Initialize(runtimeStruct, snapShotDepth);
+
+	//The phases durations are remapped at runtime.
+	FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
+	actionRuntime.AnticipationPhaseDuration = AnticipationPhaseDuration;
+	actionRuntime.ActivePhaseDuration = ActivePhaseDuration;
+	actionRuntime.RecoveryPhaseDuration = RecoveryPhaseDuration;
+}
+
+
+void UBaseControllerAction::OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState)
 {
 
 }
 
 
 
-void UBaseControllerAction::SaveActionSnapShot()
+void UBaseControllerAction::SaveActionSnapShot(FBehaviourSnapShotRing& runtime)
 {
-	if (_snapShotSaved)
+	FControllerActionRuntime& live = runtime.Get<FControllerActionRuntime>();
+	if (live.bIsSimulated)
 		return;
-	SaveActionSnapShot_Internal();
-	_remainingActivationTimer_saved = _remainingActivationTimer;
-	_repeatCount_saved = _repeatCount;
-	_wasActiveFrame_saved = _wasActiveFrame;
-	_cooldownTimer_saved = _cooldownTimer;
-	_snapShotSaved = true;
+	runtime.Save(FBehaviourSnapShotRing::SimulationFrame);
+	live.bIsSimulated = true;
 }
 
-void UBaseControllerAction::RestoreActionFromSnapShot()
+void UBaseControllerAction::RestoreActionFromSnapShot(FBehaviourSnapShotRing& runtime)
 {
-	if (!_snapShotSaved)
+	if (!runtime.Get<FControllerActionRuntime>().bIsSimulated)
 		return;
-	_remainingActivationTimer = _remainingActivationTimer_saved;
-	_cooldownTimer = _cooldownTimer_saved;
-	_repeatCount = _repeatCount_saved;
-	_wasActiveFrame = _wasActiveFrame_saved;
-	CurrentPhase = (_remainingActivationTimer <= AnticipationPhaseDuration) ? ActionPhase_Anticipation : ((_remainingActivationTimer > (ActivePhaseDuration + AnticipationPhaseDuration)) ? ActionPhase_Recovery : ActionPhase_Active);
-	RestoreActionFromSnapShot_Internal();
-	_snapShotSaved = false;
+	runtime.Restore(FBehaviourSnapShotRing::SimulationFrame);
 }
 
-void UBaseControllerAction::SaveActionSnapShot_Internal()
+
+void UBaseControllerAction::OnActionChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerAction* newAction,
+	UBaseControllerAction* lastAction)
 {
 }
 
-void UBaseControllerAction::RestoreActionFromSnapShot_Internal()
+void UBaseControllerAction::OnActionPhaseChanged_Implementation(const FBehaviourRuntimeRef& runtime, EActionPhase newPhase,
+	EActionPhase lastPhase)
 {
 }
 
+bool UBaseControllerAction::GetActivatedLastFrame(const FBehaviourRuntimeRef& runtime) const
+{
+	const FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>();
+	return actionRuntime && actionRuntime->bWasActiveFrame;
+}
 
-void UBaseControllerAction::OnActionChanged_Implementation(UBaseControllerAction* newAction,
-	UBaseControllerAction* lastAction)
+void UBaseControllerAction::SetActivatedLastFrame(const FBehaviourRuntimeRef& runtime, bool value) const
 {
+	if (FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>())
+		actionRuntime->bWasActiveFrame = value;
 }
 
-void UBaseControllerAction::OnActionPhaseChanged_Implementation(EActionPhase newPhase,
-	EActionPhase lastPhase)
+double UBaseControllerAction::GetRemainingActivationTime(const FBehaviourRuntimeRef& runtime) const
+{
+	const FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>();
+	return actionRuntime ? FMath::Max(actionRuntime->RemainingActivationTimer, 0.0) : 0;
+}
+
+void UBaseControllerAction::GetActionTriggerInputs(TArray<FName>& outInputs) const
 {
+	if (bAlwaysEvaluate)
+		return;
+	outInputs.Append(TriggerInputs);
 }
 
-bool UBaseControllerAction::GetActivatedLastFrame()
+void UBaseControllerAction::EnterPhase(const FBehaviourRuntimeRef& runtime, EActionPhase phase)
 {
-	return _wasActiveFrame;
+	FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
+	if (actionRuntime.CurrentPhase >= phase)
+		return;
+	const EActionPhase lastPhase = actionRuntime.CurrentPhase;
+	actionRuntime.CurrentPhase = phase;
+	OnActionPhaseChanged(runtime, phase, lastPhase);
 }
 
-void UBaseControllerAction::SetActivatedLastFrame(bool value)
+double UBaseControllerAction::GetRemainingCoolDownTime(const FBehaviourRuntimeRef& runtime) const
 {
-	_wasActiveFrame = value;
+	const FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>();
+	return actionRuntime ? FMath::Max(actionRuntime->CoolDownTimer, 0.0) : 0;
 }
 
-double UBaseControllerAction::GetRemainingActivationTime()
+bool UBaseControllerAction::IsSimulated(const FBehaviourRuntimeRef& runtime) const
 {
-	if (_remainingActivationTimer < 0)
-		_remainingActivationTimer = 0;
-	return _remainingActivationTimer;
+	const FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>();
+	return actionRuntime && actionRuntime->bIsSimulated;
 }
 
-double UBaseControllerAction::GetRemainingCoolDownTime()
+void UBaseControllerAction::RemapDuration(const FBehaviourRuntimeRef& runtime, float duration, bool tryDontMapAnticipation, bool tryDontMapRecovery) const
 {
-	if (_cooldownTimer < 0)
-		_cooldownTimer = 0;
-	return _cooldownTimer;
+	FControllerActionRuntime* actionRuntime = runtime.GetPtr<FControllerActionRuntime>();
+	if (!actionRuntime)
+		return;
+
+	const FVector startingDurations = FVector(AnticipationPhaseDuration, ActivePhaseDuration, RecoveryPhaseDuration);
+	const float anticipationScale = startingDurations.X / (startingDurations.X + startingDurations.Y + startingDurations.Z);
+	const float recoveryScale = startingDurations.Z / (startingDurations.X + startingDurations.Y + startingDurations.Z);
+	//Anticipation
+	float newAnticipation = duration * anticipationScale;
+	if (tryDontMapAnticipation)
+	{
+		newAnticipation = FMath::Clamp(startingDurations.X, 0, FMath::Clamp((duration * 0.5f) - 0.05, 0, TNumericLimits<float>().Max()));
+	}
+
+	//Recovery
+	float newRecovery = duration * recoveryScale;
+	if (tryDontMapRecovery)
+	{
+		newRecovery = FMath::Clamp(startingDurations.Z, 0, FMath::Clamp((duration * 0.5f) - 0.05, 0, TNumericLimits<float>().Max()));
+	}
+
+	const float newDuration = duration - (newAnticipation + newRecovery);
+
+	actionRuntime->AnticipationPhaseDuration = newAnticipation;
+	actionRuntime->ActivePhaseDuration = newDuration;
+	actionRuntime->RecoveryPhaseDuration = newRecovery;
+
+
+	if (IsDebugging())
+	{
+		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Remap from (%s) to (%s)"), *startingDurations.ToCompactString(), *FVector(newAnticipation, newDuration, newRecovery).ToCompactString()), true, true, FColor::Orange, 5, "remapingDuration");
+	}
 }
 
 
 
-void UBaseControllerAction::OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseControllerAction::OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
                                                           UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
 }
 
-void UBaseControllerAction::OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseControllerAction::OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
 }
 
-bool UBaseControllerAction::CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+bool UBaseControllerAction::CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta)
 {
 	return false;
@@ -112,21 +174,21 @@ bool UBaseControllerAction::CheckAction_Implementation(const FKinematicInfos& in
 
 
 
-FVelocity UBaseControllerAction::OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseControllerAction::OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
 	return {};
 }
 
-FVelocity UBaseControllerAction::OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseControllerAction::OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller,
 	const float inDelta)
 {
 	return {};
 }
 
-FVelocity UBaseControllerAction::OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UBaseControllerAction::OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
@@ -136,80 +198,76 @@ FVelocity UBaseControllerAction::OnActionProcessRecoveryPhase_Implementation(FSt
 
 
 
-void UBaseControllerAction::OnActionBegins_Internal(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseControllerAction::OnActionBegins_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta)
 {
-	OnActionBegins(inDatas, moveInput, controller, currentStatus, currentStatus, inDelta);
+	OnActionBegins(runtime, inDatas, moveInput, controller, currentStatus, currentStatus, inDelta);
 
 	//Set timers
-	_remainingActivationTimer = AnticipationPhaseDuration + ActivePhaseDuration + RecoveryPhaseDuration;
-	_cooldownTimer = 0;
+	FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
+	actionRuntime.RemainingActivationTimer = actionRuntime.AnticipationPhaseDuration + actionRuntime.ActivePhaseDuration + actionRuntime.RecoveryPhaseDuration;
+	actionRuntime.CoolDownTimer = 0;
 }
 
-void UBaseControllerAction::OnActionEnds_Internal(const FKinematicInfos& inDatas, const FVector moveInput,
+void UBaseControllerAction::OnActionEnds_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta)
 {
-	OnActionEnds(inDatas, moveInput, controller, currentStatus, currentStatus, inDelta);
+	OnActionEnds(runtime, inDatas, moveInput, controller, currentStatus, currentStatus, inDelta);
 
 	//Reset timers
-	_remainingActivationTimer = 0;
-	_cooldownTimer = CoolDownDelay;
-	CurrentPhase = ActionPhase_Undetermined;
+	FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
+	actionRuntime.RemainingActivationTimer = 0;
+	actionRuntime.CoolDownTimer = CoolDownDelay;
+	actionRuntime.CurrentPhase = ActionPhase_Undetermined;
 }
 
-bool UBaseControllerAction::CheckAction_Internal(const FKinematicInfos& inDatas, const FVector moveInput,
+bool UBaseControllerAction::CheckAction_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta)
 {
-	//Update cooldown timer
-	if (_cooldownTimer > 0)
-	{
-		_cooldownTimer -= inDelta;
-		return false;
-	}
+	//The cooldown is checked by the controller from it's action timers.
+	const FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
 	
-	if (CurrentPhase == ActionPhase_Anticipation || CurrentPhase == ActionPhase_Active)
+	if (actionRuntime.CurrentPhase == ActionPhase_Anticipation || actionRuntime.CurrentPhase == ActionPhase_Active)
 		return false;
 	
-	if (CurrentPhase == ActionPhase_Recovery && !bCanTransitionToSelf)
+	if (actionRuntime.CurrentPhase == ActionPhase_Recovery && !bCanTransitionToSelf)
 		return false;
 
-	return CheckAction(inDatas, moveInput, inputs, controller, currentStatus, currentStatus, inDelta);
+	if (_checkActionInScript)
+		return CheckAction(runtime, inDatas, moveInput, inputs, controller, currentStatus, currentStatus, inDelta);
+	return CheckAction_Implementation(runtime, inDatas, moveInput, inputs, controller, currentStatus, currentStatus, inDelta);
 }
 
-FVelocity UBaseControllerAction::OnActionProcess_Internal(FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity,
+FVelocity UBaseControllerAction::OnActionProcess_Internal(const FBehaviourRuntimeRef& runtime, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity,
 	const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
 {
+	FControllerActionRuntime& actionRuntime = runtime.Get<FControllerActionRuntime>();
+
 	//Update activation timer
-	if (_remainingActivationTimer > 0)
+	if (actionRuntime.RemainingActivationTimer > 0)
 	{
-		_remainingActivationTimer -= inDelta;
+		actionRuntime.RemainingActivationTimer -= inDelta;
 
-		if (_remainingActivationTimer > (ActivePhaseDuration + RecoveryPhaseDuration))
+		if (actionRuntime.RemainingActivationTimer > (actionRuntime.ActivePhaseDuration + actionRuntime.RecoveryPhaseDuration))
 		{
-			if (CurrentPhase != ActionPhase_Anticipation)
-			{
-				OnActionPhaseChanged(ActionPhase_Anticipation, CurrentPhase);
-				CurrentPhase = ActionPhase_Anticipation;
-			}
-			return OnActionProcessAnticipationPhase(controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			EnterPhase(runtime, ActionPhase_Anticipation);
+			if (_anticipationPhaseInScript)
+				return OnActionProcessAnticipationPhase(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			return OnActionProcessAnticipationPhase_Implementation(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
 		}
-		else if (_remainingActivationTimer > RecoveryPhaseDuration && _remainingActivationTimer <= (ActivePhaseDuration + RecoveryPhaseDuration))
+		else if (actionRuntime.RemainingActivationTimer > actionRuntime.RecoveryPhaseDuration && actionRuntime.RemainingActivationTimer <= (actionRuntime.ActivePhaseDuration + actionRuntime.RecoveryPhaseDuration))
 		{
-			if (CurrentPhase != ActionPhase_Active)
-			{
-				OnActionPhaseChanged(ActionPhase_Active, CurrentPhase);
-				CurrentPhase = ActionPhase_Active;
-			}
-			return OnActionProcessActivePhase(controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			EnterPhase(runtime, ActionPhase_Active);
+			if (_activePhaseInScript)
+				return OnActionProcessActivePhase(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			return OnActionProcessActivePhase_Implementation(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
 		}
 		else
 		{
-			if (CurrentPhase != ActionPhase_Recovery)
-			{
-				OnActionPhaseChanged(ActionPhase_Recovery, CurrentPhase);
-				CurrentPhase = ActionPhase_Recovery;
-			}
-			return OnActionProcessRecoveryPhase(controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			EnterPhase(runtime, ActionPhase_Recovery);
+			if (_recoveryPhaseInScript)
+				return OnActionProcessRecoveryPhase(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
+			return OnActionProcessRecoveryPhase_Implementation(runtime, controllerStatus, controllerStatus, inDatas, fromVelocity, moveInput, controller, inDelta);
 		}
 	}
 
@@ -219,8 +277,7 @@ FVelocity UBaseControllerAction::OnActionProcess_Internal(FStatusParameters& con
 
 
 
-FString UBaseControllerAction::DebugString()
+FString UBaseControllerAction::DebugString(const FBehaviourRuntimeRef& runtime)
 {
 	return GetDescriptionName().ToString();
 }
-
@@ -5,28 +5,71 @@
 
 
 
-void UBaseControllerState::SaveStateSnapShot()
+void UBaseControllerState::InitializeState()
 {
-	if (_snapShotSaved)
+	//Native events without a blueprint override can be called directly.
+	const UClass* stateClass = GetClass();
+	_checkStateInScript = stateClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerState, CheckState));
+	_processStateInScript = stateClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UBaseControllerState, ProcessState));
+}
+
+
+void UBaseControllerState::InitializeRuntime(FBehaviourSnapShotRing& runtime, int snapShotDepth) const
+{
+	const UScriptStruct* runtimeStruct = GetRuntimeStruct();
+	if (!ensureMsgf(runtimeStruct && runtimeStruct->IsChildOf(FControllerStateRuntime::StaticStruct()), TEXT("The runtime struct of the state %s must derive FControllerStateRuntime"), *GetName()))
+		runtimeStruct = FControllerStateRuntime::StaticStruct();
+	runtime.Initialize(runtimeStruct, snapShotDepth);
+}
+
+
+bool UBaseControllerState::CheckState_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus)
+{
+	if (_checkStateInScript)
+		return CheckState(runtime, inDatas, moveInput, inputs, controller, currentStatus, currentStatus, inDelta, overrideWasLastStateStatus);
+	return CheckState_Implementation(runtime, inDatas, moveInput, inputs, controller, currentStatus, currentStatus, inDelta, overrideWasLastStateStatus);
+}
+
+
+FVelocity UBaseControllerState::ProcessState_Internal(const FBehaviourRuntimeRef& runtime, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
+{
+	if (_processStateInScript)
+		return ProcessState(runtime, controllerStatus, controllerStatus, inDatas, moveInput, controller, inDelta);
+	return ProcessState_Implementation(runtime, controllerStatus, controllerStatus, inDatas, moveInput, controller, inDelta);
+}
+
+
+void UBaseControllerState::SaveStateSnapShot(FBehaviourSnapShotRing& runtime)
+{
+	FControllerStateRuntime& live = runtime.Get<FControllerStateRuntime>();
+	if (live.bIsSimulated)
 		return;
-	SaveStateSnapShot_Internal();
-	_wasTheLastFrameBehaviour_saved = _wasTheLastFrameBehaviour;
-	_snapShotSaved = true;
+	runtime.Save(FBehaviourSnapShotRing::SimulationFrame);
+	live.bIsSimulated = true;
 }
 
-void UBaseControllerState::RestoreStateFromSnapShot()
+void UBaseControllerState::RestoreStateFromSnapShot(FBehaviourSnapShotRing& runtime)
 {
-	if(!_snapShotSaved)
+	if (!runtime.Get<FControllerStateRuntime>().bIsSimulated)
 		return;
-	_wasTheLastFrameBehaviour = _wasTheLastFrameBehaviour_saved;
-	RestoreStateFromSnapShot_Internal();
-	_snapShotSaved = false;
+	runtime.Restore(FBehaviourSnapShotRing::SimulationFrame);
+}
+
+bool UBaseControllerState::IsCheckDue(const FControllerStateRuntime& runtime, const double time, bool isActiveState) const
+{
+	return CheckInterval <= 0 || isActiveState || time >= runtime.NextCheckTime;
+}
+
+void UBaseControllerState::ConsumeCheckInterval(FControllerStateRuntime& runtime, const double time) const
+{
+	runtime.NextCheckTime = time + CheckInterval;
 }
 
 
 
 
-bool UBaseControllerState::CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+bool UBaseControllerState::CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 	, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus)
 {
 	return false;
@@ -34,52 +77,57 @@ bool UBaseControllerState::CheckState_Implementation(const FKinematicInfos& inDa
 
 
 
-FVelocity UBaseControllerState::ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas,
+FVelocity UBaseControllerState::ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas,
 	const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
 {
 	return FVelocity();
 }
 
-void UBaseControllerState::OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
+void UBaseControllerState::OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
 {
 }
 
 
-void UBaseControllerState::OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
+void UBaseControllerState::OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta)
 {
 }
 
-void UBaseControllerState::OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller)
+void UBaseControllerState::OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller)
 {
 }
 
-void UBaseControllerState::SaveStateSnapShot_Internal()
+FString UBaseControllerState::DebugString(const FBehaviourRuntimeRef& runtime)
 {
+	return GetDescriptionName().ToString();
 }
 
-void UBaseControllerState::RestoreStateFromSnapShot_Internal()
+
+void UBaseControllerState::OnActionChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerAction* newAction,
+	UBaseControllerAction* lastAction)
 {
 }
 
-
-FString UBaseControllerState::DebugString()
+bool UBaseControllerState::GetWasTheLastFrameControllerState(const FBehaviourRuntimeRef& runtime) const
 {
-	return GetDescriptionName().ToString();
+	const FControllerStateRuntime* stateRuntime = runtime.GetPtr<FControllerStateRuntime>();
+	return stateRuntime && stateRuntime->bWasTheLastFrameBehaviour;
 }
 
-
-void UBaseControllerState::OnActionChanged_Implementation(UBaseControllerAction* newAction,
-	UBaseControllerAction* lastAction)
+void UBaseControllerState::SetWasTheLastFrameControllerState(const FBehaviourRuntimeRef& runtime, bool value) const
 {
+	if (FControllerStateRuntime* stateRuntime = runtime.GetPtr<FControllerStateRuntime>())
+		stateRuntime->bWasTheLastFrameBehaviour = value;
 }
 
-bool UBaseControllerState::GetWasTheLastFrameControllerState()
+FSurfaceInfos UBaseControllerState::GetSurfaceInfos(const FBehaviourRuntimeRef& runtime) const
 {
-	return _wasTheLastFrameBehaviour;
+	const FControllerStateRuntime* stateRuntime = runtime.GetPtr<FControllerStateRuntime>();
+	return stateRuntime ? stateRuntime->SurfaceInfos : FSurfaceInfos();
 }
 
-void UBaseControllerState::SetWasTheLastFrameControllerState(bool value)
+bool UBaseControllerState::IsSimulated(const FBehaviourRuntimeRef& runtime) const
 {
-	_wasTheLastFrameBehaviour = value;
+	const FControllerStateRuntime* stateRuntime = runtime.GetPtr<FControllerStateRuntime>();
+	return stateRuntime && stateRuntime->bIsSimulated;
 }
 
@@ -0,0 +1,194 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+
+#include "ComponentAndBase/ControllerInputBridgeComponent.h"
+#include "ComponentAndBase/ModularControllerComponent.h"
+#include "ComponentAndBase/ModularControllerSubsystem.h"
+#include "EnhancedInputComponent.h"
+#include "EnhancedPlayerInput.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+
+
+UControllerInputBridgeComponent::UControllerInputBridgeComponent()
+{
+	//Ticks to bind the actions once the input component exists, and to submit the axes.
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = ETickingGroup::TG_PrePhysics;
+}
+
+
+void UControllerInputBridgeComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	_controller = GetOwner()->FindComponentByClass<UModularControllerComponent>();
+	if (APawn* pawn = Cast<APawn>(GetOwner()))
+	{
+		pawn->ReceiveControllerChangedDelegate.AddUniqueDynamic(this, &UControllerInputBridgeComponent::OnOwnerControllerChanged);
+		SetTickPrerequisiteController(pawn->GetController());
+	}
+
+	//The inputs must be in the pool before the controller is updated, by it's own tick or by the subsystem.
+	if (_controller)
+		_controller->PrimaryComponentTick.AddPrerequisite(this, PrimaryComponentTick);
+	if (UModularControllerSubsystem* subsystem = GetWorld()->GetSubsystem<UModularControllerSubsystem>())
+		subsystem->AddUpdatePrerequisite(this, PrimaryComponentTick);
+
+	BindInputs(GetOwner()->InputComponent);
+}
+
+
+void UControllerInputBridgeComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnbindInputs();
+	SetTickPrerequisiteController(nullptr);
+	if (APawn* pawn = Cast<APawn>(GetOwner()))
+		pawn->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UControllerInputBridgeComponent::OnOwnerControllerChanged);
+	if (_controller)
+		_controller->PrimaryComponentTick.RemovePrerequisite(this, PrimaryComponentTick);
+	if (UModularControllerSubsystem* subsystem = GetWorld() ? GetWorld()->GetSubsystem<UModularControllerSubsystem>() : nullptr)
+		subsystem->RemoveUpdatePrerequisite(this, PrimaryComponentTick);
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UControllerInputBridgeComponent::OnOwnerControllerChanged(APawn* pawn, AController* oldController, AController* newController)
+{
+	SetTickPrerequisiteController(newController);
+
+	//The input component is recreated with the possession. When it's not there yet, the tick binds it.
+	UnbindInputs();
+	BindInputs(GetOwner()->InputComponent);
+}
+
+
+void UControllerInputBridgeComponent::SetTickPrerequisiteController(AController* controller)
+{
+	if (_tickPrerequisiteController.Get() == controller)
+		return;
+	if (AController* previousController = _tickPrerequisiteController.Get())
+		RemoveTickPrerequisiteActor(previousController);
+	_tickPrerequisiteController = controller;
+	if (controller)
+		AddTickPrerequisiteActor(controller);
+}
+
+
+void UControllerInputBridgeComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//The input component is created on possession, and destroyed on unpossession.
+	if (!_inputComponent.IsValid() && GetOwner()->InputComponent)
+		BindInputs(GetOwner()->InputComponent);
+
+	if (bBulkAxisSubmission && _inputComponent.IsValid())
+		SubmitAxes();
+}
+
+
+bool UControllerInputBridgeComponent::BindInputs(UInputComponent* inputComponent)
+{
+	UEnhancedInputComponent* enhancedInput = Cast<UEnhancedInputComponent>(inputComponent);
+	if (!enhancedInput)
+		return false;
+	if (_inputComponent.Get() == enhancedInput)
+		return true;
+	UnbindInputs();
+
+	for (int32 i = 0; i < InputBindings.Num(); i++)
+	{
+		FControllerInputBinding& binding = InputBindings[i];
+		binding._handle = UInputEntryPool::RegisterInput(binding.InputKey);
+		if (!binding.Action || binding._handle == INDEX_NONE)
+			continue;
+
+		binding._entry = FInputEntry();
+		switch (binding.Action->ValueType)
+		{
+		case EInputActionValueType::Boolean:
+			binding._entry.Nature = EInputEntryNature::InputEntryNature_Button;
+			binding._entry.Type = binding.ButtonBufferTime > 0 ? EInputEntryType::InputEntryType_Buffered : EInputEntryType::InputEntryType_Simple;
+			binding._entry.InputBuffer = binding.ButtonBufferTime;
+			_eventBindings.Add(enhancedInput->BindAction(binding.Action, ETriggerEvent::Triggered, this, &UControllerInputBridgeComponent::OnButtonTriggered, i).GetHandle());
+			break;
+		default:
+			binding._entry.Nature = binding.Action->ValueType == EInputActionValueType::Axis1D ? EInputEntryNature::InputEntryNature_Value : EInputEntryNature::InputEntryNature_Axis;
+			if (bBulkAxisSubmission)
+				_bulkBindings.Add(i);
+			else
+				_eventBindings.Add(enhancedInput->BindAction(binding.Action, ETriggerEvent::Triggered, this, &UControllerInputBridgeComponent::OnAxisTriggered, i).GetHandle());
+			break;
+		}
+	}
+	_bulkHandles.Reserve(_bulkBindings.Num());
+	_bulkEntries.Reserve(_bulkBindings.Num());
+	_inputComponent = enhancedInput;
+
+	//Read the axes once the player controller processed the inputs of the frame.
+	if (const APawn* pawn = Cast<APawn>(GetOwner()))
+		SetTickPrerequisiteController(pawn->GetController());
+	return true;
+}
+
+
+void UControllerInputBridgeComponent::UnbindInputs()
+{
+	if (UEnhancedInputComponent* enhancedInput = _inputComponent.Get())
+	{
+		for (const uint32 eventBinding : _eventBindings)
+			enhancedInput->RemoveBindingByHandle(eventBinding);
+	}
+	_eventBindings.Reset();
+	_bulkBindings.Reset();
+	_inputComponent = nullptr;
+}
+
+
+void UControllerInputBridgeComponent::OnButtonTriggered(const FInputActionInstance& instance, int32 bindingIndex)
+{
+	if (!_controller || !InputBindings.IsValidIndex(bindingIndex))
+		return;
+	const FControllerInputBinding& binding = InputBindings[bindingIndex];
+	_controller->ListenInput(binding._handle, binding._entry);
+}
+
+
+void UControllerInputBridgeComponent::OnAxisTriggered(const FInputActionInstance& instance, int32 bindingIndex)
+{
+	if (!_controller || !InputBindings.IsValidIndex(bindingIndex))
+		return;
+	const FControllerInputBinding& binding = InputBindings[bindingIndex];
+	FInputEntry entry = binding._entry;
+	entry.Axis = instance.GetValue().Get<FVector>();
+	_controller->ListenInput(binding._handle, entry);
+}
+
+
+void UControllerInputBridgeComponent::SubmitAxes()
+{
+	if (!_controller || _bulkBindings.Num() <= 0)
+		return;
+	const APawn* pawn = Cast<APawn>(GetOwner());
+	const APlayerController* playerController = pawn ? Cast<APlayerController>(pawn->GetController()) : nullptr;
+	const UEnhancedPlayerInput* playerInput = playerController ? Cast<UEnhancedPlayerInput>(playerController->PlayerInput) : nullptr;
+	if (!playerInput)
+		return;
+
+	_bulkHandles.Reset();
+	_bulkEntries.Reset();
+	for (const int32 bindingIndex : _bulkBindings)
+	{
+		const FControllerInputBinding& binding = InputBindings[bindingIndex];
+		//Like the trigger events, an axis at rest is not listened.
+		const FInputActionValue value = playerInput->GetActionValue(binding.Action);
+		if (!value.IsNonZero())
+			continue;
+		_bulkHandles.Add(binding._handle);
+		FInputEntry& entry = _bulkEntries.Add_GetRef(binding._entry);
+		entry.Axis = value.Get<FVector>();
+	}
+	if (_bulkHandles.Num() > 0)
+		_controller->ListenInputs(_bulkHandles, _bulkEntries);
+}
@@ -1,6 +1,7 @@
 // Copyright © 2023 by Tyni Boat. All Rights Reserved.
 
 #include "ComponentAndBase/ModularControllerComponent.h"
+#include "ComponentAndBase/ModularControllerSubsystem.h"
 
 #include <functional>
 #include "CoreTypes.h"
@@ -8,9 +9,11 @@
 #include "Animation/AnimInstance.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerState.h"
 #include "Engine.h"
 #include "Engine/World.h"
 #include "Net/UnrealNetwork.h"
+#include "Components/ShapeComponent.h"
 
 
 #pragma region Core and Constructor XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
@@ -40,6 +43,48 @@ void UModularControllerComponent::BeginPlay()
 		OnCalculateCustomPhysics.BindUObject(this, &UModularControllerComponent::SubstepTick);
 	}
 	Initialize();
+
+	//Batched update
+	_updateGroup = EvaluateUpdateGroup();
+	_lodFrameOffset = GetUniqueID();
+	if (bUseSubsystemUpdate)
+	{
+		if (UModularControllerSubsystem* subsystem = GetWorld()->GetSubsystem<UModularControllerSubsystem>())
+		{
+			if (APawn* pawn = _ownerPawn.Get())
+			{
+				pawn->ReceiveControllerChangedDelegate.AddUniqueDynamic(this, &UModularControllerComponent::OnOwnerControllerChanged);
+			}
+			subsystem->RegisterController(this);
+			SetComponentTickEnabled(false);
+		}
+	}
+}
+
+
+// Called when the game ends
+void UModularControllerComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	WakeUp();
+	if (UModularControllerSubsystem* subsystem = GetWorld() ? GetWorld()->GetSubsystem<UModularControllerSubsystem>() : nullptr)
+	{
+		subsystem->UnregisterController(this);
+	}
+	if (APawn* pawn = _ownerPawn.Get())
+	{
+		pawn->ReceiveControllerChangedDelegate.RemoveDynamic(this, &UModularControllerComponent::OnOwnerControllerChanged);
+	}
+	_stateRuntimes.Empty();
+	_actionRuntimes.Empty();
+	_behaviourRuntimes.Empty();
+	Super::EndPlay(EndPlayReason);
+}
+
+
+void UModularControllerComponent::SetUpdatedComponent(USceneComponent* NewUpdatedComponent)
+{
+	Super::SetUpdatedComponent(NewUpdatedComponent);
+	InvalidateTraceQueryCache();
 }
 
 
@@ -57,8 +102,12 @@ void UModularControllerComponent::Initialize()
 
 	//Inputs
 	_user_inputPool = NewObject<UInputEntryPool>(UInputEntryPool::StaticClass(), UInputEntryPool::StaticClass());
+	_user_inputPool->Reserve(UInputEntryPool::GetRegisteredInputCount());
+	_inputHistory.Initialize(InputHistoryDepth);
 
 	//State behaviors
+	for (UBaseControllerState* state : StatesInstances)
+		ReleaseBehaviourRuntime(state);
 	StatesInstances.Empty();
 	//if (GetNetRole() == ROLE_Authority)
 	{
@@ -66,7 +115,7 @@ void UModularControllerComponent::Initialize()
 		{
 			if (StateClasses[i] == nullptr)
 				continue;
-			UBaseControllerState* instance = NewObject<UBaseControllerState>(StateClasses[i], StateClasses[i]);
+			UBaseControllerState* instance = CreateStateInstance(StateClasses[i]);
 			StatesInstances.Add(instance);
 			//AddControllerState(StateClasses[i]);
 		}
@@ -78,6 +127,8 @@ void UModularControllerComponent::Initialize()
 	//}
 
 	//Action behaviors
+	for (UBaseControllerAction* action : ActionInstances)
+		ReleaseBehaviourRuntime(action);
 	ActionInstances.Empty();
 	//if (GetNetRole() == ROLE_Authority)
 	{
@@ -85,22 +136,24 @@ void UModularControllerComponent::Initialize()
 		{
 			if (ActionClasses[i] == nullptr)
 				continue;
-			UBaseControllerAction* instance = NewObject<UBaseControllerAction>(ActionClasses[i], ActionClasses[i]);
-			instance->InitializeAction();
+			UBaseControllerAction* instance = CreateActionInstance(ActionClasses[i]);
 			ActionInstances.Add(instance);
 			//AddControllerAction(ActionClasses[i]);
 		}
-		//ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+		ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
 	}
 	//else
 	//{
 	//	ServerRequestActions(this);
 	//}
+	BuildCompatibilityMasks();
+	ResetActionTimers();
 
 	//Init last move
 	LastMoveMade = FKinematicInfos(GetOwner()->GetActorTransform(), FVelocity(), FSurfaceInfos());
 	LastMoveMade.FinalTransform = LastMoveMade.InitialTransform;
 	LastMoveMade.FinalVelocities = LastMoveMade.InitialVelocities;
+	_previousMoveMade = LastMoveMade;
 	if (GetNetRole() == ROLE_Authority)
 	{
 		_lastCmdReceived.ToLocation = LastMoveMade.InitialTransform.GetLocation();
@@ -120,37 +173,73 @@ void UModularControllerComponent::MainUpdateComponent(float delta)
 	if (pawn == nullptr)
 		return;
 
+	switch (_updateGroup)
+	{
+	case ControllerUpdateGroup_StandAlone: {
+		if (SenseAndDecidePhase(delta))
+		{
+			IntegrationPhase();
+			CommitPhase();
+		}
+	}break;
+	case ControllerUpdateGroup_ListenServer: {
+		ListenServerUpdateComponent(delta);
+	}break;
+	case ControllerUpdateGroup_DedicatedServer: {
+		DedicatedServerUpdateComponent(delta);
+	}break;
+	case ControllerUpdateGroup_AutonomousProxy: {
+		AutonomousProxyUpdateComponent(delta);
+	}break;
+	default: {
+		SimulatedProxyUpdateComponent(delta);
+	}break;
+	}
+}
+
+
+EControllerUpdateGroup UModularControllerComponent::EvaluateUpdateGroup()
+{
 	if (GetNetMode() == ENetMode::NM_Standalone)
+		return ControllerUpdateGroup_StandAlone;
+
+	switch (GetNetRole())
 	{
-		const FVector moveInp = ConsumeMovementInput();
-		FKinematicInfos movement = FKinematicInfos(moveInp, GetGravity(), LastMoveMade, GetMass());
-		movement.bUsePhysic = bUsePhysicAuthority;
-		StandAloneUpdateComponent(moveInp, movement, _user_inputPool, delta);
-		LastMoveMade = movement;
+	case ENetRole::ROLE_Authority: {
+		const APawn* pawn = _ownerPawn.Get();
+		return pawn && pawn->IsLocallyControlled() ? ControllerUpdateGroup_ListenServer : ControllerUpdateGroup_DedicatedServer;
 	}
-	else
+	case ENetRole::ROLE_AutonomousProxy:
+		return ControllerUpdateGroup_AutonomousProxy;
+	default:
+		return ControllerUpdateGroup_SimulatedProxy;
+	}
+}
+
+
+void UModularControllerComponent::OnOwnerControllerChanged(APawn* pawn, AController* oldController, AController* newController)
+{
+	const EControllerUpdateGroup newGroup = EvaluateUpdateGroup();
+	if (newGroup == _updateGroup)
+		return;
+	WakeUp();
+	_updateGroup = newGroup;
+	if (UModularControllerSubsystem* subsystem = GetWorld()->GetSubsystem<UModularControllerSubsystem>())
 	{
-		ENetRole role = GetNetRole();
-		switch (role)
-		{
-		case ENetRole::ROLE_Authority: {
-			if (pawn->IsLocallyControlled())
-			{
-				ListenServerUpdateComponent(delta);
-			}
-			else
-			{
-				DedicatedServerUpdateComponent(delta);
-			}
-		}break;
-		case ENetRole::ROLE_AutonomousProxy: {
-			AutonomousProxyUpdateComponent(delta);
-		}break;
-		default: {
-			SimulatedProxyUpdateComponent(delta);
-		}break;
-		}
+		subsystem->MarkUpdateGroupsDirty();
+	}
+}
+
+
+void UModularControllerComponent::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	UModularControllerComponent* controller = CastChecked<UModularControllerComponent>(InThis);
+	for (auto& behaviourRuntime : controller->_behaviourRuntimes)
+	{
+		if (behaviourRuntime.Value.IsValid())
+			behaviourRuntime.Value->AddReferencedObjects(Collector, controller);
 	}
+	Super::AddReferencedObjects(InThis, Collector);
 }
 
 
@@ -158,28 +247,28 @@ void UModularControllerComponent::MainUpdateComponent(float delta)
 void UModularControllerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-	if (UpdatedPrimitive == nullptr)
-		return;
+	_updateGroup = EvaluateUpdateGroup();
+	UpdateComponent(DeltaTime);
+}
 
-	EvaluateRootMotions(DeltaTime);
 
-	if (UpdatedPrimitive->IsSimulatingPhysics())
-	{
-		UpdatedPrimitive->GetBodyInstance()->AddCustomPhysics(OnCalculateCustomPhysics);
-	}
-	else
+void UModularControllerComponent::UpdateComponent(float delta)
+{
+	if (BeginPhasedUpdate(delta))
 	{
-		MainUpdateComponent(DeltaTime);
+		do
+		{
+			IntegrationPhase();
+		} while (EndPhasedUpdate());
 	}
-
-	//Count time elapsed
-	_timeElapsed += DeltaTime;
+	FlushTransitionEvents();
 }
 
 
 
 FKinematicInfos UModularControllerComponent::StandAloneUpdateComponent(FVector movementInput, FKinematicInfos& movementInfos, UInputEntryPool* usedInputPool, float delta, bool noCollision)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_MovementDebug);
 	auto controllerStatus = EvaluateControllerStatus(movementInfos, movementInput, usedInputPool, delta);
 	FVelocity alteredMotion = ProcessStatus(controllerStatus, movementInfos, movementInput, usedInputPool, delta);
 
@@ -195,7 +284,7 @@ FKinematicInfos UModularControllerComponent::StandAloneUpdateComponent(FVector m
 	Move(movementInfos.FinalTransform.GetLocation(), movementInfos.FinalTransform.GetRotation(), delta);
 
 	movementInfos.FinalTransform.SetComponents(UpdatedPrimitive->GetComponentRotation().Quaternion(), UpdatedPrimitive->GetComponentLocation(), UpdatedPrimitive->GetComponentScale());
-	if (DebugType == ControllerDebugType_MovementDebug)
+	if (bDebug)
 	{
 		UKismetSystemLibrary::DrawDebugArrow(this, movementInfos.InitialTransform.GetLocation(), movementInfos.InitialTransform.GetLocation() + alteredMotion.ConstantLinearVelocity * 0.1f, 50, FColor::Magenta);
 		DrawCircle(GetWorld(), movementInfos.FinalTransform.GetLocation(), alteredMotion.Rotation.GetAxisX(), alteredMotion.Rotation.GetAxisY(), FColor::Magenta, 35, 32, false, -1, 0, 2);
@@ -255,114 +344,890 @@ FClientNetMoveCommand UModularControllerComponent::SimulateMoveCommand(FClientNe
 		movement.FinalVelocities._rooMotionScale = resultingMove._rooMotionScale;
 	}
 
-	result.FromLocation = movement.InitialTransform.GetLocation();
-	result.ToLocation = movement.FinalTransform.GetLocation();
+	result.FromLocation = movement.InitialTransform.GetLocation();
+	result.ToLocation = movement.FinalTransform.GetLocation();
+
+	result.FromRotation = movement.InitialTransform.GetRotation().Rotator();
+	result.ToRotation = movement.FinalTransform.GetRotation().Rotator();
+
+	result.ControllerStatus = controllerStatus;
+	result.ToVelocity = movement.FinalVelocities.ConstantLinearVelocity;
+
+	return result;
+}
+
+
+FStatusParameters UModularControllerComponent::EvaluateControllerStatus(FKinematicInfos kinematicInfos, FVector moveInput, UInputEntryPool* usedInputPool, float delta, FStatusParameters statusOverride, bool simulate, int simulatedInitialStateIndex, int simulatedInitialActionIndexes)
+{
+	//State
+	auto stateStatusInfos = statusOverride;
+	int initialState = simulatedInitialStateIndex >= 0 ? simulatedInitialStateIndex : CurrentStateIndex;
+	const auto stateIndex = CheckControllerStates(kinematicInfos, moveInput, usedInputPool, stateStatusInfos, delta, simulate);
+	int targetState = stateStatusInfos.StateIndex < 0 ? stateIndex : stateStatusInfos.StateIndex;
+	if (TryChangeControllerState(initialState, targetState, kinematicInfos, moveInput, delta, simulate))
+	{
+		stateStatusInfos.StateIndex = targetState;
+	}
+	else
+	{
+		stateStatusInfos.StateIndex = initialState;
+	}
+
+	//Actions
+	auto actionStatusInfos = statusOverride;
+	const int initialActionIndex = simulatedInitialActionIndexes >= 0 ? simulatedInitialActionIndexes : CurrentActionIndex;
+	const auto actionIndex = CheckControllerActions(kinematicInfos, moveInput, usedInputPool, stateStatusInfos.StateIndex, initialActionIndex, delta, actionStatusInfos, simulate);
+	const bool actionSelfTransition = statusOverride.PrimaryActionFlag > 0 ? true : (actionStatusInfos.PrimaryActionFlag > 0 ? true : false);
+	const int targetActionIndex = statusOverride.ActionIndex < 0 ? actionIndex : statusOverride.ActionIndex;
+	if (TryChangeControllerAction(initialActionIndex, targetActionIndex, kinematicInfos, moveInput, delta, actionStatusInfos, actionSelfTransition, simulate))
+	{
+		actionStatusInfos.ActionIndex = targetActionIndex;
+		if (actionSelfTransition)
+		{
+			actionStatusInfos.PrimaryActionFlag = 1;
+		}
+	}
+	else
+	{
+		actionStatusInfos.ActionIndex = initialActionIndex;
+	}
+
+	FStatusParameters statusInfos;
+	statusInfos.StateIndex = stateStatusInfos.StateIndex;
+	statusInfos.PrimaryStateFlag = stateStatusInfos.PrimaryStateFlag;
+	statusInfos.StateModifiers1 = stateStatusInfos.StateModifiers1;
+	statusInfos.StateModifiers2 = stateStatusInfos.StateModifiers2;
+
+	statusInfos.ActionIndex = actionStatusInfos.ActionIndex;
+	statusInfos.PrimaryActionFlag = actionStatusInfos.PrimaryActionFlag;
+	statusInfos.ActionsModifiers1 = actionStatusInfos.ActionsModifiers1;
+	statusInfos.ActionsModifiers2 = actionStatusInfos.ActionsModifiers2;
+	statusInfos.ActionVelocityConservation = actionStatusInfos.ActionVelocityConservation;
+
+	return statusInfos;
+}
+
+
+void UModularControllerComponent::ApplyControllerStatus(FKinematicInfos kinematicInfos, FVector moveInput, float delta, FStatusParameters status)
+{
+	//State
+	if (status.StateIndex >= 0)
+		TryChangeControllerState(CurrentStateIndex, status.StateIndex, kinematicInfos, moveInput, delta);
+
+	//Actions
+	_actionTimers.Clock += delta;
+	DispatchActionTimers();
+	FStatusParameters actionStatus = status;
+	TryChangeControllerAction(CurrentActionIndex, status.ActionIndex, kinematicInfos, moveInput, delta, actionStatus, status.PrimaryActionFlag > 0);
+}
+
+
+void UModularControllerComponent::EvaluateRemoteStatus(FKinematicInfos kinematicInfos, FVector moveInput, float delta, FStatusParameters status)
+{
+	if (!bStatusDrivenRemotes)
+	{
+		EvaluateControllerStatus(kinematicInfos, moveInput, GetRemoteInputPool(), delta, status);
+		return;
+	}
+
+	//The other states are not checked, only the applied one senses it's surface so it's surface infos stay up to date.
+	const int appliedStateIndex = status.StateIndex >= 0 ? status.StateIndex : CurrentStateIndex;
+	UInputEntryPool* inputs = GetRemoteInputPool();
+	if (StatesInstances.IsValidIndex(appliedStateIndex) && StatesInstances[appliedStateIndex] && inputs)
+	{
+		FStatusParameters sensedStatus = status;
+		StatesInstances[appliedStateIndex]->CheckState_Internal(_stateRuntimes[appliedStateIndex]->GetRef(), kinematicInfos, moveInput, inputs, this, sensedStatus, delta);
+	}
+	ApplyControllerStatus(kinematicInfos, moveInput, delta, status);
+}
+
+
+void UModularControllerComponent::ReceiveRemoteInputs(const FClientNetMoveCommand& command)
+{
+	if (!_remote_inputPool)
+	{
+		_remoteInputsReceived = NewObject<UInputEntryPool>(UInputEntryPool::StaticClass(), UInputEntryPool::StaticClass());
+		_remoteInputsBefore = NewObject<UInputEntryPool>(UInputEntryPool::StaticClass(), UInputEntryPool::StaticClass());
+		_remote_inputPool = NewObject<UInputEntryPool>(UInputEntryPool::StaticClass(), UInputEntryPool::StaticClass());
+		_remoteInputsReceived->Reserve(UInputEntryPool::GetRegisteredInputCount());
+		_remoteInputsBefore->Reserve(UInputEntryPool::GetRegisteredInputCount());
+		_remote_inputPool->Reserve(UInputEntryPool::GetRegisteredInputCount());
+	}
+
+	//Time stamps are on the remote user clock.
+	_remoteCommandInterval = _lastCmdReceived.TimeStamp > 0 && command.TimeStamp > _lastCmdReceived.TimeStamp ? command.TimeStamp - _lastCmdReceived.TimeStamp : 0;
+	_remoteMoveInputBefore = _lastCmdReceived.userMoveInput;
+	_remoteInputsBefore->CopyFrom(*_remoteInputsReceived);
+	if (command.Inputs.bIsSet)
+	{
+		command.Inputs.Apply(*_remoteInputsReceived);
+		if (ShouldSendInputs())
+		{
+			_inputsToSend.Inputs = command.Inputs.Inputs;
+			_inputsToSend.bIsSet = true;
+		}
+	}
+	_remote_inputPool->CopyFrom(*_remoteInputsReceived);
+	_lastCmdReceivedTime = _timeElapsed;
+	_remoteInputsFresh = true;
+}
+
+
+void UModularControllerComponent::PackInputsToSend(FClientNetMoveCommand& command)
+{
+	command.Inputs.bIsSet = false;
+	command.Inputs.Inputs.Reset();
+	if (!_inputsToSend.bIsSet || _inputsToSend.Equals(_inputsSent))
+		return;
+	_inputsSent.Inputs = _inputsToSend.Inputs;
+	_inputsSent.bIsSet = true;
+	command.Inputs = _inputsSent;
+}
+
+
+float UModularControllerComponent::GetRemoteExtrapolationTime()
+{
+	if (MaxRemoteExtrapolationTime <= 0 || _lastCmdReceivedTime <= 0)
+		return 0;
+
+	//The command was sent at least half a round trip ago.
+	if (UModularControllerSubsystem* subsystem = GetWorld() ? GetWorld()->GetSubsystem<UModularControllerSubsystem>() : nullptr)
+		_timeNetLatency = subsystem->GetLocalNetLatency();
+	return FMath::Clamp(_timeElapsed - _lastCmdReceivedTime + _timeNetLatency, 0.0, static_cast<double>(MaxRemoteExtrapolationTime));
+}
+
+
+FVector UModularControllerComponent::ExtrapolateRemoteInputs(float aheadTime)
+{
+	const FVector lastMoveInput = _lastCmdReceived.userMoveInput;
+	if (!_remote_inputPool)
+		return lastMoveInput;
+
+	_remote_inputPool->CopyFrom(*_remoteInputsReceived);
+	const bool fresh = _remoteInputsFresh;
+	_remoteInputsFresh = false;
+	if (fresh || aheadTime <= 0)
+		return lastMoveInput;
+
+	_remote_inputPool->PredictInputs(*_remoteInputsBefore, aheadTime, _remoteCommandInterval);
+	if (_remoteCommandInterval <= 0)
+		return lastMoveInput;
+	const FVector moveInput = lastMoveInput + (lastMoveInput - _remoteMoveInputBefore) * (aheadTime / _remoteCommandInterval);
+	return moveInput.GetClampedToMaxSize(FMath::Max(lastMoveInput.Length(), _remoteMoveInputBefore.Length()));
+}
+
+
+FVelocity UModularControllerComponent::ProcessStatus(FStatusParameters& inStatus,
+	FKinematicInfos kinematicInfos, FVector moveInput, UInputEntryPool* usedInputPool, float delta, int simulatedStateIndex, int simulatedActionIndexes)
+{
+	FKinematicInfos infos = kinematicInfos;
+	FVector savedActionStartVelocity = FVector(0);
+	bool saveActionVel = false;
+
+	//Handle action velocity conservation
+	{
+		if (inStatus.ActionVelocityConservation < 0)
+		{
+			//Save
+			saveActionVel = true;
+			savedActionStartVelocity = infos.InitialVelocities.ConstantLinearVelocity;
+		}
+		else if (inStatus.ActionVelocityConservation >= 0 && inStatus.ActionVelocityConservation <= 1)
+		{
+			//Load and reset
+			infos.InitialVelocities.ConstantLinearVelocity =
+				FMath::Lerp(infos.InitialVelocities.ActionStartLinearVelocity, infos.InitialVelocities.ConstantLinearVelocity, inStatus.ActionVelocityConservation);
+			saveActionVel = true;
+		}
+	}
+
+	FVelocity primaryMotion = ProcessControllerState(inStatus, infos, moveInput, delta, simulatedStateIndex);
+	//Surface movement
+	if(simulatedActionIndexes < 0 && simulatedStateIndex < 0)
+	{
+		if(GetCurrentSurface().GetSurfacePrimitive())
+		{
+			primaryMotion.InstantLinearVelocity += GetCurrentSurface().GetSurfaceLinearVelocity();
+			primaryMotion.Rotation *= GetCurrentSurface().GetSurfaceAngularVelocity();
+		}
+	}
+
+	FVelocity alteredMotion = ProcessControllerAction(inStatus, infos, primaryMotion, moveInput, delta, simulatedStateIndex, simulatedActionIndexes);
+	if (saveActionVel)
+		alteredMotion.ActionStartLinearVelocity = savedActionStartVelocity;
+	return  alteredMotion;
+}
+
+
+#pragma endregion
+
+
+
+#pragma region Update Phases XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+
+
+bool UModularControllerComponent::BeginPhasedUpdate(float delta)
+{
+	_phasedUpdate.bIsValid = false;
+	if (UpdatedPrimitive == nullptr || _isSleeping)
+		return false;
+	InvalidateTraceCache();
+
+	const bool locallySimulated = _updateGroup == ControllerUpdateGroup_StandAlone
+		|| _updateGroup == ControllerUpdateGroup_ListenServer
+		|| _updateGroup == ControllerUpdateGroup_AutonomousProxy;
+
+	if (UpdatedPrimitive->IsSimulatingPhysics())
+	{
+		EvaluateRootMotions(delta);
+		UpdatedPrimitive->GetBodyInstance()->AddCustomPhysics(OnCalculateCustomPhysics);
+	}
+	else if (!locallySimulated || _ownerPawn.Get() == nullptr)
+	{
+		EvaluateRootMotions(delta);
+		MainUpdateComponent(delta);
+		EvaluateSleep(delta);
+	}
+	else if (bUseFixedTimeStep)
+	{
+		_stepsRemaining = ConsumeFixedSteps(delta);
+		if (_stepsRemaining <= 0)
+		{
+			//Root motion keeps accumulating in the animation until a step consumes it.
+			InterpolateFixedSteps();
+			return false;
+		}
+		//The steps are simulated from the committed pose.
+		ClearVisualOffset();
+		EvaluateRootMotions(delta);
+		if (_stepsRemaining > 1)
+			ScaleRootMotions(1.0f / _stepsRemaining);
+		if (SenseAndDecidePhase(GetFixedStepDelta()))
+			return true;
+		_stepsRemaining = 0;
+		return false;
+	}
+	else
+	{
+		_stepsRemaining = 1;
+		ClearVisualOffset();
+		EvaluateRootMotions(delta);
+		if (SenseAndDecidePhase(delta))
+			return true;
+		_stepsRemaining = 0;
+	}
+
+	//Count time elapsed
+	_timeElapsed += delta;
+	return false;
+}
+
+
+bool UModularControllerComponent::SenseAndDecidePhase(float delta)
+{
+	_phasedUpdate.bIsValid = false;
+	_phasedUpdate.bCorrected = false;
+	_phasedUpdate.Delta = delta;
+	_phasedUpdate.PushedComponent = nullptr;
+
+	if (_updateGroup == ControllerUpdateGroup_AutonomousProxy)
+	{
+		if (!AutonomousProxyPrepareUpdate(_phasedUpdate.bCorrected))
+			return false;
+	}
+
+	const FVector moveInp = ConsumeMovementInput();
+	//Record the inputs as listened, before the behaviours consume them.
+	if (InputHistoryDepth > 0 && _user_inputPool)
+		_inputHistory.Record(_simulationFrame, moveInp, *_user_inputPool);
+	FKinematicInfos movement = FKinematicInfos(moveInp, GetGravity(), LastMoveMade, GetMass());
+	movement.bUsePhysic = bUsePhysicAuthority;
+
+	_asyncProbesAllowed = true;
+	_phasedUpdate.Status = EvaluateControllerStatus(movement, moveInp, _user_inputPool, delta);
+	_asyncProbesAllowed = false;
+	FVelocity alteredMotion = ProcessStatus(_phasedUpdate.Status, movement, moveInp, _user_inputPool, delta);
+	EvaluateRootMotionOverride(alteredMotion, movement, delta);
+	UpdateUserInputs(delta);
+
+	_phasedUpdate.MoveInput = moveInp;
+	_phasedUpdate.Movement = movement;
+	_phasedUpdate.AlteredMotion = alteredMotion;
+	_phasedUpdate.bIsValid = true;
+	return true;
+}
+
+
+void UModularControllerComponent::IntegrationPhase()
+{
+	if (!_phasedUpdate.bIsValid)
+		return;
+
+	const float delta = _phasedUpdate.Delta;
+	FVelocity& alteredMotion = _phasedUpdate.AlteredMotion;
+	alteredMotion.Rotation = HandleRotation(alteredMotion, _phasedUpdate.Movement, delta);
+
+	_deferPhysicInteractions = true;
+	FVelocity resultingMove = EvaluateMove(_phasedUpdate.Movement, alteredMotion, delta);
+	_deferPhysicInteractions = false;
+
+	//Prevent the client from moving through the obstacle the server collided with.
+	if (_updateGroup == ControllerUpdateGroup_AutonomousProxy && _lastCorrectionReceived.CollisionOccured)
+	{
+		const bool tryMoveThroughObstacle_Linear = FVector::DotProduct(resultingMove.ConstantLinearVelocity, _lastCorrectionReceived.CollisionNormal) <= 0;
+		if (tryMoveThroughObstacle_Linear)
+			resultingMove.ConstantLinearVelocity = FVector::VectorPlaneProject(resultingMove.ConstantLinearVelocity, _lastCorrectionReceived.CollisionNormal);
+
+		const bool tryMoveThroughObstacle_Instant = FVector::DotProduct(resultingMove.InstantLinearVelocity, _lastCorrectionReceived.CollisionNormal) <= 0;
+		if (tryMoveThroughObstacle_Instant)
+			resultingMove.InstantLinearVelocity = FVector::VectorPlaneProject(resultingMove.InstantLinearVelocity, _lastCorrectionReceived.CollisionNormal);
+	}
+
+	resultingMove._rooMotionScale = alteredMotion._rooMotionScale;
+	_phasedUpdate.ResultingMove = resultingMove;
+}
+
+
+void UModularControllerComponent::CommitPhase()
+{
+	const bool bDebug = IsDebugging(ControllerDebugType_MovementDebug);
+	if (!_phasedUpdate.bIsValid)
+		return;
+	_phasedUpdate.bIsValid = false;
+
+	const float delta = _phasedUpdate.Delta;
+	FKinematicInfos& movement = _phasedUpdate.Movement;
+
+	//Push objects around
+	if (UPrimitiveComponent* pushed = _phasedUpdate.PushedComponent.Get())
+	{
+		if (pushed->IsSimulatingPhysics())
+			pushed->AddForceAtLocation(_phasedUpdate.PushForce, _phasedUpdate.PushLocation, _phasedUpdate.PushBoneName);
+		_phasedUpdate.PushedComponent = nullptr;
+	}
+
+	PostMoveUpdate(movement, _phasedUpdate.ResultingMove, CurrentStateIndex, delta);
+
+	//Move
+	{
+		TGuardValue<bool> movingSelf(_isMovingSelf, true);
+		if (_updateGroup != ControllerUpdateGroup_AutonomousProxy || bUseClientAuthorative)
+		{
+			Move(movement.FinalTransform.GetLocation(), movement.FinalTransform.GetRotation(), delta);
+			InvalidateTraceCache();
+			movement.FinalTransform.SetComponents(UpdatedPrimitive->GetComponentRotation().Quaternion(), UpdatedPrimitive->GetComponentLocation(), UpdatedPrimitive->GetComponentScale());
+		}
+		else
+		{
+			const FVector lerpPos = FMath::Lerp(UpdatedComponent->GetComponentLocation(), movement.FinalTransform.GetLocation(), delta * AdjustmentSpeed);
+			const FQuat slerpRot = FQuat::Slerp(UpdatedComponent->GetComponentQuat(), movement.FinalTransform.GetRotation(), delta * AdjustmentSpeed);
+			UpdatedComponent->SetWorldLocationAndRotation(lerpPos, slerpRot);
+			InvalidateTraceCache();
+		}
+	}
+
+	if (bDebug)
+	{
+		const FVelocity& alteredMotion = _phasedUpdate.AlteredMotion;
+		UKismetSystemLibrary::DrawDebugArrow(this, movement.InitialTransform.GetLocation(), movement.InitialTransform.GetLocation() + alteredMotion.ConstantLinearVelocity * 0.1f, 50, FColor::Magenta);
+		DrawCircle(GetWorld(), movement.FinalTransform.GetLocation(), alteredMotion.Rotation.GetAxisX(), alteredMotion.Rotation.GetAxisY(), FColor::Magenta, 35, 32, false, -1, 0, 2);
+	}
+
+	_previousMoveMade = LastMoveMade;
+	LastMoveMade = movement;
+	if (SnapShotHistoryDepth > 0)
+		RecordBehavioursFrame(_simulationFrame);
+	_simulationFrame++;
+
+	//Network
+	switch (_updateGroup)
+	{
+	case ControllerUpdateGroup_ListenServer:
+		ListenServerSendCommand(delta);
+		break;
+	case ControllerUpdateGroup_AutonomousProxy:
+		AutonomousProxySendCommand(delta);
+		break;
+	default:
+		break;
+	}
+}
+
+
+bool UModularControllerComponent::EndPhasedUpdate()
+{
+	CommitPhase();
+
+	//Count time elapsed
+	const float stepDelta = _phasedUpdate.Delta;
+	_timeElapsed += stepDelta;
+
+	EvaluateSleep(stepDelta);
+
+	//Next step
+	_stepsRemaining--;
+	if (_stepsRemaining > 0 && !_isSleeping && SenseAndDecidePhase(stepDelta))
+		return true;
+	_stepsRemaining = 0;
+
+	if (bUseFixedTimeStep)
+		InterpolateFixedSteps();
+	return false;
+}
+
+
+void UModularControllerComponent::QueueTransitionEvent(bool isAction, UObject* newBehaviour, UObject* oldBehaviour)
+{
+	if (bCoalesceTransitionEvents)
+	{
+		for (int i = _pendingTransitions.Num() - 1; i >= 0; i--)
+		{
+			if (_pendingTransitions[i].bIsAction != isAction)
+				continue;
+			//Keep the first origin, back to it means nothing changed.
+			if (_pendingTransitions[i].OldBehaviour == newBehaviour)
+			{
+				_pendingTransitions.RemoveAt(i);
+				return;
+			}
+			_pendingTransitions[i].NewBehaviour = newBehaviour;
+			return;
+		}
+	}
+
+	FBehaviourTransitionEvent& transition = _pendingTransitions.AddDefaulted_GetRef();
+	transition.bIsAction = isAction;
+	transition.NewBehaviour = newBehaviour;
+	transition.OldBehaviour = oldBehaviour;
+}
+
+
+void UModularControllerComponent::FlushTransitionEvents()
+{
+	if (_pendingTransitions.Num() <= 0)
+		return;
+
+	// Listeners can transition again, so no ranged for here.
+	for (int i = 0; i < _pendingTransitions.Num(); i++)
+	{
+		const FBehaviourTransitionEvent transition = _pendingTransitions[i];
+		if (transition.bIsAction)
+		{
+			UBaseControllerAction* newAction = Cast<UBaseControllerAction>(transition.NewBehaviour);
+			UBaseControllerAction* oldAction = Cast<UBaseControllerAction>(transition.OldBehaviour);
+			for (int j = 0; j < StatesInstances.Num(); j++)
+			{
+				StatesInstances[j]->OnActionChanged(_stateRuntimes[j]->GetRef(), newAction, oldAction);
+			}
+			for (int j = 0; j < ActionInstances.Num(); j++)
+			{
+				ActionInstances[j]->OnActionChanged(_actionRuntimes[j]->GetRef(), newAction, oldAction);
+			}
+			OnControllerActionChanged(newAction, oldAction);
+			OnControllerActionChangedEvent.Broadcast(newAction, oldAction);
+		}
+		else
+		{
+			UBaseControllerState* newState = Cast<UBaseControllerState>(transition.NewBehaviour);
+			UBaseControllerState* oldState = Cast<UBaseControllerState>(transition.OldBehaviour);
+			const FName newStateName = newState ? newState->GetDescriptionName() : "";
+			const int newStatePriority = newState ? newState->GetPriority() : -1;
+			for (int j = 0; j < StatesInstances.Num(); j++)
+			{
+				if (StatesInstances[j] == newState)
+					continue;
+				StatesInstances[j]->OnControllerStateChanged(_stateRuntimes[j]->GetRef(), newStateName, newStatePriority, this);
+			}
+			OnControllerStateChanged(newState, oldState);
+			OnControllerStateChangedEvent.Broadcast(newState, oldState);
+			//Notify actions the change of state
+			for (int j = 0; j < ActionInstances.Num(); j++)
+			{
+				ActionInstances[j]->OnStateChanged(_actionRuntimes[j]->GetRef(), newState, oldState);
+			}
+		}
+	}
+	_pendingTransitions.Reset();
+}
+
+
+#pragma region Fixed Time Step
+
+
+int UModularControllerComponent::ConsumeFixedSteps(float delta)
+{
+	const float stepDelta = GetFixedStepDelta();
+	_fixedStepAccumulator += delta;
+
+	int steps = FMath::FloorToInt(_fixedStepAccumulator / stepDelta);
+	if (steps > MaxFixedStepsPerFrame)
+	{
+		//Drop the time we can't catch up with, rather than spiraling.
+		steps = FMath::Max(MaxFixedStepsPerFrame, 1);
+		_fixedStepAccumulator = FMath::Fmod(_fixedStepAccumulator, stepDelta);
+	}
+	else
+	{
+		_fixedStepAccumulator -= steps * stepDelta;
+	}
+	return steps;
+}
+
+
+void UModularControllerComponent::ScaleRootMotions(float scale)
+{
+	for (auto& entry : _RootMotionParams)
+	{
+		FTransform& rootMotion = entry.Value;
+		rootMotion.SetTranslation(rootMotion.GetTranslation() * scale);
+		rootMotion.SetRotation(FQuat::Slerp(FQuat::Identity, rootMotion.GetRotation(), scale));
+	}
+}
+
+
+void UModularControllerComponent::InterpolateFixedSteps()
+{
+	if (UpdatedPrimitive == nullptr || UpdatedPrimitive->IsSimulatingPhysics())
+		return;
+
+	//The autonomous proxy already smooth toward the simulation when not authoritative.
+	if (_updateGroup == ControllerUpdateGroup_AutonomousProxy && !bUseClientAuthorative)
+		return;
+
+	//Nothing to see on a dedicated server.
+	if (GetNetMode() == NM_DedicatedServer)
+		return;
+
+	const float alpha = FMath::Clamp(_fixedStepAccumulator / GetFixedStepDelta(), 0.0f, 1.0f);
+	const FVector location = FMath::Lerp(_previousMoveMade.FinalTransform.GetLocation(), LastMoveMade.FinalTransform.GetLocation(), alpha);
+	const FQuat rotation = FQuat::Slerp(_previousMoveMade.FinalTransform.GetRotation(), LastMoveMade.FinalTransform.GetRotation(), alpha);
+	SetVisualOffset(location, rotation);
+}
+
+
+USceneComponent* UModularControllerComponent::GetVisualComponent()
+{
+	USceneComponent* visual = Cast<USceneComponent>(VisualComponent.GetComponent(GetOwner()));
+	if (visual == nullptr)
+		visual = GetSkeletalMesh();
+	//Anywhere in the attach hierarchy of the updated primitive.
+	if (visual == nullptr || UpdatedPrimitive == nullptr || visual == UpdatedPrimitive || !visual->IsAttachedTo(UpdatedPrimitive))
+		return nullptr;
+	return visual;
+}
+
+
+void UModularControllerComponent::SetVisualOffset(const FVector& location, const FQuat& rotation)
+{
+	USceneComponent* visual = _offsetVisual.Get();
+	if (visual == nullptr)
+	{
+		visual = GetVisualComponent();
+		if (visual == nullptr)
+			return;
+		_offsetVisual = visual;
+		_visualRelativeTransform = visual->GetRelativeTransform();
+		_visualPrimitiveTransform = visual->GetComponentTransform().GetRelativeTransform(UpdatedPrimitive->GetComponentTransform());
+	}
+
+	const FTransform visualPose = _visualPrimitiveTransform * FTransform(rotation, location, UpdatedPrimitive->GetComponentScale());
+	visual->SetWorldLocationAndRotation(visualPose.GetLocation(), visualPose.GetRotation());
+}
+
+
+void UModularControllerComponent::ClearVisualOffset()
+{
+	USceneComponent* visual = _offsetVisual.Get();
+	_offsetVisual = nullptr;
+	if (visual)
+		visual->SetRelativeTransform(_visualRelativeTransform);
+}
+
+
+#pragma endregion
+
+
+#pragma region Update LOD
+
+
+EControllerUpdateTier UModularControllerComponent::GetUpdateTierForDistance(const float viewerDistance) const
+{
+	int tier = ControllerUpdateTier_EveryFrame;
+	for (int i = 0; i < UpdateTierDistances.Num() && tier < ControllerUpdateTier_InterpolateOnly; i++)
+	{
+		if (viewerDistance < UpdateTierDistances[i])
+			break;
+		tier++;
+	}
+	return static_cast<EControllerUpdateTier>(tier);
+}
+
+
+void UModularControllerComponent::SetUpdateTier(EControllerUpdateTier tier)
+{
+	if (!bUseUpdateLOD)
+	{
+		tier = ControllerUpdateTier_EveryFrame;
+	}
+	else if (_updateGroup == ControllerUpdateGroup_AutonomousProxy || _updateGroup == ControllerUpdateGroup_DedicatedServer)
+	{
+		//Local player and remote players commands on the server.
+		tier = ControllerUpdateTier_EveryFrame;
+	}
+	else if (_updateGroup != ControllerUpdateGroup_SimulatedProxy)
+	{
+		const APawn* pawn = _ownerPawn.Get();
+		if (pawn && pawn->IsPlayerControlled())
+			tier = ControllerUpdateTier_EveryFrame;
+	}
+
+	//Simulated proxies can't catch up the time skipped on the previous tier, their next status is evaluated from the new tier only.
+	if (tier != _updateTier && _updateGroup == ControllerUpdateGroup_SimulatedProxy)
+		_lodAccumulatedDelta = 0;
+	_updateTier = tier;
+}
+
+
+bool UModularControllerComponent::IsUpdateFrame(const uint32 frameCounter) const
+{
+	uint32 period = 1;
+	switch (_updateTier)
+	{
+	case ControllerUpdateTier_EverySecondFrame:
+		period = 2;
+		break;
+	case ControllerUpdateTier_EveryFourthFrame:
+		period = 4;
+		break;
+	case ControllerUpdateTier_EveryEighthFrame:
+		period = 8;
+		break;
+	case ControllerUpdateTier_InterpolateOnly:
+		//Only simulated proxies can just interpolate, locally simulated controllers must still move.
+		if (_updateGroup == ControllerUpdateGroup_SimulatedProxy)
+			return false;
+		period = 8;
+		break;
+	default:
+		return true;
+	}
+	return ((frameCounter + _lodFrameOffset) % period) == 0;
+}
+
+
+float UModularControllerComponent::ConsumeUpdateDelta(float delta)
+{
+	//Simulated proxies interpolate on every frames and only consume the accumulated time on their status.
+	if (_updateGroup == ControllerUpdateGroup_SimulatedProxy)
+		return delta;
+	const float totalDelta = delta + _lodAccumulatedDelta;
+	_lodAccumulatedDelta = 0;
+	return totalDelta;
+}
+
+
+void UModularControllerComponent::SkipUpdateFrame(float delta)
+{
+	if (UpdatedPrimitive == nullptr)
+		return;
+	_lodAccumulatedDelta = FMath::Min(_lodAccumulatedDelta + delta, FMath::Max(MaxSkippedFramesTime, 0.f));
+
+	if (_updateGroup == ControllerUpdateGroup_SimulatedProxy)
+	{
+		SimulatedProxyUpdateComponent(delta, false);
+		_timeElapsed += delta;
+		return;
+	}
+
+	//Extrapolate the last move for the viewers, on the visual only. The collision stays where the last move left it, and the next simulation starts from there.
+	if (GetNetMode() == NM_DedicatedServer || UpdatedPrimitive->IsSimulatingPhysics())
+		return;
+	const FVector extrapolated = LastMoveMade.FinalTransform.GetLocation() + LastMoveMade.FinalVelocities.ConstantLinearVelocity * _lodAccumulatedDelta;
+	SetVisualOffset(extrapolated, LastMoveMade.FinalTransform.GetRotation());
+}
+
+
+#pragma endregion
+
+
+#pragma region Sleep
+
+
+bool UModularControllerComponent::IsIdle() const
+{
+	if (UpdatedPrimitive == nullptr || UpdatedPrimitive->IsSimulatingPhysics())
+		return false;
+	if (CurrentActionIndex >= 0)
+		return false;
+
+	switch (_updateGroup)
+	{
+	case ControllerUpdateGroup_DedicatedServer:
+		//Driven by the client's commands.
+		return false;
+	case ControllerUpdateGroup_SimulatedProxy:
+		return _lastCmdReceived.WithVelocity.IsNearlyZero()
+			&& UpdatedPrimitive->GetComponentLocation().Equals(_lastCmdReceived.ToLocation, 1)
+			&& UpdatedPrimitive->GetComponentQuat().Equals(_lastCmdReceived.ToRotation.Quaternion(), 0.001);
+	default:
+		break;
+	}
+
+	//Inputs
+	if (_user_inputPool && _user_inputPool->HasActiveInputs())
+		return false;
+	if (!LastMoveMade.UserMoveVector.IsNearlyZero())
+		return false;
+	if (_userMoveDirectionHistory.Num() > 0 && !FVector(_userMoveDirectionHistory.Last()).IsNearlyZero())
+		return false;
+
+	//Motion
+	if (!_collisionForces.IsNearlyZero())
+		return false;
+	if (!LastMoveMade.FinalVelocities.ConstantLinearVelocity.IsNearlyZero(1) || !LastMoveMade.FinalVelocities.InstantLinearVelocity.IsNearlyZero(1))
+		return false;
+	if (!LastMoveMade.InitialTransform.GetRotation().Equals(LastMoveMade.FinalTransform.GetRotation(), 0.001))
+		return false;
+
+	//Surface
+	const FSurfaceInfos surface = GetCurrentSurface();
+	if (!surface.GetSurfaceLinearVelocity().IsNearlyZero() || !surface.GetSurfaceAngularVelocity().Equals(FQuat::Identity, 0.001))
+		return false;
+
+	return true;
+}
+
+
+void UModularControllerComponent::EvaluateSleep(float delta)
+{
+	if (!bCanSleep || _isSleeping)
+		return;
+	if (!IsIdle())
+	{
+		_idleTime = 0;
+		return;
+	}
+	_idleTime += delta;
+	if (_idleTime >= SleepDelay)
+		FallAsleep();
+}
+
 
-	result.FromRotation = movement.InitialTransform.GetRotation().Rotator();
-	result.ToRotation = movement.FinalTransform.GetRotation().Rotator();
+void UModularControllerComponent::FallAsleep()
+{
+	ClearVisualOffset();
+	_isSleeping = true;
+	_idleTime = 0;
+	_sleepStartTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0;
 
-	result.ControllerStatus = controllerStatus;
-	result.ToVelocity = movement.FinalVelocities.ConstantLinearVelocity;
+	//Not updated by the subsystem, stop ticking.
+	if (IsComponentTickEnabled())
+	{
+		SetComponentTickEnabled(false);
+		_tickDisabledBySleep = true;
+	}
 
-	return result;
+	//Moving, destroyed surfaces and external moves wake the controller up.
+	_sleepSurface = GetCurrentSurface().GetSurfacePrimitive();
+	_sleepSurfaceSimulating = false;
+	if (UPrimitiveComponent* surface = _sleepSurface.Get())
+	{
+		_sleepSurfaceSimulating = surface->IsSimulatingPhysics();
+		surface->TransformUpdated.AddUObject(this, &UModularControllerComponent::OnSleepWatchedComponentMoved);
+		surface->OnComponentPhysicsStateChanged.AddUniqueDynamic(this, &UModularControllerComponent::OnSleepSurfacePhysicsStateChanged);
+		if (AActor* surfaceActor = surface->GetOwner())
+			surfaceActor->OnDestroyed.AddUniqueDynamic(this, &UModularControllerComponent::OnSleepSurfaceActorDestroyed);
+	}
+	if (UpdatedPrimitive)
+	{
+		UpdatedPrimitive->TransformUpdated.AddUObject(this, &UModularControllerComponent::OnSleepWatchedComponentMoved);
+	}
+
+	if (IsDebugEnabled())
+	{
+		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Controller %s fell asleep"), *GetOwner()->GetActorNameOrLabel()), true, true, FColor::Silver, 2, TEXT("Sleep_"));
+	}
 }
 
 
-FStatusParameters UModularControllerComponent::EvaluateControllerStatus(FKinematicInfos kinematicInfos, FVector moveInput, UInputEntryPool* usedInputPool, float delta, FStatusParameters statusOverride, bool simulate, int simulatedInitialStateIndex, int simulatedInitialActionIndexes)
+void UModularControllerComponent::WakeUp()
 {
-	//State
-	auto stateStatusInfos = statusOverride;
-	int initialState = simulatedInitialStateIndex >= 0 ? simulatedInitialStateIndex : CurrentStateIndex;
-	const auto stateIndex = CheckControllerStates(kinematicInfos, moveInput, usedInputPool, stateStatusInfos, delta, simulate);
-	int targetState = stateStatusInfos.StateIndex < 0 ? stateIndex : stateStatusInfos.StateIndex;
-	if (TryChangeControllerState(initialState, targetState, kinematicInfos, moveInput, delta, simulate))
+	if (!_isSleeping)
+		return;
+	_isSleeping = false;
+	_idleTime = 0;
+
+	if (UPrimitiveComponent* surface = _sleepSurface.Get())
 	{
-		stateStatusInfos.StateIndex = targetState;
+		surface->TransformUpdated.RemoveAll(this);
+		surface->OnComponentPhysicsStateChanged.RemoveDynamic(this, &UModularControllerComponent::OnSleepSurfacePhysicsStateChanged);
+		if (AActor* surfaceActor = surface->GetOwner())
+			surfaceActor->OnDestroyed.RemoveDynamic(this, &UModularControllerComponent::OnSleepSurfaceActorDestroyed);
 	}
-	else
+	_sleepSurface = nullptr;
+	if (UpdatedPrimitive)
 	{
-		stateStatusInfos.StateIndex = initialState;
+		UpdatedPrimitive->TransformUpdated.RemoveAll(this);
 	}
 
-	//Actions
-	auto actionStatusInfos = statusOverride;
-	const int initialActionIndex = simulatedInitialActionIndexes >= 0 ? simulatedInitialActionIndexes : CurrentActionIndex;
-	const auto actionIndex = CheckControllerActions(kinematicInfos, moveInput, usedInputPool, stateStatusInfos.StateIndex, initialActionIndex, delta, actionStatusInfos, simulate);
-	const bool actionSelfTransition = statusOverride.PrimaryActionFlag > 0 ? true : (actionStatusInfos.PrimaryActionFlag > 0 ? true : false);
-	const int targetActionIndex = statusOverride.ActionIndex < 0 ? actionIndex : statusOverride.ActionIndex;
-	if (TryChangeControllerAction(initialActionIndex, targetActionIndex, kinematicInfos, moveInput, delta, actionStatusInfos, actionSelfTransition, simulate))
+	//Catch up the time slept, without simulating it.
+	if (GetWorld())
 	{
-		actionStatusInfos.ActionIndex = targetActionIndex;
-		if (actionSelfTransition)
-		{
-			actionStatusInfos.PrimaryActionFlag = 1;
-		}
+		_timeElapsed += GetWorld()->GetTimeSeconds() - _sleepStartTime;
 	}
-	else
+	_fixedStepAccumulator = 0;
+	_lodAccumulatedDelta = 0;
+
+	if (_tickDisabledBySleep)
 	{
-		actionStatusInfos.ActionIndex = initialActionIndex;
+		_tickDisabledBySleep = false;
+		SetComponentTickEnabled(true);
 	}
+}
 
-	FStatusParameters statusInfos;
-	statusInfos.StateIndex = stateStatusInfos.StateIndex;
-	statusInfos.PrimaryStateFlag = stateStatusInfos.PrimaryStateFlag;
-	statusInfos.StateModifiers1 = stateStatusInfos.StateModifiers1;
-	statusInfos.StateModifiers2 = stateStatusInfos.StateModifiers2;
 
-	statusInfos.ActionIndex = actionStatusInfos.ActionIndex;
-	statusInfos.PrimaryActionFlag = actionStatusInfos.PrimaryActionFlag;
-	statusInfos.ActionsModifiers1 = actionStatusInfos.ActionsModifiers1;
-	statusInfos.ActionsModifiers2 = actionStatusInfos.ActionsModifiers2;
-	statusInfos.ActionVelocityConservation = actionStatusInfos.ActionVelocityConservation;
+void UModularControllerComponent::OnSleepWatchedComponentMoved(USceneComponent* movedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (movedComponent != nullptr && movedComponent == UpdatedPrimitive && _isMovingSelf)
+		return;
 
-	return statusInfos;
+	//The controller was moved from outside, start from there.
+	if (movedComponent != nullptr && movedComponent == UpdatedPrimitive)
+	{
+		LastMoveMade.FinalTransform.SetComponents(UpdatedPrimitive->GetComponentQuat(), UpdatedPrimitive->GetComponentLocation(), UpdatedPrimitive->GetComponentScale());
+		_previousMoveMade = LastMoveMade;
+	}
+	WakeUp();
 }
 
 
-FVelocity UModularControllerComponent::ProcessStatus(FStatusParameters& inStatus,
-	FKinematicInfos kinematicInfos, FVector moveInput, UInputEntryPool* usedInputPool, float delta, int simulatedStateIndex, int simulatedActionIndexes)
+void UModularControllerComponent::OnSleepSurfacePhysicsStateChanged(UPrimitiveComponent* ChangedComponent, EComponentPhysicsStateChange StateChange)
 {
-	FKinematicInfos infos = kinematicInfos;
-	FVector savedActionStartVelocity = FVector(0);
-	bool saveActionVel = false;
+	if (StateChange == EComponentPhysicsStateChange::Destroyed)
+		WakeUp();
+}
 
-	//Handle action velocity conservation
-	{
-		if (inStatus.ActionVelocityConservation < 0)
-		{
-			//Save
-			saveActionVel = true;
-			savedActionStartVelocity = infos.InitialVelocities.ConstantLinearVelocity;
-		}
-		else if (inStatus.ActionVelocityConservation >= 0 && inStatus.ActionVelocityConservation <= 1)
-		{
-			//Load and reset
-			infos.InitialVelocities.ConstantLinearVelocity =
-				FMath::Lerp(infos.InitialVelocities.ActionStartLinearVelocity, infos.InitialVelocities.ConstantLinearVelocity, inStatus.ActionVelocityConservation);
-			saveActionVel = true;
-		}
-	}
 
-	FVelocity primaryMotion = ProcessControllerState(inStatus, infos, moveInput, delta, simulatedStateIndex);
-	//Surface movement
-	if(simulatedActionIndexes < 0 && simulatedStateIndex < 0)
-	{
-		if(GetCurrentSurface().GetSurfacePrimitive())
-		{
-			primaryMotion.InstantLinearVelocity += GetCurrentSurface().GetSurfaceLinearVelocity();
-			primaryMotion.Rotation *= GetCurrentSurface().GetSurfaceAngularVelocity();
-		}
-	}
+void UModularControllerComponent::OnSleepSurfaceActorDestroyed(AActor* DestroyedActor)
+{
+	WakeUp();
+}
 
-	FVelocity alteredMotion = ProcessControllerAction(inStatus, infos, primaryMotion, moveInput, delta, simulatedStateIndex, simulatedActionIndexes);
-	if (saveActionVel)
-		alteredMotion.ActionStartLinearVelocity = savedActionStartVelocity;
-	return  alteredMotion;
+
+void UModularControllerComponent::ValidateSleepSurface()
+{
+	if (!_isSleeping || _sleepSurface.IsExplicitlyNull())
+		return;
+	const UPrimitiveComponent* surface = _sleepSurface.Get();
+	if (surface == nullptr || !IsValid(surface) || surface->IsSimulatingPhysics() != _sleepSurfaceSimulating)
+		WakeUp();
 }
 
 
 #pragma endregion
 
+#pragma endregion
+
 
 
 #pragma region Input Handling XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
@@ -372,19 +1237,51 @@ void UModularControllerComponent::MovementInput(FVector movement)
 {
 	FVector normalisationTester = movement;
 	if (normalisationTester.Normalize())
+	{
+		WakeUp();
 		_userMoveDirectionHistory.Add(movement.GetClampedToMaxSize(1));
-	else
+	}
+	else if (!_isSleeping)
 		_userMoveDirectionHistory.Add(FVector(0));
 }
 
 void UModularControllerComponent::ListenInput(const FName key, const FInputEntry entry)
+{
+	ListenInput(UInputEntryPool::RegisterInput(key), entry);
+}
+
+void UModularControllerComponent::ListenInput(const int32 handle, const FInputEntry entry)
 {
 	if (_ownerPawn == nullptr)
 		return;
 	if (!_ownerPawn->IsLocallyControlled())
 		return;
+	if (handle < 0)
+		return;
+	WakeUp();
 	if (_user_inputPool)
-		_user_inputPool->AddOrReplace(key, entry);
+		_user_inputPool->AddOrReplace(handle, entry);
+}
+
+void UModularControllerComponent::ListenInputs(TArrayView<const int32> handles, TArrayView<const FInputEntry> entries)
+{
+	if (_ownerPawn == nullptr)
+		return;
+	if (!_ownerPawn->IsLocallyControlled())
+		return;
+	if (!_user_inputPool)
+		return;
+	bool listened = false;
+	const int32 count = FMath::Min(handles.Num(), entries.Num());
+	for (int32 i = 0; i < count; i++)
+	{
+		if (handles[i] < 0)
+			continue;
+		_user_inputPool->AddOrReplace(handles[i], entries[i]);
+		listened = true;
+	}
+	if (listened)
+		WakeUp();
 }
 
 void UModularControllerComponent::ListenButtonInput(const FName key, const float buttonBufferTime)
@@ -418,15 +1315,43 @@ void UModularControllerComponent::ListenAxisInput(const FName key, const FVector
 	ListenInput(key, entry);
 }
 
+void UModularControllerComponent::ListenAxisInputs(const TArray<FName>& keys, const TArray<FVector>& axes)
+{
+	if (_ownerPawn == nullptr)
+		return;
+	if (!_ownerPawn->IsLocallyControlled())
+		return;
+	if (!_user_inputPool)
+		return;
+	bool listened = false;
+	FInputEntry entry;
+	entry.Nature = EInputEntryNature::InputEntryNature_Axis;
+	const int32 count = FMath::Min(keys.Num(), axes.Num());
+	for (int32 i = 0; i < count; i++)
+	{
+		entry.Axis = axes[i];
+		listened |= _user_inputPool->AddOrReplace(UInputEntryPool::RegisterInput(keys[i]), entry);
+	}
+	if (listened)
+		WakeUp();
+}
 
 
+
+void UModularControllerComponent::UpdateUserInputs(float delta)
+{
+	if (_user_inputPool)
+		_user_inputPool->UpdateInputs(delta);
+}
+
 FVector UModularControllerComponent::ConsumeMovementInput()
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_InputDebug);
 	if (_userMoveDirectionHistory.Num() < 2)
 		return FVector(0);
 	const FVector move = _userMoveDirectionHistory[0];
 	_userMoveDirectionHistory.RemoveAt(0);
-	if (DebugType == ControllerDebugType_InputDebug)
+	if (bDebug)
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Consumed Move Input: %s"), *move.ToCompactString()), true, true, FColor::Silver, 0, "MoveInput_");
 	}
@@ -435,30 +1360,34 @@ FVector UModularControllerComponent::ConsumeMovementInput()
 
 FInputEntry UModularControllerComponent::ReadInput(const FName key, bool consume, bool debug, UObject* worldContext)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_InputDebug);
 	if (debug && !worldContext)
 		worldContext = GetWorld();
 	if (!_user_inputPool)
 		return {};
 	if (consume)
-		return _user_inputPool->ConsumeInput(key, debug && DebugType == ControllerDebugType_InputDebug, worldContext);
-	return _user_inputPool->ReadInput(key, debug && DebugType == ControllerDebugType_InputDebug, worldContext);
+		return _user_inputPool->ConsumeInput(key, debug && bDebug, worldContext);
+	return _user_inputPool->ReadInput(key, debug && bDebug, worldContext);
 }
 
 bool UModularControllerComponent::ReadButtonInput(const FName key, bool consume, bool debug, UObject* worldContext)
 {
-	const FInputEntry entry = ReadInput(key, consume, debug && DebugType == ControllerDebugType_InputDebug, worldContext);
+	const bool bDebug = IsDebugging(ControllerDebugType_InputDebug);
+	const FInputEntry entry = ReadInput(key, consume, debug && bDebug, worldContext);
 	return entry.Phase == EInputEntryPhase::InputEntryPhase_Held || entry.Phase == EInputEntryPhase::InputEntryPhase_Pressed;
 }
 
 float UModularControllerComponent::ReadValueInput(const FName key, bool consume, bool debug, UObject* worldContext)
 {
-	const FInputEntry entry = ReadInput(key, consume, debug && DebugType == ControllerDebugType_InputDebug, worldContext);
+	const bool bDebug = IsDebugging(ControllerDebugType_InputDebug);
+	const FInputEntry entry = ReadInput(key, consume, debug && bDebug, worldContext);
 	return entry.Axis.X;
 }
 
 FVector UModularControllerComponent::ReadAxisInput(const FName key, bool consume, bool debug, UObject* worldContext)
 {
-	const FInputEntry entry = ReadInput(key, consume, debug && DebugType == ControllerDebugType_InputDebug, worldContext);
+	const bool bDebug = IsDebugging(ControllerDebugType_InputDebug);
+	const FInputEntry entry = ReadInput(key, consume, debug && bDebug, worldContext);
 	return entry.Axis;
 }
 
@@ -521,6 +1450,8 @@ FName UModularControllerComponent::GetNetRoleDebug(ENetRole role)
 
 void UModularControllerComponent::MultiCastMoveCommand_Implementation(FClientNetMoveCommand command, FServerNetCorrectionData Correction, bool asCorrection)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
+	WakeUp();
 	const ENetRole role = GetNetRole();
 	switch (role)
 	{
@@ -532,7 +1463,7 @@ void UModularControllerComponent::MultiCastMoveCommand_Implementation(FClientNet
 		if (asCorrection)
 		{
 			_lastCorrectionReceived = Correction;
-			if (DebugType == ControllerDebugType_NetworkDebug)
+			if (bDebug)
 			{
 				UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Autonomous Proxy Received Correction Stamped: %f"), Correction.TimeStamp), true, true, FColor::Orange, 5, TEXT("MultiCastMoveCommand_1"));
 			}
@@ -544,8 +1475,9 @@ void UModularControllerComponent::MultiCastMoveCommand_Implementation(FClientNet
 
 	default:
 	{
+		ReceiveRemoteInputs(command);
 		_lastCmdReceived = command;
-		if (DebugType == ControllerDebugType_NetworkDebug)
+		if (bDebug)
 		{
 			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Simulated Proxy Received Command Stamped: %f"), command.TimeStamp), true, true, FColor::Cyan, 1, TEXT("MultiCastMoveCommand_2"));
 		}
@@ -559,34 +1491,42 @@ void UModularControllerComponent::MultiCastStates_Implementation(const TArray<TS
 {
 	if (caller != this)
 		return;
+	for (UBaseControllerState* state : StatesInstances)
+		ReleaseBehaviourRuntime(state);
 	StatesInstances.Empty();
 	for (int i = 0; i < states.Num(); i++)
 	{
 		if (states[i] == nullptr)
 			continue;
-		UBaseControllerState* instance = NewObject<UBaseControllerState>(states[i], states[i]);
+		UBaseControllerState* instance = CreateStateInstance(states[i]);
 		StatesInstances.Add(instance);
 	}
 
 	if (StatesInstances.Num() > 0)
 		StatesInstances.Sort([](UBaseControllerState& a, UBaseControllerState& b) { return a.GetPriority() > b.GetPriority(); });
+	BuildCompatibilityMasks();
+	ResetActionTimers();
 }
 
 void UModularControllerComponent::MultiCastActions_Implementation(const TArray<TSubclassOf<UBaseControllerAction>>& actions, UModularControllerComponent* caller)
 {
 	if (caller != this)
 		return;
+	for (UBaseControllerAction* action : ActionInstances)
+		ReleaseBehaviourRuntime(action);
 	ActionInstances.Empty();
 	for (int i = 0; i < actions.Num(); i++)
 	{
 		if (actions[i] == nullptr)
 			continue;
-		UBaseControllerAction* instance = NewObject<UBaseControllerAction>(actions[i], actions[i]);
-		instance->InitializeAction();
+		UBaseControllerAction* instance = CreateActionInstance(actions[i]);
+		ActionInstances.Add(instance);
 	}
 
 	if (ActionInstances.Num() > 0)
-		ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+		ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+	BuildCompatibilityMasks();
+	ResetActionTimers();
 }
 
 #pragma region Listened OOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO
@@ -594,37 +1534,29 @@ void UModularControllerComponent::MultiCastActions_Implementation(const TArray<T
 
 void UModularControllerComponent::ListenServerUpdateComponent(float delta)
 {
-	const FVector moveInp = ConsumeMovementInput();
-	FKinematicInfos movement = FKinematicInfos(moveInp, GetGravity(), LastMoveMade, GetMass());
-
-	//Execute the move
-	movement.bUsePhysic = bUsePhysicAuthority;
-	auto statusInfos = EvaluateControllerStatus(movement, moveInp, _user_inputPool, delta);
-	//
+	if (SenseAndDecidePhase(delta))
 	{
-		FVelocity alteredMotion = ProcessStatus(statusInfos, movement, moveInp, _user_inputPool, delta);
-
-		EvaluateRootMotionOverride(alteredMotion, movement, delta);
-		alteredMotion.Rotation = HandleRotation(alteredMotion, movement, delta);
-		if (_user_inputPool)
-			_user_inputPool->UpdateInputs(delta);
+		IntegrationPhase();
+		CommitPhase();
+	}
+}
 
-		FVelocity resultingMove = EvaluateMove(movement, alteredMotion, delta);
-		resultingMove._rooMotionScale = alteredMotion._rooMotionScale;
-		PostMoveUpdate(movement, resultingMove, CurrentStateIndex, delta);
-		Move(movement.FinalTransform.GetLocation(), movement.FinalTransform.GetRotation(), delta);
 
-		movement.FinalTransform.SetComponents(UpdatedPrimitive->GetComponentRotation().Quaternion(), UpdatedPrimitive->GetComponentLocation(), UpdatedPrimitive->GetComponentScale());
-	}
-	LastMoveMade = movement;
-	auto moveCmd = FClientNetMoveCommand(_timeElapsed, delta, moveInp, LastMoveMade, statusInfos);
+void UModularControllerComponent::ListenServerSendCommand(float delta)
+{
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
+	auto moveCmd = FClientNetMoveCommand(_timeElapsed, delta, _phasedUpdate.MoveInput, LastMoveMade, _phasedUpdate.Status);
+	const bool sendInputs = ShouldSendInputs();
+	if (sendInputs && _user_inputPool)
+		_inputsToSend.Capture(*_user_inputPool);
 
-	if (_lastCmdReceived.HasChanged(moveCmd, 1, 5) || !_startPositionSet)
+	if (_lastCmdReceived.HasChanged(moveCmd, 1, 5) || (sendInputs && _inputsToSend.HasChanged(_inputsSent)) || !_startPositionSet)
 	{
 		_startPositionSet = true;
+		PackInputsToSend(moveCmd);
 		_lastCmdReceived = moveCmd;
 		MultiCastMoveCommand(moveCmd);
-		if (DebugType == ControllerDebugType_NetworkDebug)
+		if (bDebug)
 		{
 			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Listen Send Command Stamped: %f"), moveCmd.TimeStamp), true, true, FColor::White, 1, TEXT("ListenServerUpdateComponent"));
 		}
@@ -639,6 +1571,7 @@ void UModularControllerComponent::ListenServerUpdateComponent(float delta)
 
 void UModularControllerComponent::DedicatedServerUpdateComponent(float delta)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
 	FHitResult initialChk;
 	bool madeCorrection = false;
 	bool ackCorrection = false;
@@ -647,6 +1580,7 @@ void UModularControllerComponent::DedicatedServerUpdateComponent(float delta)
 	{
 		if (_servercmdCheckPool.Num() > 0)
 		{
+			ReceiveRemoteInputs(_servercmdCheckPool[0]);
 			if (bUseClientAuthorative)
 			{
 				_lastCmdReceived = _servercmdCheckPool[0];
@@ -702,20 +1636,23 @@ void UModularControllerComponent::DedicatedServerUpdateComponent(float delta)
 	movement.FinalVelocities.ConstantLinearVelocity = _lastCmdReceived.WithVelocity;
 
 	//Status
-	EvaluateControllerStatus(movement, _lastCmdReceived.userMoveInput, _user_inputPool, delta, _lastCmdReceived.ControllerStatus);
+	EvaluateRemoteStatus(movement, _lastCmdReceived.userMoveInput, delta, _lastCmdReceived.ControllerStatus);
 	auto copyOfStatus = _lastCmdReceived.ControllerStatus;
-	ProcessStatus(copyOfStatus, movement, _lastCmdReceived.userMoveInput, _user_inputPool, delta);
+	ProcessStatus(copyOfStatus, movement, _lastCmdReceived.userMoveInput, GetRemoteInputPool(), delta);
 
 	PostMoveUpdate(movement, movement.FinalVelocities, _lastCmdReceived.ControllerStatus.StateIndex, delta);
 	LastMoveMade = movement;
 
 	//Network
-	if (_lastCmdExecuted.HasChanged(_lastCmdReceived, 1, 5) || !_startPositionSet)
+	if (_lastCmdExecuted.HasChanged(_lastCmdReceived, 1, 5) || (ShouldSendInputs() && _inputsToSend.HasChanged(_inputsSent)) || !_startPositionSet)
 	{
 		//Set a time stamp to be able to initialize client
 		if (!_startPositionSet)
 			_lastCmdReceived.TimeStamp = _timeElapsed;
 
+		//Relay the remote user inputs to the simulated proxies.
+		PackInputsToSend(_lastCmdReceived);
+
 		_lastCmdExecuted = _lastCmdReceived;
 		if (madeCorrection || ackCorrection)
 		{
@@ -728,7 +1665,7 @@ void UModularControllerComponent::DedicatedServerUpdateComponent(float delta)
 			MultiCastMoveCommand(_lastCmdReceived);
 		}
 
-		if (DebugType == ControllerDebugType_NetworkDebug)
+		if (bDebug)
 		{
 			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Dedicated Send Command Stamped: %f as correction? %d"), _lastCmdReceived.TimeStamp, madeCorrection), true, true, FColor::White, 1, TEXT("DedicatedServerUpdateComponent"));
 		}
@@ -760,6 +1697,7 @@ void UModularControllerComponent::ServerRequestActions_Implementation(UModularCo
 
 void UModularControllerComponent::ServerCastMoveCommand_Implementation(FClientNetMoveCommand command)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
 	//Stop trying to initialize when receiving the first move request.
 	_startPositionSet = true;
 
@@ -769,7 +1707,7 @@ void UModularControllerComponent::ServerCastMoveCommand_Implementation(FClientNe
 		MultiCastMoveCommand(command);
 	}
 
-	if (DebugType == ControllerDebugType_NetworkDebug)
+	if (bDebug)
 	{
 		UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Dedicated received command Stamped: %f"), command.TimeStamp), true, true, FColor::Black, 1, TEXT("ServerCastMoveCommand"));
 	}
@@ -778,10 +1716,21 @@ void UModularControllerComponent::ServerCastMoveCommand_Implementation(FClientNe
 
 void UModularControllerComponent::AutonomousProxyUpdateComponent(float delta)
 {
+	if (SenseAndDecidePhase(delta))
+	{
+		IntegrationPhase();
+		CommitPhase();
+	}
+}
+
+
+bool UModularControllerComponent::AutonomousProxyPrepareUpdate(bool& corrected)
+{
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
 	//Handle Starting Location
 	{
 		if (_lastCmdReceived.TimeStamp == 0 && !_startPositionSet)
-			return;
+			return false;
 		if (!_startPositionSet)
 		{
 			UpdatedComponent->SetWorldLocationAndRotation(_lastCmdReceived.ToLocation, _lastCmdReceived.ToRotation);
@@ -792,7 +1741,7 @@ void UModularControllerComponent::AutonomousProxyUpdateComponent(float delta)
 
 
 	////Correction
-	bool corrected = false;
+	corrected = false;
 	if (!bUseClientAuthorative)
 	{
 		FClientNetMoveCommand cmdBefore;
@@ -811,14 +1760,14 @@ void UModularControllerComponent::AutonomousProxyUpdateComponent(float delta)
 				LastMoveMade.FinalVelocities.ConstantLinearVelocity = correctionCmd.ToVelocity;
 				LastMoveMade.FinalVelocities.Rotation = LastMoveMade.InitialTransform.GetRotation();
 
-				if (DebugType == ControllerDebugType_NetworkDebug)
+				if (bDebug)
 				{
 					UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Autonomous Set Correction to Stamped: %f"), _lastCorrectionReceived.TimeStamp), true, true, FColor::Orange, 1, TEXT("AutonomousProxyUpdateComponent_correction_1"));
 				}
 			}
 		}
 
-		if (DebugType == ControllerDebugType_NetworkDebug)
+		if (bDebug)
 		{
 			DrawDebugCapsule(GetWorld(), correctionCmd.FromLocation, 90, 40, correctionCmd.FromRotation.Quaternion(), FColor::Orange, false, 1);
 			DrawDebugDirectionalArrow(GetWorld(), correctionCmd.FromLocation, correctionCmd.FromLocation + correctionCmd.FromRotation.Vector() * 40, 20, FColor::Red, false, -1);
@@ -829,62 +1778,30 @@ void UModularControllerComponent::AutonomousProxyUpdateComponent(float delta)
 		}
 	}
 
+	return true;
+}
 
-	const FVector moveInp = ConsumeMovementInput();
-	FKinematicInfos movement = FKinematicInfos(moveInp, GetGravity(), LastMoveMade, GetMass());
-
-	//Execute the move
-	movement.bUsePhysic = bUsePhysicAuthority;
-	auto statusInfos = EvaluateControllerStatus(movement, moveInp, _user_inputPool, delta);
-	//
-	{
-		FVelocity alteredMotion = ProcessStatus(statusInfos, movement, moveInp, _user_inputPool, delta);
-
-		EvaluateRootMotionOverride(alteredMotion, movement, delta);
-		alteredMotion.Rotation = HandleRotation(alteredMotion, movement, delta);
-		if (_user_inputPool)
-			_user_inputPool->UpdateInputs(delta);
-
-		FVelocity resultingMove = EvaluateMove(movement, alteredMotion, delta);
-		if (_lastCorrectionReceived.CollisionOccured)
-		{
-			const bool tryMoveThroughObstacle_Linear = FVector::DotProduct(resultingMove.ConstantLinearVelocity, _lastCorrectionReceived.CollisionNormal) <= 0;
-			if (tryMoveThroughObstacle_Linear)
-				resultingMove.ConstantLinearVelocity = FVector::VectorPlaneProject(resultingMove.ConstantLinearVelocity, _lastCorrectionReceived.CollisionNormal);
-
-			const bool tryMoveThroughObstacle_Instant = FVector::DotProduct(resultingMove.InstantLinearVelocity, _lastCorrectionReceived.CollisionNormal) <= 0;
-			if (tryMoveThroughObstacle_Instant)
-				resultingMove.InstantLinearVelocity = FVector::VectorPlaneProject(resultingMove.InstantLinearVelocity, _lastCorrectionReceived.CollisionNormal);
-		}
-		resultingMove._rooMotionScale = alteredMotion._rooMotionScale;
-		PostMoveUpdate(movement, resultingMove, CurrentStateIndex, delta);
 
-		if (bUseClientAuthorative)
-		{
-			Move(movement.FinalTransform.GetLocation(), movement.FinalTransform.GetRotation(), delta);
-			movement.FinalTransform.SetComponents(UpdatedPrimitive->GetComponentRotation().Quaternion(), UpdatedPrimitive->GetComponentLocation()
-				, UpdatedPrimitive->GetComponentScale());
-		}
-		else
-		{
-			const FVector lerpPos = FMath::Lerp(UpdatedComponent->GetComponentLocation(), movement.FinalTransform.GetLocation(), delta * AdjustmentSpeed);
-			const FQuat slerpRot = FQuat::Slerp(UpdatedComponent->GetComponentQuat(), movement.FinalTransform.GetRotation(), delta * AdjustmentSpeed);
-			UpdatedComponent->SetWorldLocationAndRotation(lerpPos, slerpRot);
-		}
-	}
-	LastMoveMade = movement;
-	auto moveCmd = FClientNetMoveCommand(_timeElapsed, delta, moveInp, LastMoveMade, statusInfos);
+void UModularControllerComponent::AutonomousProxySendCommand(float delta)
+{
+	const bool bDebug = IsDebugging(ControllerDebugType_NetworkDebug);
+	const bool corrected = _phasedUpdate.bCorrected;
+	auto moveCmd = FClientNetMoveCommand(_timeElapsed, delta, _phasedUpdate.MoveInput, LastMoveMade, _phasedUpdate.Status);
+	const bool sendInputs = ShouldSendInputs();
+	if (sendInputs && _user_inputPool)
+		_inputsToSend.Capture(*_user_inputPool);
 
 	//Changes and Network
-	if (_lastCmdExecuted.HasChanged(moveCmd, 1, 5))
+	if (_lastCmdExecuted.HasChanged(moveCmd, 1, 5) || (sendInputs && _inputsToSend.HasChanged(_inputsSent)))
 	{
+		PackInputsToSend(moveCmd);
 		_lastCmdExecuted = moveCmd;
 		_clientcmdHistory.Add(moveCmd);
 		if (!corrected)
 		{
 			moveCmd.CorrectionAckowledgement = _lastCorrectionReceived.TimeStamp != 0;
 			ServerCastMoveCommand(moveCmd);
-			if (DebugType == ControllerDebugType_NetworkDebug)
+			if (bDebug)
 			{
 				UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Autonomous Send Command Stamped: %f"), moveCmd.TimeStamp), true, true, FColor::Orange, 1, TEXT("AutonomousProxyUpdateComponent"));
 			}
@@ -897,13 +1814,16 @@ void UModularControllerComponent::AutonomousProxyUpdateComponent(float delta)
 #pragma region Simulated Proxy OOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOOO
 
 
-void UModularControllerComponent::SimulatedProxyUpdateComponent(float delta)
+void UModularControllerComponent::SimulatedProxyUpdateComponent(float delta, bool evaluateStatus)
 {
-	FKinematicInfos movement = FKinematicInfos(_lastCmdReceived.userMoveInput, GetGravity(), LastMoveMade, GetMass());
+	//Run ahead of the last command received
+	const float aheadTime = GetRemoteExtrapolationTime();
+	const FVector moveInput = evaluateStatus ? ExtrapolateRemoteInputs(aheadTime) : FVector(_lastCmdReceived.userMoveInput);
+	FKinematicInfos movement = FKinematicInfos(moveInput, GetGravity(), LastMoveMade, GetMass());
 
 	//Move
 	FVector currentLocation = UpdatedPrimitive->GetComponentLocation();
-	FVector targetLocation = _lastCmdReceived.ToLocation;
+	FVector targetLocation = _lastCmdReceived.ToLocation + _lastCmdReceived.WithVelocity * aheadTime;
 	FVector lerpLocation = FMath::Lerp(currentLocation, targetLocation, delta * AdjustmentSpeed);
 	UpdatedPrimitive->SetWorldLocation(lerpLocation);
 	movement.InitialTransform.SetLocation(currentLocation);
@@ -920,9 +1840,14 @@ void UModularControllerComponent::SimulatedProxyUpdateComponent(float delta)
 	movement.FinalVelocities.ConstantLinearVelocity = _lastCmdReceived.WithVelocity;
 
 	//Status
-	EvaluateControllerStatus(movement, _lastCmdReceived.userMoveInput, _user_inputPool, delta, _lastCmdReceived.ControllerStatus);
-	auto copyOfStatus = _lastCmdReceived.ControllerStatus;
-	ProcessStatus(copyOfStatus, movement, _lastCmdReceived.userMoveInput, _user_inputPool, delta);
+	if (evaluateStatus)
+	{
+		const float statusDelta = delta + _lodAccumulatedDelta;
+		_lodAccumulatedDelta = 0;
+		EvaluateRemoteStatus(movement, moveInput, statusDelta, _lastCmdReceived.ControllerStatus);
+		auto copyOfStatus = _lastCmdReceived.ControllerStatus;
+		ProcessStatus(copyOfStatus, movement, moveInput, GetRemoteInputPool(), statusDelta);
+	}
 
 	PostMoveUpdate(movement, movement.FinalVelocities, _lastCmdReceived.ControllerStatus.StateIndex, delta);
 	LastMoveMade = movement;
@@ -951,10 +1876,12 @@ void UModularControllerComponent::SubstepTick(float DeltaTime, FBodyInstance* Bo
 
 void UModularControllerComponent::BeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_PhysicDebug);
 	////overlap objects
 	if (OverlappedComponent != nullptr && OtherComp != nullptr && OtherActor != nullptr)
 	{
-		if (DebugType == ControllerDebugType_PhysicDebug)
+		WakeUp();
+		if (bDebug)
 		{			
 			GEngine->AddOnScreenDebugMessage((int32)GetOwner()->GetUniqueID() + 9, 1, FColor::Green, FString::Printf(TEXT("Overlaped With: %s"), *OtherActor->GetActorNameOrLabel()));
 		}
@@ -964,13 +1891,15 @@ void UModularControllerComponent::BeginOverlap(UPrimitiveComponent* OverlappedCo
 
 void UModularControllerComponent::BeginCollision(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	if (OtherActor != nullptr && DebugType == ControllerDebugType_PhysicDebug) 
+	const bool bDebug = IsDebugging(ControllerDebugType_PhysicDebug);
+	if (OtherActor != nullptr && bDebug) 
 	{
 		GEngine->AddOnScreenDebugMessage((int32)GetOwner()->GetUniqueID() + 10, 1, FColor::Green, FString::Printf(TEXT("Collision With: %s"), *OtherActor->GetActorNameOrLabel()));
 	}
 
 	if (OtherComp)
 	{
+		WakeUp();
 		UModularControllerComponent* otherModularComponent = nullptr;
 		if (OtherActor != nullptr)
 		{
@@ -996,10 +1925,9 @@ void UModularControllerComponent::BeginCollision(UPrimitiveComponent* HitComp, A
 
 FSurfaceInfos UModularControllerComponent::GetCurrentSurface() const
 {
-	const auto state = GetCurrentControllerState();
-	if (!state)
+	if (!_stateRuntimes.IsValidIndex(CurrentStateIndex))
 		return FSurfaceInfos();
-	return  state->SurfaceInfos;
+	return _stateRuntimes[CurrentStateIndex]->Get<FControllerStateRuntime>().SurfaceInfos;
 }
 
 
@@ -1024,6 +1952,109 @@ void UModularControllerComponent::SetOverrideRootMotionMode(USkeletalMeshCompone
 	}
 }
 
+
+FBehaviourRuntimeRef UModularControllerComponent::GetBehaviourRuntime(const UObject* behaviour) const
+{
+	const FBehaviourSnapShotRing* runtime = FindBehaviourRing(behaviour);
+	return runtime ? runtime->GetRef() : FBehaviourRuntimeRef();
+}
+
+
+bool UModularControllerComponent::RestoreBehavioursFrame(int64 frame)
+{
+	//Either every behaviour is restored or none.
+	for (const auto& runtime : _behaviourRuntimes)
+	{
+		if (!runtime.Value->Contains(frame))
+			return false;
+	}
+
+	for (const auto& runtime : _behaviourRuntimes)
+	{
+		runtime.Value->Restore(frame);
+	}
+	ResetActionTimers();
+	return true;
+}
+
+
+void UModularControllerComponent::RecordBehavioursFrame(int64 frame)
+{
+	for (const auto& runtime : _behaviourRuntimes)
+	{
+		runtime.Value->Save(frame);
+	}
+}
+
+
+UBaseControllerState* UModularControllerComponent::CreateStateInstance(TSubclassOf<UBaseControllerState> stateClass)
+{
+	if (stateClass == nullptr)
+		return nullptr;
+
+	//A definition used twice by this controller gets a private instance, the runtime properties being per behaviour.
+	UModularControllerSubsystem* subsystem = bShareBehaviourDefinitions && GetWorld() ? GetWorld()->GetSubsystem<UModularControllerSubsystem>() : nullptr;
+	UBaseControllerState* instance = subsystem ? subsystem->GetSharedState(stateClass) : nullptr;
+	if (instance == nullptr || _behaviourRuntimes.Contains(instance))
+	{
+		instance = NewObject<UBaseControllerState>(stateClass, stateClass);
+		instance->InitializeState();
+	}
+
+	TUniquePtr<FBehaviourSnapShotRing>& runtime = _behaviourRuntimes.Add(instance, MakeUnique<FBehaviourSnapShotRing>());
+	instance->InitializeRuntime(*runtime, SnapShotHistoryDepth);
+	return instance;
+}
+
+
+UBaseControllerAction* UModularControllerComponent::CreateActionInstance(TSubclassOf<UBaseControllerAction> actionClass)
+{
+	if (actionClass == nullptr)
+		return nullptr;
+
+	//A definition used twice by this controller gets a private instance, the runtime properties being per behaviour.
+	UModularControllerSubsystem* subsystem = bShareBehaviourDefinitions && GetWorld() ? GetWorld()->GetSubsystem<UModularControllerSubsystem>() : nullptr;
+	UBaseControllerAction* instance = subsystem ? subsystem->GetSharedAction(actionClass) : nullptr;
+	if (instance == nullptr || _behaviourRuntimes.Contains(instance))
+	{
+		instance = NewObject<UBaseControllerAction>(actionClass, actionClass);
+		instance->InitializeAction();
+	}
+
+	TUniquePtr<FBehaviourSnapShotRing>& runtime = _behaviourRuntimes.Add(instance, MakeUnique<FBehaviourSnapShotRing>());
+	instance->InitializeRuntime(*runtime, SnapShotHistoryDepth);
+	return instance;
+}
+
+
+void UModularControllerComponent::CacheBehaviourRuntimes()
+{
+	_stateRuntimes.SetNumUninitialized(StatesInstances.Num());
+	for (int i = 0; i < StatesInstances.Num(); i++)
+	{
+		_stateRuntimes[i] = FindBehaviourRing(StatesInstances[i]);
+	}
+	_actionRuntimes.SetNumUninitialized(ActionInstances.Num());
+	for (int i = 0; i < ActionInstances.Num(); i++)
+	{
+		_actionRuntimes[i] = FindBehaviourRing(ActionInstances[i]);
+	}
+}
+
+
+FBehaviourSnapShotRing* UModularControllerComponent::FindBehaviourRing(const UObject* behaviour) const
+{
+	const TUniquePtr<FBehaviourSnapShotRing>* runtime = behaviour ? _behaviourRuntimes.Find(behaviour) : nullptr;
+	return runtime ? runtime->Get() : nullptr;
+}
+
+
+void UModularControllerComponent::ReleaseBehaviourRuntime(const UObject* behaviour)
+{
+	if (behaviour)
+		_behaviourRuntimes.Remove(behaviour);
+}
+
 #pragma endregion
 
 
@@ -1061,13 +2092,16 @@ bool UModularControllerComponent::CheckControllerStateByPriority(int modulePrior
 
 void UModularControllerComponent::AddControllerState_Implementation(TSubclassOf<UBaseControllerState> moduleType)
 {
+	WakeUp();
 	if (moduleType == nullptr)
 		return;
 	if (CheckControllerStateByType(moduleType))
 		return;
-	UBaseControllerState* instance = NewObject<UBaseControllerState>(moduleType, moduleType);
+	UBaseControllerState* instance = CreateStateInstance(moduleType);
 	StatesInstances.Add(instance);
 	StatesInstances.Sort([](UBaseControllerState& a, UBaseControllerState& b) { return a.GetPriority() > b.GetPriority(); });
+	BuildCompatibilityMasks();
+	ResetActionTimers();
 }
 
 
@@ -1097,36 +2131,48 @@ UBaseControllerState* UModularControllerComponent::GetControllerStateByName(FNam
 
 void UModularControllerComponent::RemoveControllerStateByType_Implementation(TSubclassOf<UBaseControllerState> moduleType)
 {
+	WakeUp();
 	if (CheckControllerStateByType(moduleType))
 	{
 		auto behaviour = StatesInstances.FindByPredicate([moduleType](UBaseControllerState* state) -> bool { return state->GetClass() == moduleType->GetClass(); });
+		ReleaseBehaviourRuntime(*behaviour);
 		StatesInstances.Remove(*behaviour);
 		if (StatesInstances.Num() > 0)
 			StatesInstances.Sort([](UBaseControllerState& a, UBaseControllerState& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
 
 void UModularControllerComponent::RemoveControllerStateByName_Implementation(FName moduleName)
 {
+	WakeUp();
 	if (CheckControllerStateByName(moduleName))
 	{
 		auto behaviour = StatesInstances.FindByPredicate([moduleName](UBaseControllerState* state) -> bool { return state->GetDescriptionName() == moduleName; });
+		ReleaseBehaviourRuntime(*behaviour);
 		StatesInstances.Remove(*behaviour);
 		if (StatesInstances.Num() > 0)
 			StatesInstances.Sort([](UBaseControllerState& a, UBaseControllerState& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
 
 void UModularControllerComponent::RemoveControllerStateByPriority_Implementation(int modulePriority)
 {
+	WakeUp();
 	if (CheckControllerStateByPriority(modulePriority))
 	{
 		auto behaviour = StatesInstances.FindByPredicate([modulePriority](UBaseControllerState* state) -> bool { return state->GetPriority() == modulePriority; });
+		ReleaseBehaviourRuntime(*behaviour);
 		StatesInstances.Remove(*behaviour);
 		if (StatesInstances.Num() > 0)
 			StatesInstances.Sort([](UBaseControllerState& a, UBaseControllerState& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
@@ -1143,6 +2189,8 @@ int UModularControllerComponent::CheckControllerStates(FKinematicInfos& inDatas,
 	int selectedStateIndex = -1;
 	bool alterStateCheckMode = false;
 	FStatusParameters selectedStatus = currentStatus;
+	if (!simulation)
+		_stateChecksClock += inDelta;
 
 	//Check if a State's check have success state
 	{
@@ -1173,29 +2221,42 @@ int UModularControllerComponent::CheckControllerStates(FKinematicInfos& inDatas,
 
 		if (selectedStateIndex < 0)
 		{
+			const int activeStateIndex = simulatedCurrentStateIndex < 0 ? CurrentStateIndex : simulatedCurrentStateIndex;
 			for (int i = 0; i < StatesInstances.Num(); i++)
 			{
 				if (StatesInstances[i] == nullptr)
 					continue;
 
-				//Don't event check lower priorities
+				//Don't event check lower priorities. States are sorted by priority, so nothing left can pass.
 				if (StatesInstances[i]->GetPriority() < maxStatePriority)
 				{
+					break;
+				}
+
+				//Roll back a runtime left simulated by an earlier check, so the live check time is read.
+				FBehaviourSnapShotRing& stateRuntime = *_stateRuntimes[i];
+				if (!simulation)
+					UBaseControllerState::RestoreStateFromSnapShot(stateRuntime);
+
+				//States not reachable from the current one, and time sliced states not due. They are not snapshot.
+				if (!IsStateReachable(activeStateIndex, i))
+					continue;
+				if (!StatesInstances[i]->IsCheckDue(stateRuntime.Get<FControllerStateRuntime>(), _stateChecksClock, i == activeStateIndex))
 					continue;
-				}
 
 				//Handle state snapshot
 				if (simulation)
-					StatesInstances[i]->SaveStateSnapShot();
-				else
-					StatesInstances[i]->RestoreStateFromSnapShot();
+					UBaseControllerState::SaveStateSnapShot(stateRuntime);
+				StatesInstances[i]->ConsumeCheckInterval(stateRuntime.Get<FControllerStateRuntime>(), _stateChecksClock);
 
 				auto copyOfStatus = currentStatus;
-				if (StatesInstances[i]->CheckState(inDatas, moveInput, inputs, this, copyOfStatus, copyOfStatus, inDelta, alterStateCheckMode ? 0 : -1))
+				if (StatesInstances[i]->CheckState_Internal(stateRuntime.GetRef(), inDatas, moveInput, inputs, this, copyOfStatus, inDelta, alterStateCheckMode ? 0 : -1))
 				{
 					selectedStateIndex = i;
 					selectedStatus = copyOfStatus;
 					maxStatePriority = StatesInstances[i]->GetPriority();
+					if (StateEvaluationMode == StateEvaluationMode_FirstSuccess)
+						break;
 				}
 			}
 		}
@@ -1216,16 +2277,18 @@ bool UModularControllerComponent::TryChangeControllerState(int fromStateIndex, i
 		return false;
 
 	//Landing
-	StatesInstances[toStateIndex]->OnEnterState(inDatas, moveInput, this, inDelta);
+	const FBehaviourRuntimeRef toStateRuntime = _stateRuntimes[toStateIndex]->GetRef();
+	StatesInstances[toStateIndex]->OnEnterState(toStateRuntime, inDatas, moveInput, this, inDelta);
 	if (!simulate)
 		LinkAnimBlueprint(GetSkeletalMesh(), "State", StatesInstances[toStateIndex]->StateBlueprintClass);
-	StatesInstances[toStateIndex]->SetWasTheLastFrameControllerState(true);
+	toStateRuntime.Get<FControllerStateRuntime>().bWasTheLastFrameBehaviour = true;
 
 	if (StatesInstances.IsValidIndex(fromStateIndex))
 	{
 		//Leaving
-		StatesInstances[fromStateIndex]->OnExitState(inDatas, moveInput, this, inDelta);
-		StatesInstances[fromStateIndex]->SurfaceInfos.Reset();
+		const FBehaviourRuntimeRef fromStateRuntime = _stateRuntimes[fromStateIndex]->GetRef();
+		StatesInstances[fromStateIndex]->OnExitState(fromStateRuntime, inDatas, moveInput, this, inDelta);
+		fromStateRuntime.Get<FControllerStateRuntime>().SurfaceInfos.Reset();
 	}
 
 	for (int i = 0; i < StatesInstances.Num(); i++)
@@ -1233,33 +2296,13 @@ bool UModularControllerComponent::TryChangeControllerState(int fromStateIndex, i
 		if (i == toStateIndex)
 			continue;
 
-		StatesInstances[i]->SetWasTheLastFrameControllerState(false);
-		if (!simulate)
-		{
-			StatesInstances[i]->OnControllerStateChanged(StatesInstances.IsValidIndex(toStateIndex) ? StatesInstances[toStateIndex]->GetDescriptionName() : "", StatesInstances.IsValidIndex(toStateIndex) ? StatesInstances[toStateIndex]->GetPriority() : -1, this);
-		}
-	}
-
-	if (!simulate)
-	{
-		OnControllerStateChanged(StatesInstances.IsValidIndex(toStateIndex) ? StatesInstances[toStateIndex] : nullptr
-			, StatesInstances.IsValidIndex(fromStateIndex) ? StatesInstances[fromStateIndex] : nullptr);
-		OnControllerStateChangedEvent.Broadcast(StatesInstances.IsValidIndex(toStateIndex) ? StatesInstances[toStateIndex] : nullptr
-			, StatesInstances.IsValidIndex(fromStateIndex) ? StatesInstances[fromStateIndex] : nullptr);
-	}
-
-	if (!simulate)
-	{
-		//Notify actions the change of state
-		for (int i = 0; i < ActionInstances.Num(); i++)
-		{
-			ActionInstances[i]->OnStateChanged(StatesInstances.IsValidIndex(toStateIndex) ? StatesInstances[toStateIndex] : nullptr
-				, StatesInstances.IsValidIndex(fromStateIndex) ? StatesInstances[fromStateIndex] : nullptr);
-		}
+		_stateRuntimes[i]->Get<FControllerStateRuntime>().bWasTheLastFrameBehaviour = false;
 	}
 
 	if (!simulate)
 	{
+		//Notified on the flush
+		QueueTransitionEvent(false, StatesInstances[toStateIndex], StatesInstances.IsValidIndex(fromStateIndex) ? StatesInstances[fromStateIndex] : nullptr);
 		CurrentStateIndex = toStateIndex;
 	}
 
@@ -1275,13 +2318,14 @@ FVelocity UModularControllerComponent::ProcessControllerState(FStatusParameters&
 	if (StatesInstances.IsValidIndex(index))
 	{
 		//Handle state snapshot
+		FBehaviourSnapShotRing& stateRuntime = *_stateRuntimes[index];
 		if (simulatedStateIndex >= 0)
-			StatesInstances[index]->SaveStateSnapShot();
+			UBaseControllerState::SaveStateSnapShot(stateRuntime);
 		else
-			StatesInstances[index]->RestoreStateFromSnapShot();
+			UBaseControllerState::RestoreStateFromSnapShot(stateRuntime);
 
 		FVelocity processMotion = movement;
-		processMotion = StatesInstances[index]->ProcessState(controllerStatus, controllerStatus, inDatas, moveInput, this, inDelta);
+		processMotion = StatesInstances[index]->ProcessState_Internal(stateRuntime.GetRef(), controllerStatus, inDatas, moveInput, this, inDelta);
 
 		if (StatesInstances[index]->RootMotionMode != ERootMotionType::RootMotionType_No_RootMotion)
 		{
@@ -1384,14 +2428,16 @@ bool UModularControllerComponent::CheckActionBehaviourByPriority(int modulePrior
 
 void UModularControllerComponent::AddControllerAction_Implementation(TSubclassOf<UBaseControllerAction> moduleType)
 {
+	WakeUp();
 	if (moduleType == nullptr)
 		return;
 	if (CheckActionBehaviourByType(moduleType))
 		return;
-	UBaseControllerAction* instance = NewObject<UBaseControllerAction>(moduleType, moduleType);
-	instance->InitializeAction();
+	UBaseControllerAction* instance = CreateActionInstance(moduleType);
 	ActionInstances.Add(instance);
-	ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+	ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+	BuildCompatibilityMasks();
+	ResetActionTimers();
 }
 
 
@@ -1411,36 +2457,48 @@ UBaseControllerAction* UModularControllerComponent::GetActionByType(TSubclassOf<
 
 void UModularControllerComponent::RemoveActionBehaviourByType_Implementation(TSubclassOf<UBaseControllerAction> moduleType)
 {
+	WakeUp();
 	if (CheckActionBehaviourByType(moduleType))
 	{
 		auto behaviour = ActionInstances.FindByPredicate([moduleType](UBaseControllerAction* action) -> bool { return action->GetClass() == moduleType->GetClass(); });
+		ReleaseBehaviourRuntime(*behaviour);
 		ActionInstances.Remove(*behaviour);
 		if (ActionInstances.Num() > 0)
-			ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+			ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
 
 void UModularControllerComponent::RemoveActionBehaviourByName_Implementation(FName moduleName)
 {
+	WakeUp();
 	if (CheckActionBehaviourByName(moduleName))
 	{
 		auto behaviour = ActionInstances.FindByPredicate([moduleName](UBaseControllerAction* action) -> bool { return action->GetDescriptionName() == moduleName; });
+		ReleaseBehaviourRuntime(*behaviour);
 		ActionInstances.Remove(*behaviour);
 		if (ActionInstances.Num() > 0)
-			ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+			ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
 
 void UModularControllerComponent::RemoveActionBehaviourByPriority_Implementation(int modulePriority)
 {
+	WakeUp();
 	if (CheckActionBehaviourByPriority(modulePriority))
 	{
 		auto behaviour = ActionInstances.FindByPredicate([modulePriority](UBaseControllerAction* action) -> bool { return action->GetPriority() == modulePriority; });
+		ReleaseBehaviourRuntime(*behaviour);
 		ActionInstances.Remove(*behaviour);
 		if (ActionInstances.Num() > 0)
-			ActionInstances.Sort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+			ActionInstances.StableSort([](UBaseControllerAction& a, UBaseControllerAction& b) { return a.GetPriority() > b.GetPriority(); });
+		BuildCompatibilityMasks();
+		ResetActionTimers();
 		return;
 	}
 }
@@ -1451,22 +2509,31 @@ void UModularControllerComponent::RemoveActionBehaviourByPriority_Implementation
 int UModularControllerComponent::CheckControllerActions(FKinematicInfos& inDatas, FVector moveInput,
 	UInputEntryPool* inputs, const int controllerStateIndex, const int controllerActionIndex, const float inDelta, FStatusParameters& currentStatus, bool simulation)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_StatusDebug);
 	int activeActionIndex = -1;
 	currentStatus.PrimaryActionFlag = 0;
 
+	if (!simulation)
+	{
+		_actionTimers.Clock += inDelta;
+		DispatchActionTimers();
+	}
+	GatherActionsToCheck(inputs);
+
 	////Check active action still active
 	activeActionIndex = controllerActionIndex;
 	if (ActionInstances.IsValidIndex(activeActionIndex))
 	{
-		if (ActionInstances[activeActionIndex]->CurrentPhase == ActionPhase_Recovery
+		const FBehaviourRuntimeRef activeRuntime = _actionRuntimes[activeActionIndex]->GetRef();
+		if (activeRuntime.Get<FControllerActionRuntime>().CurrentPhase == ActionPhase_Recovery
 			&& ActionInstances[activeActionIndex]->bCanTransitionToSelf
-			&& CheckActionCompatibility(ActionInstances[activeActionIndex], controllerStateIndex, controllerActionIndex)
-			&& ActionInstances[activeActionIndex]->CheckAction_Internal(inDatas, moveInput, inputs, this, currentStatus, inDelta))
+			&& CheckActionCompatibility(ActionInstances[activeActionIndex], controllerStateIndex, controllerActionIndex, activeActionIndex)
+			&& ActionInstances[activeActionIndex]->CheckAction_Internal(activeRuntime, inDatas, moveInput, inputs, this, currentStatus, inDelta))
 		{
 			currentStatus.PrimaryActionFlag = 1;
 		}
 
-		if (ActionInstances[activeActionIndex]->GetRemainingActivationTime() <= 0)
+		if (activeRuntime.Get<FControllerActionRuntime>().RemainingActivationTimer <= 0)
 		{
 			activeActionIndex = -1;
 		}
@@ -1491,34 +2558,52 @@ int UModularControllerComponent::CheckControllerActions(FKinematicInfos& inDatas
 			{
 				if (ActionInstances[i]->GetPriority() != ActionInstances[activeActionIndex]->GetPriority())
 					continue;
-				if (ActionInstances[i]->GetPriority() == ActionInstances[activeActionIndex]->GetPriority() && ActionInstances[activeActionIndex]->CurrentPhase != ActionPhase_Recovery)
+				if (ActionInstances[i]->GetPriority() == ActionInstances[activeActionIndex]->GetPriority() && _actionRuntimes[activeActionIndex]->Get<FControllerActionRuntime>().CurrentPhase != ActionPhase_Recovery)
 					continue;
 			}
 		}
 
+		//Actions cooling down or without any live trigger input are not snapshot. Only a runtime left simulated by an earlier check is rolled back.
+		//The cooldown is tracked by the timers, the runtime only mirror it on live updates.
+		FBehaviourSnapShotRing& actionRuntime = *_actionRuntimes[i];
+		double coolDownRemaining = 0;
+		const bool coolingDown = _actionTimers.IsCoolingDown(i, coolDownRemaining);
+		if (coolingDown || (_actionsToCheck.IsValidIndex(i) && !_actionsToCheck[i]))
+		{
+			if (!simulation)
+			{
+				UBaseControllerAction::RestoreActionFromSnapShot(actionRuntime);
+				actionRuntime.Get<FControllerActionRuntime>().CoolDownTimer = coolingDown ? coolDownRemaining : 0;
+			}
+			continue;
+		}
+
 		//Handle state snapshot
 		if (simulation)
-			ActionInstances[i]->SaveActionSnapShot();
+			UBaseControllerAction::SaveActionSnapShot(actionRuntime);
 		else
-			ActionInstances[i]->RestoreActionFromSnapShot();
+		{
+			UBaseControllerAction::RestoreActionFromSnapShot(actionRuntime);
+			actionRuntime.Get<FControllerActionRuntime>().CoolDownTimer = 0;
+		}
 
 		auto copyOfStatus = currentStatus;
-		if (CheckActionCompatibility(ActionInstances[i], controllerStateIndex, controllerActionIndex)
-			&& ActionInstances[i]->CheckAction_Internal(inDatas, moveInput, inputs, this, copyOfStatus, inDelta))
+		if (CheckActionCompatibility(ActionInstances[i], controllerStateIndex, controllerActionIndex, i)
+			&& ActionInstances[i]->CheckAction_Internal(actionRuntime.GetRef(), inDatas, moveInput, inputs, this, copyOfStatus, inDelta))
 		{
 			activeActionIndex = i;
 			currentStatus = copyOfStatus;
 
-			if (!simulation && DebugType == ControllerDebugType_StatusDebug)
+			if (!simulation && bDebug)
 			{
-				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) was checked as active. Remaining Time: %f"), *ActionInstances[i]->DebugString(), ActionInstances[i]->GetRemainingActivationTime()), true, true, FColor::Silver, 0
+				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) was checked as active. Remaining Time: %f"), *ActionInstances[i]->DebugString(actionRuntime.GetRef()), ActionInstances[i]->GetRemainingActivationTime(actionRuntime.GetRef())), true, true, FColor::Silver, 0
 					, FName(FString::Printf(TEXT("CheckControllerActions_%s"), *ActionInstances[i]->GetDescriptionName().ToString())));
 			}
 		}
 
 	}
 
-	if (!simulation && DebugType == ControllerDebugType_StatusDebug)
+	if (!simulation && bDebug)
 	{
 		UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Check Action Phase: %d"), activeActionIndex), true, true, FColor::Silver, 0
 			, TEXT("CheckControllerActions"));
@@ -1529,11 +2614,29 @@ int UModularControllerComponent::CheckControllerActions(FKinematicInfos& inDatas
 
 
 
-bool UModularControllerComponent::CheckActionCompatibility(UBaseControllerAction* actionInstance, int stateIndex, int actionIndex)
+bool UModularControllerComponent::CheckActionCompatibility(UBaseControllerAction* actionInstance, int stateIndex, int actionIndex, int candidateIndex)
 {
 	if (actionInstance == nullptr)
 		return false;
 
+	//Precomputed masks
+	if (_compatibilityMasksValid && _actionStatesMasks.IsValidIndex(candidateIndex) && ActionInstances[candidateIndex] == actionInstance)
+	{
+		const bool stateCompatible = StatesInstances.IsValidIndex(stateIndex) && ((_actionStatesMasks[candidateIndex] >> stateIndex) & 1);
+		const bool actionCompatible = ActionInstances.IsValidIndex(actionIndex) && ((_actionActionsMasks[candidateIndex] >> actionIndex) & 1);
+		switch (actionInstance->ActionCompatibilityMode)
+		{
+		default:
+			return true;
+		case ActionCompatibilityMode_WhileCompatibleActionOnly:
+			return actionCompatible;
+		case ActionCompatibilityMode_OnCompatibleStateOnly:
+			return stateCompatible;
+		case ActionCompatibilityMode_OnBothCompatiblesStateAndAction:
+			return stateCompatible && actionCompatible;
+		}
+	}
+
 	bool incompatible = false;
 	switch (actionInstance->ActionCompatibilityMode)
 	{
@@ -1602,16 +2705,158 @@ bool UModularControllerComponent::CheckActionCompatibility(UBaseControllerAction
 
 
 
+void UModularControllerComponent::ResetActionTimers()
+{
+	_actionTimers.Reset(ActionInstances.Num());
+	for (int i = 0; i < ActionInstances.Num(); i++)
+	{
+		ScheduleActionTimers(i);
+	}
+}
+
+
+void UModularControllerComponent::ScheduleActionTimers(int actionIndex)
+{
+	if (!ActionInstances.IsValidIndex(actionIndex) || ActionInstances[actionIndex] == nullptr)
+		return;
+	const FControllerActionRuntime& runtime = _actionRuntimes[actionIndex]->Get<FControllerActionRuntime>();
+	_actionTimers.Schedule(actionIndex, FMath::Max(runtime.CoolDownTimer, 0.0), FMath::Max(runtime.RemainingActivationTimer, 0.0), runtime.ActivePhaseDuration, runtime.RecoveryPhaseDuration);
+}
+
+
+void UModularControllerComponent::DispatchActionTimers()
+{
+	int actionIndex = INDEX_NONE;
+	EActionPhase phase = ActionPhase_Undetermined;
+	while (_actionTimers.PopDuePhase(actionIndex, phase))
+	{
+		if (ActionInstances.IsValidIndex(actionIndex) && ActionInstances[actionIndex])
+			ActionInstances[actionIndex]->EnterPhase(_actionRuntimes[actionIndex]->GetRef(), phase);
+	}
+}
+
+
+void UModularControllerComponent::GatherActionsToCheck(const UInputEntryPool* inputs)
+{
+	_actionsToCheck = _ungatedActions;
+	if (inputs == nullptr)
+		return;
+	for (const auto& trigger : _actionTriggerIndex)
+	{
+		if (!inputs->IsInputLive(trigger.Key))
+			continue;
+		for (const int actionIndex : trigger.Value)
+		{
+			_actionsToCheck[actionIndex] = true;
+		}
+	}
+}
+
+
+bool UModularControllerComponent::IsStateReachable(int fromStateIndex, int toStateIndex) const
+{
+	if (StateTransitionGraph == nullptr)
+		return true;
+	if (_stateTransitionMasksValid)
+		return !_stateTransitionMasks.IsValidIndex(fromStateIndex) || (_stateTransitionMasks[fromStateIndex] & ((uint64)1 << toStateIndex)) != 0;
+
+	//Too many states for the masks
+	if (!StatesInstances.IsValidIndex(fromStateIndex) || !StatesInstances[fromStateIndex] || !StatesInstances.IsValidIndex(toStateIndex) || !StatesInstances[toStateIndex])
+		return true;
+	return StateTransitionGraph->IsTransitionAllowed(StatesInstances[fromStateIndex]->GetDescriptionName(), StatesInstances[toStateIndex]->GetDescriptionName());
+}
+
+
+void UModularControllerComponent::SetStateTransitionGraph(UStateTransitionGraph* graph)
+{
+	StateTransitionGraph = graph;
+	BuildCompatibilityMasks();
+}
+
+
+void UModularControllerComponent::BuildCompatibilityMasks()
+{
+	CacheBehaviourRuntimes();
+
+	_actionStatesMasks.Reset();
+	_actionActionsMasks.Reset();
+	_stateTransitionMasks.Reset();
+
+	//Trigger inputs. Actions are sorted by priority, so are the indexes.
+	_actionTriggerIndex.Reset();
+	_ungatedActions.Init(true, ActionInstances.Num());
+	TArray<FName> triggerInputs;
+	for (int i = 0; i < ActionInstances.Num(); i++)
+	{
+		if (ActionInstances[i] == nullptr)
+			continue;
+		triggerInputs.Reset();
+		ActionInstances[i]->GetActionTriggerInputs(triggerInputs);
+		for (const FName& input : triggerInputs)
+		{
+			const int32 inputHandle = UInputEntryPool::RegisterInput(input);
+			if (inputHandle == INDEX_NONE)
+				continue;
+			_actionTriggerIndex.FindOrAdd(inputHandle).AddUnique(i);
+			_ungatedActions[i] = false;
+		}
+	}
+	if (_user_inputPool)
+		_user_inputPool->Reserve(UInputEntryPool::GetRegisteredInputCount());
+
+	_stateTransitionMasksValid = StatesInstances.Num() <= 64;
+	if (StateTransitionGraph && _stateTransitionMasksValid)
+	{
+		_stateTransitionMasks.SetNumZeroed(StatesInstances.Num());
+		for (int i = 0; i < StatesInstances.Num(); i++)
+		{
+			if (StatesInstances[i] == nullptr)
+				continue;
+			for (int j = 0; j < StatesInstances.Num(); j++)
+			{
+				if (StatesInstances[j] && StateTransitionGraph->IsTransitionAllowed(StatesInstances[i]->GetDescriptionName(), StatesInstances[j]->GetDescriptionName()))
+					_stateTransitionMasks[i] |= (uint64)1 << j;
+			}
+		}
+	}
+
+	_compatibilityMasksValid = StatesInstances.Num() <= 64 && ActionInstances.Num() <= 64;
+	if (!_compatibilityMasksValid)
+		return;
+
+	_actionStatesMasks.SetNumZeroed(ActionInstances.Num());
+	_actionActionsMasks.SetNumZeroed(ActionInstances.Num());
+	for (int i = 0; i < ActionInstances.Num(); i++)
+	{
+		const UBaseControllerAction* action = ActionInstances[i];
+		if (action == nullptr)
+			continue;
+		for (int j = 0; j < StatesInstances.Num(); j++)
+		{
+			if (StatesInstances[j] && action->CompatibleStates.Contains(StatesInstances[j]->GetDescriptionName()))
+				_actionStatesMasks[i] |= (uint64)1 << j;
+		}
+		for (int j = 0; j < ActionInstances.Num(); j++)
+		{
+			if (ActionInstances[j] && action->CompatibleActions.Contains(ActionInstances[j]->GetDescriptionName()))
+				_actionActionsMasks[i] |= (uint64)1 << j;
+		}
+	}
+}
+
+
+
 bool UModularControllerComponent::TryChangeControllerAction(int fromActionIndex, int toActionIndex,
 	FKinematicInfos& inDatas, FVector moveInput, const float inDelta, FStatusParameters& currentStatus, const bool transitionToSelf, bool simulate)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_StatusDebug);
 	if (fromActionIndex == toActionIndex)
 	{
 		if (!transitionToSelf)
 			return false;
 	}
 
-	if (!simulate && DebugType == ControllerDebugType_StatusDebug)
+	if (!simulate && bDebug)
 	{
 		UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Trying to change action from: %d to: %d"), fromActionIndex, toActionIndex), true, true
 			, FColor::White, 5, TEXT("TryChangeControllerActions_1"));
@@ -1625,13 +2870,14 @@ bool UModularControllerComponent::TryChangeControllerAction(int fromActionIndex,
 		{
 			currentStatus.ActionVelocityConservation = ActionInstances[fromActionIndex]->EndActionVelocityConservationPercentage;
 		}
-		ActionInstances[fromActionIndex]->SetActivatedLastFrame(false);
-		ActionInstances[fromActionIndex]->OnActionEnds_Internal(inDatas, moveInput, this, currentStatus, inDelta);
+		const FBehaviourRuntimeRef fromActionRuntime = _actionRuntimes[fromActionIndex]->GetRef();
+		fromActionRuntime.Get<FControllerActionRuntime>().bWasActiveFrame = false;
+		ActionInstances[fromActionIndex]->OnActionEnds_Internal(fromActionRuntime, inDatas, moveInput, this, currentStatus, inDelta);
 		if (!simulate)
 		{
-			if (DebugType == ControllerDebugType_StatusDebug)
+			if (bDebug)
 			{
-				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Disabled. Remaining Time: %f"), *ActionInstances[fromActionIndex]->DebugString(), ActionInstances[fromActionIndex]->GetRemainingActivationTime()), true, true, FColor::Red, 5
+				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Disabled. Remaining Time: %f"), *ActionInstances[fromActionIndex]->DebugString(fromActionRuntime), ActionInstances[fromActionIndex]->GetRemainingActivationTime(fromActionRuntime)), true, true, FColor::Red, 5
 					, FName(FString::Printf(TEXT("TryChangeControllerActions_%s"), *ActionInstances[fromActionIndex]->GetDescriptionName().ToString())));
 			}
 		}
@@ -1646,44 +2892,32 @@ bool UModularControllerComponent::TryChangeControllerAction(int fromActionIndex,
 			currentStatus.ActionVelocityConservation = -1;
 		}
 
-		ActionInstances[toActionIndex]->OnActionBegins_Internal(inDatas, moveInput, this, currentStatus, inDelta);
-		ActionInstances[toActionIndex]->SetActivatedLastFrame(true);
+		const FBehaviourRuntimeRef toActionRuntime = _actionRuntimes[toActionIndex]->GetRef();
+		ActionInstances[toActionIndex]->OnActionBegins_Internal(toActionRuntime, inDatas, moveInput, this, currentStatus, inDelta);
+		toActionRuntime.Get<FControllerActionRuntime>().bWasActiveFrame = true;
 		if (!simulate)
 		{
-			if (DebugType == ControllerDebugType_StatusDebug)
+			if (bDebug)
 			{
-				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Activated. Remaining Time: %f"), *ActionInstances[toActionIndex]->DebugString(), ActionInstances[toActionIndex]->GetRemainingActivationTime()), true, true, FColor::Green, 5
+				UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Activated. Remaining Time: %f"), *ActionInstances[toActionIndex]->DebugString(toActionRuntime), ActionInstances[toActionIndex]->GetRemainingActivationTime(toActionRuntime)), true, true, FColor::Green, 5
 					, FName(FString::Printf(TEXT("TryChangeControllerActions_%s"), *ActionInstances[toActionIndex]->GetDescriptionName().ToString())));
 			}
 		}
 	}
 
-	//Notify actions and states
-	if (!simulate)
-	{
-		for (int i = 0; i < StatesInstances.Num(); i++)
-		{
-			StatesInstances[i]->OnActionChanged(ActionInstances.IsValidIndex(toActionIndex) ? ActionInstances[toActionIndex] : nullptr
-				, ActionInstances.IsValidIndex(fromActionIndex) ? ActionInstances[fromActionIndex] : nullptr);
-		}
-
-		for (int i = 0; i < ActionInstances.Num(); i++)
-		{
-			ActionInstances[i]->OnActionChanged(ActionInstances.IsValidIndex(toActionIndex) ? ActionInstances[toActionIndex] : nullptr
-				, ActionInstances.IsValidIndex(fromActionIndex) ? ActionInstances[fromActionIndex] : nullptr);
-		}
-	}
-
 	if (!simulate)
 	{
 		CurrentActionIndex = toActionIndex;
+		ScheduleActionTimers(fromActionIndex);
+		if (toActionIndex != fromActionIndex)
+			ScheduleActionTimers(toActionIndex);
+		DispatchActionTimers();
 
-		OnControllerActionChanged(ActionInstances.IsValidIndex(toActionIndex) ? ActionInstances[toActionIndex] : nullptr
-			, ActionInstances.IsValidIndex(fromActionIndex) ? ActionInstances[fromActionIndex] : nullptr);
-		OnControllerActionChangedEvent.Broadcast(ActionInstances.IsValidIndex(toActionIndex) ? ActionInstances[toActionIndex] : nullptr
+		//Notify actions and states on the flush
+		QueueTransitionEvent(true, ActionInstances.IsValidIndex(toActionIndex) ? ActionInstances[toActionIndex] : nullptr
 			, ActionInstances.IsValidIndex(fromActionIndex) ? ActionInstances[fromActionIndex] : nullptr);
 
-		if (DebugType == ControllerDebugType_StatusDebug)
+		if (bDebug)
 		{
 			UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Changed actions from: %d  to: %d"), fromActionIndex, toActionIndex), true, true
 				, FColor::Yellow, 5, TEXT("TryChangeControllerActions_2"));
@@ -1698,6 +2932,7 @@ FVelocity UModularControllerComponent::ProcessControllerAction(FStatusParameters
 	const FKinematicInfos& inDatas, FVelocity fromStateVelocity, const FVector moveInput, const float inDelta, int simulatedStateIndex,
 	int simulatedActionIndex)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_StatusDebug);
 	FVelocity actionVelocity = fromStateVelocity;
 	const FQuat initialRotation = fromStateVelocity.Rotation;
 	int activeActionIndex = simulatedActionIndex >= 0 ? simulatedActionIndex : CurrentActionIndex;
@@ -1707,9 +2942,9 @@ FVelocity UModularControllerComponent::ProcessControllerAction(FStatusParameters
 		actionVelocity = ProcessSingleAction(ActionInstances[activeActionIndex], controllerStatus, inDatas, fromStateVelocity, moveInput
 			, inDelta, simulatedStateIndex, simulatedActionIndex);
 
-		if (DebugType == ControllerDebugType_StatusDebug)
+		if (bDebug)
 		{
-			UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Processed. Remaining Time: %f"), *ActionInstances[activeActionIndex]->DebugString(), ActionInstances[activeActionIndex]->GetRemainingActivationTime()), true, true, FColor::White, 5
+			UKismetSystemLibrary::PrintString(GetWorld(), FString::Printf(TEXT("Action (%s) is Being Processed. Remaining Time: %f"), *ActionInstances[activeActionIndex]->DebugString(_actionRuntimes[activeActionIndex]->GetRef()), ActionInstances[activeActionIndex]->GetRemainingActivationTime(_actionRuntimes[activeActionIndex]->GetRef())), true, true, FColor::White, 5
 				, FName(FString::Printf(TEXT("ProcessControllerActions_%s"), *ActionInstances[activeActionIndex]->GetDescriptionName().ToString())));
 		}
 	}
@@ -1729,14 +2964,18 @@ FVelocity UModularControllerComponent::ProcessSingleAction(UBaseControllerAction
 	int stateIndex = simulatedStateIndex >= 0 ? simulatedStateIndex : CurrentStateIndex;
 	int activeActionIndex = simulatedActionIndex >= 0 ? simulatedActionIndex : CurrentActionIndex;
 
+	FBehaviourSnapShotRing* actionRuntime = FindBehaviourRing(actionInstance);
+	if (actionRuntime == nullptr)
+		return previousVelocity;
+
 	//Handle state snapshot
 	if (simulatedStateIndex >= 0 || simulatedActionIndex >= 0)
-		actionInstance->SaveActionSnapShot();
+		UBaseControllerAction::SaveActionSnapShot(*actionRuntime);
 	else
-		actionInstance->RestoreActionFromSnapShot();
+		UBaseControllerAction::RestoreActionFromSnapShot(*actionRuntime);
 
 	FVelocity processMotion = movement;
-	processMotion = actionInstance->OnActionProcess_Internal(controllerStatus, inDatas, previousVelocity, moveInput, this, inDelta);
+	processMotion = actionInstance->OnActionProcess_Internal(actionRuntime->GetRef(), controllerStatus, inDatas, previousVelocity, moveInput, this, inDelta);
 
 	if (actionInstance->RootMotionMode != ERootMotionType::RootMotionType_No_RootMotion)
 	{
@@ -1840,6 +3079,7 @@ USkeletalMeshComponent* UModularControllerComponent::GetSkeletalMesh()
 double UModularControllerComponent::PlayAnimationMontage_Internal(FActionMotionMontage Montage, float customAnimStartTime
 	, bool useMontageEndCallback, FOnMontageEnded endCallBack)
 {
+	WakeUp();
 	if (const USkeletalMeshComponent* mesh = GetSkeletalMesh())
 	{
 		UAnimInstance* animInstance = mesh->GetAnimInstance();
@@ -1852,6 +3092,7 @@ double UModularControllerComponent::PlayAnimationMontage_Internal(FActionMotionM
 double UModularControllerComponent::PlayAnimationMontageOnState_Internal(FActionMotionMontage Montage, FName stateName, float customAnimStartTime
 	, bool useMontageEndCallback, FOnMontageEnded endCallBack)
 {
+	WakeUp();
 	if (const USkeletalMeshComponent* mesh = GetSkeletalMesh())
 	{
 		const UBaseControllerState* state = GetControllerStateByName(stateName);
@@ -2120,6 +3361,8 @@ void UModularControllerComponent::Move_Implementation(const FVector endLocation,
 
 FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDatas, FVelocity movement, float delta, bool noCollision)
 {
+	const bool bDebugPhysic = IsDebugging(ControllerDebugType_PhysicDebug);
+	const bool bDebugMovement = IsDebugging(ControllerDebugType_MovementDebug);
 	auto owner = GetOwner();
 	FVelocity result = FVelocity::Null();
 	result.ActionStartLinearVelocity = movement.ActionStartLinearVelocity;
@@ -2139,7 +3382,7 @@ FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDat
 	{
 		priMove += (_collisionForces / inDatas.GetMass()) * (priMove.Length() > 0 ? FMath::Clamp(FVector::DotProduct(priMove.GetSafeNormal(), _collisionForces.GetSafeNormal()), 0, 1) : 1);
 		//priMove += _collisionForces;
-		if (DebugType == ControllerDebugType_PhysicDebug)
+		if (bDebugPhysic)
 		{
 			GEngine->AddOnScreenDebugMessage((int32)GetOwner()->GetUniqueID() + 10, 1, FColor::Green, FString::Printf(TEXT("Applying collision force: %s"), *_collisionForces.ToString()));
 		}
@@ -2149,9 +3392,8 @@ FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDat
 	//Primary Movement (momentum movement)
 	{
 		FHitResult sweepMoveHit = FHitResult(EForceInit::ForceInitToZero);
-		bool blockingHit = false;
-
-		blockingHit = noCollision ? false : ComponentTraceCastSingle(sweepMoveHit, initialLocation, priMove * delta, primaryRotation, 0.100, bUseComplexCollision);
+		const FComponentSweepRequest primarySweep(initialLocation, priMove * delta);
+		const bool blockingHit = noCollision ? false : ComponentTraceCastBatch(MakeArrayView(&sweepMoveHit, 1), MakeArrayView(&primarySweep, 1), primaryRotation, 0.100, bUseComplexCollision) > 0;
 		if (blockingHit)
 		{
 			//Push objects around
@@ -2160,7 +3402,18 @@ FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDat
 				float dotProduct = FVector::DotProduct(pushObjectForce.GetSafeNormal(), sweepMoveHit.ImpactNormal.GetSafeNormal());
 				if (sweepMoveHit.GetComponent()->IsSimulatingPhysics())
 				{
-					sweepMoveHit.GetComponent()->AddForceAtLocation(pushObjectForce * inDatas.GetMass() * FMath::Clamp(-dotProduct, 0, 1), sweepMoveHit.ImpactPoint, sweepMoveHit.BoneName);
+					const FVector pushForce = pushObjectForce * inDatas.GetMass() * FMath::Clamp(-dotProduct, 0, 1);
+					if (_deferPhysicInteractions)
+					{
+						_phasedUpdate.PushedComponent = sweepMoveHit.GetComponent();
+						_phasedUpdate.PushForce = pushForce;
+						_phasedUpdate.PushLocation = sweepMoveHit.ImpactPoint;
+						_phasedUpdate.PushBoneName = sweepMoveHit.BoneName;
+					}
+					else
+					{
+						sweepMoveHit.GetComponent()->AddForceAtLocation(pushForce, sweepMoveHit.ImpactPoint, sweepMoveHit.BoneName);
+					}
 				}
 			}
 
@@ -2178,8 +3431,9 @@ FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDat
 	{
 		FHitResult sweepMoveHit;
 		
+		const FComponentSweepRequest secondarySweep(location, secMove);
 		if (!noCollision)
-			ComponentTraceCastSingle(sweepMoveHit, location, secMove, primaryRotation, 0.100, bUseComplexCollision);
+			ComponentTraceCastBatch(MakeArrayView(&sweepMoveHit, 1), MakeArrayView(&secondarySweep, 1), primaryRotation, 0.100, bUseComplexCollision);
 
 		FVector newLocation = noCollision ? location + secMove : (sweepMoveHit.IsValidBlockingHit() ? sweepMoveHit.Location : sweepMoveHit.TraceEnd);
 		if (!noCollision)
@@ -2188,7 +3442,7 @@ FVelocity UModularControllerComponent::EvaluateMove(const FKinematicInfos& inDat
 			if (CheckPenetrationAt(depenetrationForce, newLocation, primaryRotation))
 			{
 				newLocation += depenetrationForce;
-				if (DebugType == ControllerDebugType_MovementDebug)
+				if (bDebugMovement)
 				{
 					UKismetSystemLibrary::DrawDebugArrow(this, newLocation, newLocation + depenetrationForce, 50, FColor::Red, 0, 3);
 				}
@@ -2235,6 +3489,7 @@ void UModularControllerComponent::PostMoveUpdate(FKinematicInfos& inDatas, const
 
 FQuat UModularControllerComponent::HandleRotation(const FVelocity inVelocities, const FKinematicInfos inDatas, const float inDelta) const
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_MovementDebug);
 	//Get the good upright vector
 	FVector desiredUpVector = -inDatas.Gravity.GetSafeNormal();
 	if (!desiredUpVector.Normalize())
@@ -2257,7 +3512,7 @@ FQuat UModularControllerComponent::HandleRotation(const FVelocity inVelocities,
 	}
 	if (!virtualRightDir.Normalize())
 	{
-		if (DebugType == ControllerDebugType_MovementDebug)
+		if (bDebug)
 		{
 			GEngine->AddOnScreenDebugMessage(152, 1, FColor::Red, FString::Printf(TEXT("Cannot normalize right vector: up = %s, fwd= %s"), *desiredUpVector.ToCompactString(), *virtualFwdDir.ToCompactString()));
 		}
@@ -2280,13 +3535,14 @@ FQuat UModularControllerComponent::HandleRotation(const FVelocity inVelocities,
 
 FVector UModularControllerComponent::SlideAlongSurfaceAt(const FVector& Position, const FQuat& Rotation, const FVector& Delta, float Time, const FVector& Normal, FHitResult& Hit, int& depth)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_PhysicDebug);
 	const FVector OldHitNormal = Normal;
 
 	//Compute slide vector
 	FVector SlideDelta = ComputeSlideVector(Delta, Time, Normal, Hit);
 	FVector endLocation = Position + SlideDelta;
 
-	if (DebugType == ControllerDebugType_PhysicDebug)
+	if (bDebug)
 	{
 		UKismetSystemLibrary::DrawDebugArrow(this, Position, Position + Normal.GetSafeNormal() * 30, 50, FColor::Blue);
 		UKismetSystemLibrary::DrawDebugArrow(this, Position, Position + SlideDelta, 50, FColor::Cyan);
@@ -2294,13 +3550,14 @@ FVector UModularControllerComponent::SlideAlongSurfaceAt(const FVector& Position
 
 	if ((SlideDelta | Delta) > 0.f)
 	{
-		if (ComponentTraceCastSingle(Hit, Position, SlideDelta, Rotation, 0.100, bUseComplexCollision))
+		const FComponentSweepRequest slideSweep(Position, SlideDelta);
+		if (ComponentTraceCastBatch(MakeArrayView(&Hit, 1), MakeArrayView(&slideSweep, 1), Rotation, 0.100, bUseComplexCollision) > 0)
 		{
 			// Compute new slide normal when hitting multiple surfaces.
 			FVector move = Hit.TraceEnd - Hit.TraceStart;
 			TwoWallAdjust(move, Hit, OldHitNormal);
 
-			if (DebugType == ControllerDebugType_PhysicDebug)
+			if (bDebug)
 			{
 				UKismetSystemLibrary::DrawDebugArrow(this, Hit.Location, Hit.Location + move, 50, FColor::Purple);
 				DrawCircle(GetWorld(), Hit.Location, GetRotation().GetAxisX(), GetRotation().GetAxisY(), FColor::Purple, 25, 32, false, -1, 0, 3);
@@ -2312,21 +3569,22 @@ FVector UModularControllerComponent::SlideAlongSurfaceAt(const FVector& Position
 			if (!move.IsNearlyZero(1e-3f) && (move | SlideDelta) > 0.f)
 			{
 				FHitResult secondaryMove;
+				const FComponentSweepRequest secondarySweep(Hit.Location, move);
 				// Perform second move
-				if (ComponentTraceCastSingle(secondaryMove, Hit.Location, move, Rotation, 0.100, bUseComplexCollision))
+				if (ComponentTraceCastBatch(MakeArrayView(&secondaryMove, 1), MakeArrayView(&secondarySweep, 1), Rotation, 0.100, bUseComplexCollision) > 0)
 				{
 					if (depth > 0) {
 						depth--;
 						endLocation = SlideAlongSurfaceAt(secondaryMove.Location, Rotation, secondaryMove.TraceEnd - secondaryMove.TraceStart, 1 - secondaryMove.Time, secondaryMove.Normal, secondaryMove, depth);
 						secondaryMove.Location = endLocation;
-						if (DebugType == ControllerDebugType_PhysicDebug)
+						if (bDebug)
 						{
 							DrawCircle(GetWorld(), endLocation, GetRotation().GetAxisX(), GetRotation().GetAxisY(), FColor::Yellow, 25, 32, false, -1, 0, 3);
 						}
 					}
 					else {
 						endLocation = secondaryMove.Location;
-						if (DebugType == ControllerDebugType_PhysicDebug)
+						if (bDebug)
 						{
 							DrawCircle(GetWorld(), endLocation, GetRotation().GetAxisX(), GetRotation().GetAxisY(), FColor::Orange, 25, 32, false, -1, 0, 3);
 						}
@@ -2336,7 +3594,7 @@ FVector UModularControllerComponent::SlideAlongSurfaceAt(const FVector& Position
 				{
 					endLocation = secondaryMove.TraceEnd;
 
-					if (DebugType == ControllerDebugType_PhysicDebug)
+					if (bDebug)
 					{
 						DrawCircle(GetWorld(), endLocation, GetRotation().GetAxisX(), GetRotation().GetAxisY(), FColor::Red, 25, 32, false, -1, 0, 3);
 					}
@@ -2361,22 +3619,12 @@ FVector UModularControllerComponent::SlideAlongSurfaceAt(const FVector& Position
 
 bool UModularControllerComponent::ComponentTraceCastMulti(TArray<FHitResult>& outHits, FVector position, FVector direction, FQuat rotation, double inflation, bool traceComplex)
 {
-	auto owner = GetOwner();
-	if (owner == nullptr)
-		return false;
-
-	UPrimitiveComponent* primitive = UpdatedPrimitive;
-	if (!primitive)
+	const FCollisionQueryParams* queryParams = nullptr;
+	FCollisionShape shape;
+	if (!GetComponentTraceQuery(queryParams, shape, inflation, traceComplex))
 		return false;
 
-	FCollisionQueryParams queryParams;
-	queryParams.AddIgnoredActor(owner);
-	queryParams.bTraceComplex = traceComplex;
-	queryParams.bReturnPhysicalMaterial = true;
-	float OverlapInflation = inflation;
-	auto shape = primitive->GetCollisionShape(OverlapInflation);
-
-	if (GetWorld()->SweepMultiByChannel(outHits, position, position + direction, rotation, primitive->GetCollisionObjectType(), shape, queryParams, FCollisionResponseParams::DefaultResponseParam))
+	if (GetWorld()->SweepMultiByChannel(outHits, position, position + direction, rotation, UpdatedPrimitive->GetCollisionObjectType(), shape, *queryParams, FCollisionResponseParams::DefaultResponseParam))
 	{
 		for (int i = 0; i < outHits.Num(); i++)
 		{
@@ -2392,32 +3640,125 @@ bool UModularControllerComponent::ComponentTraceCastMulti(TArray<FHitResult>& ou
 
 bool UModularControllerComponent::ComponentTraceCastSingle(FHitResult& outHit, FVector position, FVector direction, FQuat rotation, double inflation, bool traceComplex)
 {
-	outHit.Location = position;
-	auto owner = GetOwner();
-	if (owner == nullptr)
-		return false;
+	const FComponentSweepRequest request(position, direction);
+	return ComponentTraceCastBatch(MakeArrayView(&outHit, 1), MakeArrayView(&request, 1), rotation, inflation, traceComplex) > 0;
+}
 
-	UPrimitiveComponent* primitive = UpdatedPrimitive;
-	if (!primitive)
-		return false;
 
-	FCollisionQueryParams queryParams;
-	queryParams.AddIgnoredActor(owner);
-	queryParams.bTraceComplex = traceComplex;
-	queryParams.bReturnPhysicalMaterial = true;
-	float OverlapInflation = inflation;
-	auto shape = primitive->GetCollisionShape(OverlapInflation);
+int UModularControllerComponent::ComponentTraceCastBatch(TArray<FHitResult>& outHits, const TArray<FComponentSweepRequest>& requests, FQuat rotation, double inflation, bool traceComplex, bool stopOnHit)
+{
+	outHits.SetNum(requests.Num());
+	const int hitCount = ComponentTraceCastBatch(MakeArrayView(outHits), MakeArrayView(requests), rotation, inflation, traceComplex, stopOnHit);
 
-	if (GetWorld()->SweepSingleByChannel(outHit, position, position + direction, rotation, primitive->GetCollisionObjectType(), shape, queryParams))
+	//The requests left after the first hit were not swept.
+	if (stopOnHit && hitCount > 0)
 	{
-		outHit.Location -= direction.GetSafeNormal() * 0.125f;
-		return true;
+		for (int i = 0; i < outHits.Num(); i++)
+		{
+			if (!outHits[i].bBlockingHit)
+				continue;
+			outHits.SetNum(i + 1);
+			break;
+		}
 	}
-	else
+	return hitCount;
+}
+
+
+int UModularControllerComponent::ComponentTraceCastBatch(TArrayView<FHitResult> outHits, TConstArrayView<FComponentSweepRequest> requests, FQuat rotation, double inflation, bool traceComplex, bool stopOnHit)
+{
+	check(outHits.Num() >= requests.Num());
+	const FCollisionQueryParams* queryParams = nullptr;
+	FCollisionShape shape;
+	const bool canSweep = GetComponentTraceQuery(queryParams, shape, inflation, traceComplex);
+	const UWorld* world = GetWorld();
+	const ECollisionChannel channel = canSweep ? UpdatedPrimitive->GetCollisionObjectType() : ECC_Pawn;
+
+	int hitCount = 0;
+	for (int i = 0; i < requests.Num(); i++)
 	{
-		return false;
+		const FComponentSweepRequest& request = requests[i];
+		FHitResult& hit = outHits[i];
+		bool haveHit = false;
+
+		//Same trace this frame
+		const FComponentTraceCacheEntry* cached = nullptr;
+		if (bUseTraceCache)
+		{
+			cached = _traceCache.FindByPredicate([&](const FComponentTraceCacheEntry& entry)
+			{
+				return entry.Position == request.Position && entry.Direction == request.Direction && entry.Rotation == rotation && entry.Inflation == inflation && entry.bTraceComplex == traceComplex;
+			});
+		}
+
+		if (cached)
+		{
+			_traceCacheHits++;
+			hit = cached->Hit;
+			haveHit = cached->bHit;
+		}
+		else
+		{
+			hit.Location = request.Position;
+			if (!canSweep)
+				continue;
+			if (world->SweepSingleByChannel(hit, request.Position, request.Position + request.Direction, rotation, channel, shape, *queryParams))
+			{
+				hit.Location -= request.Direction.GetSafeNormal() * 0.125f;
+				haveHit = true;
+			}
+
+			if (bUseTraceCache)
+			{
+				_traceCacheMisses++;
+				if (_traceCache.Num() < TraceCacheCapacity)
+					_traceCache.Add({ request.Position, request.Direction, rotation, inflation, traceComplex, haveHit, hit });
+			}
+		}
+
+		if (!haveHit)
+			continue;
+		hitCount++;
+		if (stopOnHit)
+			break;
 	}
+	return hitCount;
+}
+
+
+FTraceHandle UModularControllerComponent::AsyncComponentTraceCast(FVector position, FVector direction, FQuat rotation, double inflation, bool traceComplex)
+{
+	const FCollisionQueryParams* queryParams = nullptr;
+	FCollisionShape shape;
+	if (!GetComponentTraceQuery(queryParams, shape, inflation, traceComplex))
+		return FTraceHandle();
+
+	return GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, position, position + direction, rotation, UpdatedPrimitive->GetCollisionObjectType(), shape, *queryParams);
+}
+
+
+bool UModularControllerComponent::QueryAsyncComponentTraceCast(const FTraceHandle& handle, FHitResult& outHit) const
+{
+	if (!handle.IsValid() || GetWorld() == nullptr)
+		return false;
+
+	FTraceDatum datum;
+	if (!GetWorld()->QueryTraceData(handle, datum))
+		return false;
 
+	outHit = FHitResult();
+	outHit.TraceStart = datum.Start;
+	outHit.TraceEnd = datum.End;
+	outHit.Location = datum.Start;
+	for (const FHitResult& hit : datum.OutHits)
+	{
+		if (!hit.bBlockingHit)
+			continue;
+		outHit = hit;
+		outHit.Location -= (datum.End - datum.Start).GetSafeNormal() * 0.125f;
+		break;
+	}
+	return true;
 }
 
 
@@ -2432,16 +3773,39 @@ void UModularControllerComponent::PathCastComponent(TArray<FHitResult>& results,
 		return;
 
 	results.Empty();
-	FCollisionQueryParams queryParams;
-	queryParams.AddIgnoredActor(owner);
-	queryParams.bTraceComplex = traceComplex;
-	queryParams.bReturnPhysicalMaterial = true;
 
+	//The segments don't depend on each other, sweep them as a batch.
+	if (!rotateAlongPath && !bendOnCollision)
+	{
+		TArray<FComponentSweepRequest> requests;
+		requests.Reserve(pathPoints.Num());
+		for (int i = 0; i < pathPoints.Num(); i++)
+		{
+			const FVector in = i <= 0 ? start : pathPoints[i - 1];
+			requests.Add(FComponentSweepRequest(in, pathPoints[i] - in));
+		}
+		ComponentTraceCastBatch(results, requests, GetRotation(), skinWeight, traceComplex, stopOnHit);
+		if (debugRay)
+		{
+			for (int i = 0; i < results.Num(); i++)
+			{
+				UKismetSystemLibrary::DrawDebugArrow(this, results[i].TraceStart, results[i].TraceEnd, 15, results[i].Component != nullptr ? FColor::Green : FColor::Silver, 0, 15);
+				if (results[i].Component != nullptr)
+				{
+					UKismetSystemLibrary::DrawDebugPoint(this, results[i].ImpactPoint, 30, FColor::Green, 0);
+					UKismetSystemLibrary::DrawDebugArrow(this, results[i].ImpactPoint, results[i].ImpactPoint + results[i].ImpactNormal, 15, FColor::Red, 0, 15);
+					UKismetSystemLibrary::DrawDebugArrow(this, results[i].ImpactPoint, results[i].ImpactPoint + results[i].Normal, 15, FColor::Orange, 0, 15);
+				}
+			}
+		}
+		return;
+	}
 
-	UPrimitiveComponent* primitive = UpdatedPrimitive;
-	if (!primitive)
+	const FCollisionQueryParams* queryParams = nullptr;
+	FCollisionShape shape;
+	if (!GetComponentTraceQuery(queryParams, shape, skinWeight, traceComplex))
 		return;
-	auto shape = primitive->GetCollisionShape(skinWeight);
+	UPrimitiveComponent* primitive = UpdatedPrimitive;
 
 	for (int i = 0; i < pathPoints.Num(); i++)
 	{
@@ -2449,7 +3813,7 @@ void UModularControllerComponent::PathCastComponent(TArray<FHitResult>& results,
 		FVector in = i <= 0 ? start : pathPoints[i - 1];
 		FVector out = pathPoints[i];
 		GetWorld()->SweepSingleByChannel(soloHit, in, out, rotateAlongPath ? (out - in).Rotation().Quaternion() : GetRotation()
-			, primitive->GetCollisionObjectType(), shape, queryParams, FCollisionResponseParams::DefaultResponseParam);
+			, primitive->GetCollisionObjectType(), shape, *queryParams, FCollisionResponseParams::DefaultResponseParam);
 		if (debugRay)
 		{
 			UKismetSystemLibrary::DrawDebugArrow(this, in, out, 15, soloHit.Component != nullptr ? FColor::Green : FColor::Silver, 0, 15);
@@ -2490,17 +3854,16 @@ void UModularControllerComponent::PathCastLine(TArray<FHitResult>& results, FVec
 		return;
 
 	results.Empty();
-	FCollisionQueryParams queryParams;
-	queryParams.AddIgnoredActor(owner);
-	queryParams.bTraceComplex = traceComplex;
-	queryParams.bReturnPhysicalMaterial = true;
+	const FCollisionQueryParams* queryParams = GetComponentTraceParams(traceComplex, true);
+	if (!queryParams)
+		return;
 
 	for (int i = 0; i < pathPoints.Num(); i++)
 	{
 		FHitResult soloHit;
 		FVector in = i <= 0 ? start : pathPoints[i - 1];
 		FVector out = pathPoints[i];
-		GetWorld()->LineTraceSingleByChannel(soloHit, in, out, channel, queryParams, FCollisionResponseParams::DefaultResponseParam);
+		GetWorld()->LineTraceSingleByChannel(soloHit, in, out, channel, *queryParams, FCollisionResponseParams::DefaultResponseParam);
 		if (debugRay)
 		{
 			UKismetSystemLibrary::DrawDebugArrow(this, in, out, 15, soloHit.Component != nullptr ? FColor::Green : FColor::Silver, 0, 15);
@@ -2530,6 +3893,7 @@ void UModularControllerComponent::PathCastLine(TArray<FHitResult>& results, FVec
 
 bool UModularControllerComponent::CheckPenetrationAt(FVector& force, FVector position, FQuat NewRotationQuat, UPrimitiveComponent* onlyThisComponent)
 {
+	const bool bDebug = IsDebugging(ControllerDebugType_PhysicDebug);
 	{
 		FVector moveVec = FVector(0);
 		auto owner = GetOwner();
@@ -2541,21 +3905,23 @@ bool UModularControllerComponent::CheckPenetrationAt(FVector& force, FVector pos
 			return false;
 		bool overlapFound = false;
 		TArray<FOverlapResult> _overlaps;
-		FComponentQueryParams comQueryParams;
-		comQueryParams.AddIgnoredActor(owner);
-		if (GetWorld()->OverlapMultiByChannel(_overlaps, position, NewRotationQuat, primitive->GetCollisionObjectType(), primitive->GetCollisionShape(0.125f), comQueryParams))
+		const FCollisionQueryParams* comQueryParams = nullptr;
+		FCollisionShape shape;
+		if (!GetComponentTraceQuery(comQueryParams, shape, 0.125f, false, false))
+			return false;
+		if (GetWorld()->OverlapMultiByChannel(_overlaps, position, NewRotationQuat, primitive->GetCollisionObjectType(), shape, *comQueryParams))
 		{
 			FMTDResult depenetrationInfos;
 			for (auto& overlap : _overlaps)
 			{
-				if (DebugType == ControllerDebugType_PhysicDebug)
+				if (bDebug)
 				{
 					UKismetSystemLibrary::DrawDebugPoint(this, position, 10, FColor::Blue);
 				}
 				if (!overlapFound)
 					overlapFound = true;
 
-				if (overlap.Component->ComputePenetration(depenetrationInfos, primitive->GetCollisionShape(0.125f), position, NewRotationQuat))
+				if (overlap.Component->ComputePenetration(depenetrationInfos, shape, position, NewRotationQuat))
 				{
 					const FVector depForce = depenetrationInfos.Direction * (depenetrationInfos.Distance + 0.125f);
 					if (onlyThisComponent == overlap.Component)
@@ -2602,4 +3968,102 @@ FVector UModularControllerComponent::PointOnShape(FVector direction, const FVect
 }
 
 
+bool UModularControllerComponent::GetComponentTraceQuery(const FCollisionQueryParams*& outParams, FCollisionShape& outShape, double inflation, bool traceComplex, bool returnPhysicalMaterial)
+{
+	outParams = GetComponentTraceParams(traceComplex, returnPhysicalMaterial);
+	if (!outParams)
+		return false;
+	return GetComponentTraceShape(outShape, inflation);
+}
+
+
+const FCollisionQueryParams* UModularControllerComponent::GetComponentTraceParams(bool traceComplex, bool returnPhysicalMaterial)
+{
+	const AActor* owner = GetOwner();
+	if (owner == nullptr)
+		return nullptr;
+
+	//The move ignored actors changes are notified by InvalidateTraceQueryCache.
+	if (_traceParamsOwner.Get() != owner)
+	{
+		_traceParamsOwner = owner;
+		for (TOptional<FCollisionQueryParams>& params : _traceParams)
+			params.Reset();
+	}
+
+	TOptional<FCollisionQueryParams>& params = _traceParams[(traceComplex ? 1 : 0) + (returnPhysicalMaterial ? 2 : 0)];
+	if (!params.IsSet())
+	{
+		FCollisionQueryParams& newParams = params.Emplace();
+		newParams.AddIgnoredActor(owner);
+		if (UpdatedPrimitive)
+		{
+			for (const AActor* ignored : UpdatedPrimitive->GetMoveIgnoreActors())
+				newParams.AddIgnoredActor(ignored);
+		}
+		newParams.bTraceComplex = traceComplex;
+		newParams.bReturnPhysicalMaterial = returnPhysicalMaterial;
+	}
+	return &params.GetValue();
+}
+
+
+bool UModularControllerComponent::GetComponentTraceShape(FCollisionShape& outShape, double inflation)
+{
+	const UPrimitiveComponent* primitive = UpdatedPrimitive;
+	if (!primitive)
+		return false;
+
+	//Other primitives get a box from their world bounds, which changes with the rotation. Not worth caching.
+	if (!primitive->IsA<UShapeComponent>())
+	{
+		float OverlapInflation = inflation;
+		outShape = primitive->GetCollisionShape(OverlapInflation);
+		return true;
+	}
+
+	//A new primitive. Resizes and scales are notified by InvalidateTraceQueryCache.
+	if (_traceShapeSource.Get() != primitive)
+	{
+		_traceShapeSource = primitive;
+		_traceShapes.Reset();
+	}
+
+	for (const TPair<double, FCollisionShape>& cached : _traceShapes)
+	{
+		if (cached.Key == inflation)
+		{
+			outShape = cached.Value;
+			return true;
+		}
+	}
+
+	float OverlapInflation = inflation;
+	outShape = primitive->GetCollisionShape(OverlapInflation);
+	if (_traceShapes.Num() < TraceShapeCacheCapacity)
+		_traceShapes.Add(TPair<double, FCollisionShape>(inflation, outShape));
+	return true;
+}
+
+
+void UModularControllerComponent::InvalidateTraceQueryCache()
+{
+	_traceParamsOwner = nullptr;
+	for (TOptional<FCollisionQueryParams>& params : _traceParams)
+		params.Reset();
+	_traceShapeSource = nullptr;
+	_traceShapes.Reset();
+	InvalidateTraceCache();
+}
+
+
+void UModularControllerComponent::SetMoveIgnoreActor(AActor* actor, bool shouldIgnore)
+{
+	if (UpdatedPrimitive == nullptr || actor == nullptr)
+		return;
+	UpdatedPrimitive->IgnoreActorWhenMoving(actor, shouldIgnore);
+	InvalidateTraceQueryCache();
+}
+
+
 #pragma endregion
@@ -0,0 +1,358 @@
+// Copyright © 2023 by Tyni Boat. All Rights Reserved.
+
+#include "ComponentAndBase/ModularControllerSubsystem.h"
+#include "ComponentAndBase/ModularControllerComponent.h"
+#include "ComponentAndBase/BaseControllerState.h"
+#include "ComponentAndBase/BaseControllerAction.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+
+
+static TAutoConsoleVariable<bool> CVarParallelIntegration(
+	TEXT("mc.ParallelIntegration"),
+	true,
+	TEXT("Run the integration phase of the modular controllers on worker threads."));
+
+static TAutoConsoleVariable<int32> CVarUpdateTierInterval(
+	TEXT("mc.UpdateTierInterval"),
+	8,
+	TEXT("The number of frames between two evaluations of the modular controllers update tiers. 0 disables the update tiers."));
+
+
+
+#pragma region Tick Function XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+
+
+void FModularControllerBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Subsystem == nullptr || TickType == LEVELTICK_ViewportsOnly)
+		return;
+	Subsystem->UpdateControllers(DeltaTime);
+}
+
+
+FString FModularControllerBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FModularControllerBatchTickFunction");
+}
+
+
+FName FModularControllerBatchTickFunction::DiagnosticContext(bool bDetailed)
+{
+	return FName(TEXT("ModularControllerBatchTick"));
+}
+
+
+#pragma endregion
+
+
+
+#pragma region Subsystem XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+
+
+void UModularControllerSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	_updateGroups.SetNum(ControllerUpdateGroup_MAX);
+
+	_batchTickFunction.Subsystem = this;
+	_batchTickFunction.bCanEverTick = true;
+	_batchTickFunction.bStartWithTickEnabled = true;
+	_batchTickFunction.bTickEvenWhenPaused = false;
+	_batchTickFunction.TickGroup = ETickingGroup::TG_PrePhysics;
+}
+
+
+void UModularControllerSubsystem::Deinitialize()
+{
+	if (_batchTickFunction.IsTickFunctionRegistered())
+	{
+		_batchTickFunction.UnRegisterTickFunction();
+	}
+	_batchTickFunction.Subsystem = nullptr;
+	_registeredControllers.Empty();
+	_updateGroups.Empty();
+	_sharedStates.Empty();
+	_sharedActions.Empty();
+	Super::Deinitialize();
+}
+
+
+bool UModularControllerSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+
+void UModularControllerSubsystem::RegisterController(UModularControllerComponent* controller)
+{
+	if (controller == nullptr)
+		return;
+	if (_registeredControllers.Contains(controller))
+		return;
+
+	_registeredControllers.Add(controller);
+	_updateGroupsDirty = true;
+
+	//The tick function is registered with the first controller, once the level is sure to exist.
+	if (!_batchTickFunction.IsTickFunctionRegistered())
+	{
+		UWorld* world = GetWorld();
+		if (world && world->PersistentLevel)
+		{
+			_batchTickFunction.RegisterTickFunction(world->PersistentLevel);
+		}
+	}
+}
+
+
+void UModularControllerSubsystem::AddUpdatePrerequisite(UObject* targetObject, FTickFunction& targetTickFunction)
+{
+	_batchTickFunction.AddPrerequisite(targetObject, targetTickFunction);
+}
+
+
+void UModularControllerSubsystem::RemoveUpdatePrerequisite(UObject* targetObject, FTickFunction& targetTickFunction)
+{
+	_batchTickFunction.RemovePrerequisite(targetObject, targetTickFunction);
+}
+
+
+void UModularControllerSubsystem::UnregisterController(UModularControllerComponent* controller)
+{
+	if (controller == nullptr)
+		return;
+	if (_registeredControllers.RemoveSingleSwap(controller) <= 0)
+		return;
+
+	//The groups might being iterated, just clear the slot and rebuild on next update.
+	for (FModularControllerUpdateGroup& group : _updateGroups)
+	{
+		const int index = group.Controllers.Find(controller);
+		if (index != INDEX_NONE)
+		{
+			group.Controllers[index] = nullptr;
+			break;
+		}
+	}
+	const int phasedIndex = _phasedControllers.Find(controller);
+	if (phasedIndex != INDEX_NONE)
+	{
+		_phasedControllers[phasedIndex] = nullptr;
+	}
+	_updateGroupsDirty = true;
+}
+
+
+bool UModularControllerSubsystem::CanShareDefinition(const UClass* behaviourClass)
+{
+	if (behaviourClass == nullptr)
+		return false;
+	//Blueprint variables, and the event graph frame, are owned by the blueprint class.
+	for (TFieldIterator<FProperty> property(behaviourClass); property; ++property)
+	{
+		const UClass* ownerClass = property->GetOwnerClass();
+		if (ownerClass && !ownerClass->HasAnyClassFlags(CLASS_Native))
+			return false;
+	}
+	return true;
+}
+
+
+UBaseControllerState* UModularControllerSubsystem::GetSharedState(TSubclassOf<UBaseControllerState> stateClass)
+{
+	if (!CanShareDefinition(stateClass))
+		return nullptr;
+	if (UBaseControllerState** shared = _sharedStates.Find(stateClass))
+		return *shared;
+
+	UBaseControllerState* instance = NewObject<UBaseControllerState>(this, stateClass);
+	instance->InitializeState();
+	_sharedStates.Add(stateClass, instance);
+	return instance;
+}
+
+
+UBaseControllerAction* UModularControllerSubsystem::GetSharedAction(TSubclassOf<UBaseControllerAction> actionClass)
+{
+	if (!CanShareDefinition(actionClass))
+		return nullptr;
+	if (UBaseControllerAction** shared = _sharedActions.Find(actionClass))
+		return *shared;
+
+	UBaseControllerAction* instance = NewObject<UBaseControllerAction>(this, actionClass);
+	instance->InitializeAction();
+	_sharedActions.Add(actionClass, instance);
+	return instance;
+}
+
+
+double UModularControllerSubsystem::GetLocalNetLatency()
+{
+	if (_netLatencyFrame == GFrameCounter)
+		return _localNetLatency;
+	_netLatencyFrame = GFrameCounter;
+
+	const APlayerController* localController = GetWorld() ? GetWorld()->GetFirstPlayerController() : nullptr;
+	if (localController && localController->PlayerState)
+		_localNetLatency = localController->PlayerState->GetPingInMilliseconds() * 0.0005;
+	return _localNetLatency;
+}
+
+
+void UModularControllerSubsystem::RebuildUpdateGroups()
+{
+	for (FModularControllerUpdateGroup& group : _updateGroups)
+	{
+		group.Controllers.Reset();
+	}
+
+	for (UModularControllerComponent* controller : _registeredControllers)
+	{
+		if (controller == nullptr)
+			continue;
+		_updateGroups[controller->GetUpdateGroup()].Controllers.Add(controller);
+	}
+
+	_updateGroupsDirty = false;
+}
+
+
+void UModularControllerSubsystem::EvaluateUpdateTiers()
+{
+	UWorld* world = GetWorld();
+	if (world == nullptr)
+		return;
+
+	//On clients, only the local player controllers exist. On the server, there is one for each connection.
+	_viewLocations.Reset();
+	for (FConstPlayerControllerIterator iterator = world->GetPlayerControllerIterator(); iterator; ++iterator)
+	{
+		const APlayerController* playerController = iterator->Get();
+		if (playerController == nullptr)
+			continue;
+		FVector viewLocation;
+		FRotator viewRotation;
+		playerController->GetPlayerViewPoint(viewLocation, viewRotation);
+		_viewLocations.Add(viewLocation);
+	}
+
+	for (UModularControllerComponent* controller : _registeredControllers)
+	{
+		if (controller == nullptr || controller->GetOwner() == nullptr || controller->IsSleeping())
+			continue;
+
+		const FVector location = controller->GetOwner()->GetActorLocation();
+		double closestSquared = TNumericLimits<double>::Max();
+		for (const FVector& viewLocation : _viewLocations)
+		{
+			closestSquared = FMath::Min(closestSquared, FVector::DistSquared(location, viewLocation));
+		}
+		const float distance = _viewLocations.Num() > 0 ? FMath::Sqrt(closestSquared) : TNumericLimits<float>::Max();
+
+		controller->SetUpdateTier(EvaluateUpdateTierOverride.IsBound()
+			? EvaluateUpdateTierOverride.Execute(controller, distance)
+			: controller->GetUpdateTierForDistance(distance));
+	}
+}
+
+
+void UModularControllerSubsystem::UpdateControllers(float delta)
+{
+	if (_updateGroupsDirty)
+		RebuildUpdateGroups();
+
+	//Update tiers
+	const int32 tierInterval = CVarUpdateTierInterval.GetValueOnGameThread();
+	if (tierInterval > 0 && (_frameCounter % tierInterval) == 0)
+		EvaluateUpdateTiers();
+	const bool useTiers = tierInterval > 0;
+
+	//Sense and decide, on the game thread. Remote controllers are fully updated here.
+	_phasedControllers.Reset();
+	_parallelControllers.Reset();
+	for (int groupIndex = 0; groupIndex < _updateGroups.Num(); groupIndex++)
+	{
+		// Controllers can be unregistered during the loop, so no ranged for here.
+		TArray<UModularControllerComponent*>& controllers = _updateGroups[groupIndex].Controllers;
+		for (int i = 0; i < controllers.Num(); i++)
+		{
+			UModularControllerComponent* controller = controllers[i];
+			if (controller == nullptr || !controller->IsActive())
+				continue;
+			//Sleeping controllers are woken up by events, only their surface is checked.
+			if (controller->IsSleeping())
+			{
+				controller->ValidateSleepSurface();
+				if (controller->IsSleeping())
+					continue;
+			}
+			const AActor* owner = controller->GetOwner();
+			const float controllerDelta = owner ? delta * owner->CustomTimeDilation : delta;
+			if (useTiers && !controller->IsUpdateFrame(_frameCounter))
+			{
+				controller->SkipUpdateFrame(controllerDelta);
+				continue;
+			}
+			if (controller->BeginPhasedUpdate(useTiers ? controller->ConsumeUpdateDelta(controllerDelta) : controllerDelta))
+			{
+				_phasedControllers.Add(controller);
+			}
+		}
+	}
+
+	//Integrate and commit. Fixed time step controllers can go through several steps in a frame.
+	const bool parallel = CVarParallelIntegration.GetValueOnGameThread();
+	while (_phasedControllers.Num() > 0)
+	{
+		_parallelControllers.Reset();
+		for (UModularControllerComponent* controller : _phasedControllers)
+		{
+			if (controller == nullptr)
+				continue;
+			if (parallel && controller->CanIntegrateInParallel())
+				_parallelControllers.Add(controller);
+			else
+				controller->IntegrationPhase();
+		}
+		ParallelFor(_parallelControllers.Num(), [this](int32 index)
+		{
+			_parallelControllers[index]->IntegrationPhase();
+		}, _parallelControllers.Num() <= 1);
+
+		//Commit, on the game thread. Only keep the controllers with another step to go.
+		int stepping = 0;
+		for (int i = 0; i < _phasedControllers.Num(); i++)
+		{
+			UModularControllerComponent* controller = _phasedControllers[i];
+			if (controller == nullptr)
+				continue;
+			if (controller->EndPhasedUpdate())
+				_phasedControllers[stepping++] = controller;
+		}
+		_phasedControllers.SetNum(stepping);
+	}
+
+	//Notify the transitions of the frame, once every controller committed. Physic sub-steps transitions are notified on the next frame.
+	for (int groupIndex = 0; groupIndex < _updateGroups.Num(); groupIndex++)
+	{
+		// Listeners can unregister controllers, so no ranged for here.
+		TArray<UModularControllerComponent*>& controllers = _updateGroups[groupIndex].Controllers;
+		for (int i = 0; i < controllers.Num(); i++)
+		{
+			if (controllers[i])
+				controllers[i]->FlushTransitionEvents();
+		}
+	}
+
+	_frameCounter++;
+}
+
+
+#pragma endregion
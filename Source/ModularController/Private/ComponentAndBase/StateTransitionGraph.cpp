@@ -0,0 +1,19 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+
+#include "ComponentAndBase/StateTransitionGraph.h"
+
+
+
+bool UStateTransitionGraph::HasTransitionsFrom(FName fromState) const
+{
+	return Transitions.ContainsByPredicate([fromState](const FStateTransitionEdge& edge) { return edge.FromState == fromState; });
+}
+
+
+bool UStateTransitionGraph::IsTransitionAllowed(FName fromState, FName toState) const
+{
+	if (fromState == toState || AlwaysCheckedStates.Contains(toState) || !HasTransitionsFrom(fromState))
+		return true;
+	return Transitions.ContainsByPredicate([fromState, toState](const FStateTransitionEdge& edge) { return edge.FromState == fromState && edge.ToState == toState; });
+}
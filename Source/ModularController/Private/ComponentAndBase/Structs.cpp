@@ -3,3 +3,484 @@
 #pragma once
 
 #include "../../Public/ComponentAndBase/Structs.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+
+
+#pragma region Inputs XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+
+
+namespace
+{
+	//The inputs handles, shared by every pool.
+	struct FInputRegistry
+	{
+		TMap<FName, int32> Handles;
+		TArray<FName> Keys;
+		TArray<uint32> NetIds;
+		TMap<uint32, int32> NetHandles;
+	};
+
+	FInputRegistry& GetInputRegistry()
+	{
+		static FInputRegistry registry;
+		return registry;
+	}
+}
+
+
+int32 UInputEntryPool::RegisterInput(FName key)
+{
+	if (key.IsNone())
+		return INDEX_NONE;
+	FInputRegistry& registry = GetInputRegistry();
+	if (const int32* handle = registry.Handles.Find(key))
+		return *handle;
+	const int32 handle = registry.Keys.Add(key);
+	registry.Handles.Add(key, handle);
+	//FName are case insensitive, and their indexes differ from a machine to another.
+	const uint32 netId = FCrc::StrCrc32(*key.ToString().ToLower());
+	const int32* otherHandle = registry.NetHandles.Find(netId);
+	//The remote machines would take the input for the other key.
+	checkf(!otherHandle && netId != 0, TEXT("Input key %s have the same network id as %s. Rename one of them.")
+		, *key.ToString(), otherHandle ? *registry.Keys[*otherHandle].ToString() : TEXT("None"));
+	registry.NetHandles.Add(netId, handle);
+	registry.NetIds.Add(netId);
+	return handle;
+}
+
+
+int32 UInputEntryPool::FindInput(FName key)
+{
+	const int32* handle = GetInputRegistry().Handles.Find(key);
+	return handle ? *handle : INDEX_NONE;
+}
+
+
+FName UInputEntryPool::GetInputKey(int32 handle)
+{
+	const FInputRegistry& registry = GetInputRegistry();
+	return registry.Keys.IsValidIndex(handle) ? registry.Keys[handle] : NAME_None;
+}
+
+
+int32 UInputEntryPool::GetRegisteredInputCount()
+{
+	return GetInputRegistry().Keys.Num();
+}
+
+
+uint32 UInputEntryPool::GetInputNetId(int32 handle)
+{
+	const FInputRegistry& registry = GetInputRegistry();
+	return registry.NetIds.IsValidIndex(handle) ? registry.NetIds[handle] : 0;
+}
+
+
+int32 UInputEntryPool::FindInputByNetId(uint32 netId)
+{
+	const int32* handle = GetInputRegistry().NetHandles.Find(netId);
+	return handle ? *handle : INDEX_NONE;
+}
+
+
+
+void FInputFrameRing::Initialize(int capacity)
+{
+	_frames.Reset();
+	_frames.SetNum(FMath::Max(capacity, 0));
+	_slotsHandles.Reset();
+	_handlesSlots.Reset();
+}
+
+
+int32 FInputFrameRing::GetOrAddSlot(int32 handle)
+{
+	if (handle < 0)
+		return INDEX_NONE;
+	for (int32 i = _handlesSlots.Num(); i <= handle; i++)
+		_handlesSlots.Add(INDEX_NONE);
+	if (_handlesSlots[handle] == INDEX_NONE)
+		_handlesSlots[handle] = _slotsHandles.Add(handle);
+	return _handlesSlots[handle];
+}
+
+
+void FInputFrameRing::Record(int64 frame, const FVector& moveInput, const UInputEntryPool& pool)
+{
+	if (_frames.Num() <= 0 || frame < 0)
+		return;
+
+	FInputFrame& inputFrame = _frames[frame % _frames.Num()];
+	inputFrame.Frame = frame;
+	inputFrame.MoveInput = FInputFrame::Quantize(moveInput);
+	inputFrame.Listened.Init(false, _slotsHandles.Num());
+	inputFrame.SetSlotCount(_slotsHandles.Num());
+
+	for (int32 handle = 0; handle < pool._slots.Num(); handle++)
+	{
+		const FInputEntrySlot& slot = pool._slots[handle];
+		if (!slot.bPending)
+			continue;
+
+		const int32 slotIndex = GetOrAddSlot(handle);
+		inputFrame.SetSlotCount(_slotsHandles.Num());
+		FInputFrameSlot& frameSlot = inputFrame.Slots[slotIndex];
+		frameSlot.Nature = slot.Pending.Nature;
+		frameSlot.Type = slot.Pending.Type;
+		frameSlot.InputBuffer = slot.Pending.InputBuffer;
+		frameSlot.Axis = slot.Pending.Nature == EInputEntryNature::InputEntryNature_Button ? FIntVector::ZeroValue : FInputFrame::Quantize(slot.Pending.Axis);
+		inputFrame.Listened[slotIndex] = true;
+	}
+}
+
+
+bool FInputFrameRing::Replay(int64 frame, UInputEntryPool& pool, FVector& moveInput) const
+{
+	const FInputFrame* inputFrame = Find(frame);
+	if (!inputFrame)
+		return false;
+
+	moveInput = FInputFrame::Dequantize(inputFrame->MoveInput);
+	for (TConstSetBitIterator<> it(inputFrame->Listened); it; ++it)
+	{
+		const FInputFrameSlot& frameSlot = inputFrame->Slots[it.GetIndex()];
+		FInputEntry entry;
+		entry.Nature = frameSlot.Nature;
+		entry.Type = frameSlot.Type;
+		entry.InputBuffer = frameSlot.InputBuffer;
+		if (frameSlot.Nature != EInputEntryNature::InputEntryNature_Button)
+			entry.Axis = FInputFrame::Dequantize(frameSlot.Axis);
+		pool.AddOrReplace(_slotsHandles[it.GetIndex()], entry);
+	}
+	return true;
+}
+
+
+bool FInputFrameRing::ToBytes(int64 frame, TArray<uint8>& outBytes) const
+{
+	const FInputFrame* inputFrame = Find(frame);
+	if (!inputFrame)
+		return false;
+
+	outBytes.Reset();
+	FMemoryWriter writer(outBytes);
+	int64 frameIndex = inputFrame->Frame;
+	FIntVector moveInput = inputFrame->MoveInput;
+	writer << frameIndex;
+	writer << moveInput.X << moveInput.Y << moveInput.Z;
+
+	//Buttons, then axes.
+	for (const bool buttons : { true, false })
+	{
+		uint16 count = 0;
+		for (TConstSetBitIterator<> it(inputFrame->Listened); it; ++it)
+		{
+			if ((inputFrame->Slots[it.GetIndex()].Nature == EInputEntryNature::InputEntryNature_Button) == buttons)
+				count++;
+		}
+		writer << count;
+
+		for (TConstSetBitIterator<> it(inputFrame->Listened); it; ++it)
+		{
+			const FInputFrameSlot& frameSlot = inputFrame->Slots[it.GetIndex()];
+			if ((frameSlot.Nature == EInputEntryNature::InputEntryNature_Button) != buttons)
+				continue;
+			uint32 netId = UInputEntryPool::GetInputNetId(_slotsHandles[it.GetIndex()]);
+			uint8 nature = frameSlot.Nature;
+			uint8 type = frameSlot.Type;
+			float inputBuffer = frameSlot.InputBuffer;
+			writer << netId << nature << type << inputBuffer;
+			if (!buttons)
+			{
+				FIntVector value = frameSlot.Axis;
+				writer << value.X << value.Y << value.Z;
+			}
+		}
+	}
+	return true;
+}
+
+
+bool FInputFrameRing::FromBytes(TArrayView<const uint8> bytes)
+{
+	if (_frames.Num() <= 0)
+		return false;
+
+	FMemoryReaderView reader(bytes);
+	//Flag the reader in error instead of reading past the end.
+	const auto canRead = [&reader](int64 size) -> bool
+	{
+		if (!reader.IsError() && reader.Tell() + size <= reader.TotalSize())
+			return true;
+		reader.SetError();
+		return false;
+	};
+
+	FInputFrame inputFrame;
+	if (!canRead(sizeof(int64) + sizeof(int32) * 3))
+		return false;
+	reader << inputFrame.Frame;
+	reader << inputFrame.MoveInput.X << inputFrame.MoveInput.Y << inputFrame.MoveInput.Z;
+	if (inputFrame.Frame < 0)
+		return false;
+	inputFrame.SetSlotCount(_slotsHandles.Num());
+
+	//Buttons, then axes. The inputs whose keys are not registered locally are skipped.
+	for (const bool buttons : { true, false })
+	{
+		uint16 count = 0;
+		if (canRead(sizeof(uint16)))
+			reader << count;
+		for (int32 i = 0; i < count && !reader.IsError(); i++)
+		{
+			uint32 netId = 0;
+			uint8 nature = 0;
+			uint8 type = 0;
+			float inputBuffer = 0;
+			FIntVector axis = FIntVector::ZeroValue;
+			if (!canRead(sizeof(uint32) + sizeof(uint8) * 2 + sizeof(float) + (buttons ? 0 : sizeof(int32) * 3)))
+				break;
+			reader << netId << nature << type << inputBuffer;
+			if (!buttons)
+				reader << axis.X << axis.Y << axis.Z;
+
+			const int32 slotIndex = GetOrAddSlot(UInputEntryPool::FindInputByNetId(netId));
+			if (slotIndex == INDEX_NONE)
+				continue;
+			inputFrame.SetSlotCount(_slotsHandles.Num());
+			FInputFrameSlot& frameSlot = inputFrame.Slots[slotIndex];
+			frameSlot.Nature = static_cast<EInputEntryNature>(nature);
+			frameSlot.Type = static_cast<EInputEntryType>(type);
+			frameSlot.InputBuffer = inputBuffer;
+			frameSlot.Axis = axis;
+			inputFrame.Listened[slotIndex] = true;
+		}
+	}
+
+	if (reader.IsError())
+		return false;
+	_frames[inputFrame.Frame % _frames.Num()] = inputFrame;
+	return true;
+}
+
+
+
+void FNetInputSnapshot::Capture(const UInputEntryPool& pool)
+{
+	const auto toMilliseconds = [](float seconds) -> uint16 { return static_cast<uint16>(FMath::Clamp(FMath::RoundToInt32(seconds * 1000), 0, static_cast<int32>(MAX_uint16))); };
+
+	Inputs.Reset();
+	Inputs.Reserve(pool._slots.Num());
+	bIsSet = true;
+	for (int32 handle = 0; handle < pool._slots.Num(); handle++)
+	{
+		const FInputEntrySlot& slot = pool._slots[handle];
+		const uint32 netId = UInputEntryPool::GetInputNetId(handle);
+		if (!slot.bHasLast || netId == 0 || !pool.IsInputLive(handle))
+			continue;
+		FNetInputEntry& netEntry = Inputs.AddDefaulted_GetRef();
+		netEntry.InputId = netId;
+		netEntry.Nature = slot.Last.Nature;
+		netEntry.Type = slot.Last.Type;
+		netEntry.Phase = slot.Last.Phase;
+		netEntry.Axis = slot.Last.Axis;
+		netEntry.ActiveDuration = toMilliseconds(slot.Last._activeDuration);
+		netEntry.BufferChrono = toMilliseconds(slot.Last._bufferChrono);
+	}
+}
+
+
+void FNetInputSnapshot::Apply(UInputEntryPool& pool) const
+{
+	pool.Reset();
+	for (const FNetInputEntry& netEntry : Inputs)
+	{
+		const int32 handle = UInputEntryPool::FindInputByNetId(netEntry.InputId);
+		if (handle == INDEX_NONE)
+			continue;
+		if (handle >= pool._slots.Num())
+			pool.Reserve(FMath::Max(handle + 1, UInputEntryPool::GetRegisteredInputCount()));
+
+		FInputEntrySlot& slot = pool._slots[handle];
+		slot.Last = FInputEntry();
+		slot.Last.Nature = netEntry.Nature;
+		slot.Last.Type = netEntry.Type;
+		slot.Last.Phase = netEntry.Phase;
+		slot.Last.Axis = netEntry.Axis;
+		slot.Last._activeDuration = netEntry.ActiveDuration * 0.001f;
+		slot.Last._bufferChrono = netEntry.BufferChrono * 0.001f;
+		slot.bHasLast = true;
+	}
+}
+
+
+bool FNetInputSnapshot::HasChanged(const FNetInputSnapshot& other) const
+{
+	if (Inputs.Num() != other.Inputs.Num())
+		return true;
+	for (int32 i = 0; i < Inputs.Num(); i++)
+	{
+		if (Inputs[i].InputId != other.Inputs[i].InputId || Inputs[i].Phase != other.Inputs[i].Phase)
+			return true;
+	}
+	return false;
+}
+
+
+bool FNetInputSnapshot::Equals(const FNetInputSnapshot& other) const
+{
+	if (bIsSet != other.bIsSet || HasChanged(other))
+		return false;
+	for (int32 i = 0; i < Inputs.Num(); i++)
+	{
+		if (Inputs[i].Nature != other.Inputs[i].Nature || Inputs[i].Type != other.Inputs[i].Type || !Inputs[i].Axis.Equals(other.Inputs[i].Axis, 0.01))
+			return false;
+	}
+	return true;
+}
+
+
+#pragma endregion
+
+
+
+#pragma region States and Actions XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
+
+
+void FBehaviourSnapShotRing::Initialize(const UScriptStruct* runtimeStruct, int depth)
+{
+	Release();
+	if (runtimeStruct == nullptr)
+		return;
+
+	check(runtimeStruct->GetMinAlignment() <= 16);
+	_struct = runtimeStruct;
+	_slotSize = Align(FMath::Max(_struct->GetStructureSize(), 1), 16);
+	_depth = FMath::Max(depth, 0);
+	_frames.Init(EmptyFrame, _depth + 1);
+	const int slotCount = _frames.Num() + 1;
+	_buffer.SetNumZeroed(_slotSize * slotCount);
+	for (int slot = 0; slot < slotCount; slot++)
+	{
+		_struct->InitializeStruct(_buffer.GetData() + slot * _slotSize);
+	}
+}
+
+
+void FBehaviourSnapShotRing::Release()
+{
+	for (int slot = 0; _struct && slot < _frames.Num() + 1; slot++)
+	{
+		_struct->DestroyStruct(_buffer.GetData() + slot * _slotSize);
+	}
+	_struct = nullptr;
+	_frames.Empty();
+	_buffer.Empty();
+	_slotSize = 0;
+	_depth = 0;
+}
+
+
+void FBehaviourSnapShotRing::Save(int64 frame)
+{
+	if (!IsValidFrame(frame))
+		return;
+
+	const int slot = GetSlot(frame);
+	_struct->CopyScriptStruct(_buffer.GetData() + slot * _slotSize, GetLive());
+	_frames[slot] = frame;
+}
+
+
+bool FBehaviourSnapShotRing::Restore(int64 frame)
+{
+	if (!Contains(frame))
+		return false;
+
+	_struct->CopyScriptStruct(GetLive(), _buffer.GetData() + GetSlot(frame) * _slotSize);
+	return true;
+}
+
+
+bool FBehaviourSnapShotRing::Contains(int64 frame) const
+{
+	if (!IsValidFrame(frame))
+		return false;
+	return _frames[GetSlot(frame)] == frame;
+}
+
+
+void FBehaviourSnapShotRing::AddReferencedObjects(FReferenceCollector& collector, const UObject* owner)
+{
+	if (_struct == nullptr)
+		return;
+	//The slots are raw memory, their object properties are not seen by the garbage collector otherwise.
+	for (int slot = 0; slot < _frames.Num() + 1; slot++)
+	{
+		collector.AddReferencedObjects(_struct, _buffer.GetData() + slot * _slotSize, owner);
+	}
+}
+
+
+void FActionTimerSchedule::Reset(int actionCount)
+{
+	_phaseEvents.Reset();
+	_coolDownEnds.Init(0, actionCount);
+	_generations.Init(0, actionCount);
+}
+
+
+void FActionTimerSchedule::Schedule(int actionIndex, double coolDown, double remainingActivation, float activePhaseDuration, float recoveryPhaseDuration)
+{
+	if (!_generations.IsValidIndex(actionIndex))
+		return;
+	_generations[actionIndex]++;
+	_coolDownEnds[actionIndex] = coolDown > 0 ? Clock + coolDown : 0;
+	if (remainingActivation <= 0)
+		return;
+
+	//Boundaries already passed are left to the action process.
+	auto pushPhase = [&](double timeToPhase, EActionPhase phase)
+	{
+		if (timeToPhase < 0)
+			return;
+		FPhaseEvent phaseEvent;
+		phaseEvent.Time = Clock + timeToPhase;
+		phaseEvent.ActionIndex = actionIndex;
+		phaseEvent.Generation = _generations[actionIndex];
+		phaseEvent.Phase = phase;
+		_phaseEvents.HeapPush(phaseEvent);
+	};
+	if (remainingActivation > (activePhaseDuration + recoveryPhaseDuration))
+		pushPhase(0, ActionPhase_Anticipation);
+	pushPhase(remainingActivation - (activePhaseDuration + recoveryPhaseDuration), ActionPhase_Active);
+	pushPhase(remainingActivation - recoveryPhaseDuration, ActionPhase_Recovery);
+}
+
+
+bool FActionTimerSchedule::IsCoolingDown(int actionIndex, double& remaining) const
+{
+	remaining = _coolDownEnds.IsValidIndex(actionIndex) ? _coolDownEnds[actionIndex] - Clock : 0;
+	return remaining > 0;
+}
+
+
+bool FActionTimerSchedule::PopDuePhase(int& actionIndex, EActionPhase& phase)
+{
+	while (_phaseEvents.Num() > 0 && _phaseEvents.HeapTop().Time <= Clock)
+	{
+		FPhaseEvent phaseEvent;
+		_phaseEvents.HeapPop(phaseEvent);
+		if (!_generations.IsValidIndex(phaseEvent.ActionIndex) || _generations[phaseEvent.ActionIndex] != phaseEvent.Generation)
+			continue;
+		actionIndex = phaseEvent.ActionIndex;
+		phase = phaseEvent.Phase;
+		return true;
+	}
+	return false;
+}
+
+
+#pragma endregion
@@ -24,32 +24,41 @@ FVector UFreeFallState::AirControl(FVector desiredMove, FVector horizontalVeloci
 }
 
 
-FVector UFreeFallState::AddGravity(FVector verticalVelocity, float delta)
+FVector UFreeFallState::AddGravity(const FFreeFallStateRuntime& runtime, FVector verticalVelocity, float delta)
 {
 	FVector gravity = FVector(0);
-	if (const bool isCurrentlyFalling = FVector::DotProduct(verticalVelocity, _gravity) >= 0)
+	if (const bool isCurrentlyFalling = FVector::DotProduct(verticalVelocity, runtime.Gravity) >= 0)
 	{
 		const float terminalDiff = TerminalVelocity - verticalVelocity.Length();
-		gravity = verticalVelocity + _gravity * delta * FMath::Sign(terminalDiff);
+		gravity = verticalVelocity + runtime.Gravity * delta * FMath::Sign(terminalDiff);
 	}
 	else
 	{
-		gravity = _gravity * delta + verticalVelocity;
+		gravity = runtime.Gravity * delta + verticalVelocity;
 	}
 	return gravity;
 }
 
 
+float UFreeFallState::GetAirTime(const FBehaviourRuntimeRef& runtime) const
+{
+	const FFreeFallStateRuntime* fallRuntime = runtime.GetPtr<FFreeFallStateRuntime>();
+	return fallRuntime ? fallRuntime->AirTime : 0;
+}
+
+
 void UFreeFallState::SetGravityForce(FVector newGravity, UModularControllerComponent* controller)
 {
-	Gravity = newGravity;
-	_gravity = newGravity;
-	if(controller)
+	if (!controller)
+		return;
+	FFreeFallStateRuntime* fallRuntime = controller->GetBehaviourRuntime(this).GetPtr<FFreeFallStateRuntime>();
+	if (!fallRuntime)
+		return;
+	fallRuntime->Gravity = newGravity;
+	fallRuntime->bGravityOverriden = true;
+	if(controller->_currentActiveGravityState == this)
 	{
-		if(controller->_currentActiveGravityState == this)
-		{
-			controller->SetGravity(newGravity, this);
-		}
+		controller->SetGravity(newGravity, this);
 	}
 }
 
@@ -59,34 +68,37 @@ void UFreeFallState::SetGravityForce(FVector newGravity, UModularControllerCompo
 #pragma region Functions
 
 
-bool UFreeFallState::CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+bool UFreeFallState::CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus)
 {
 	return true;
 }
 
-void UFreeFallState::OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UFreeFallState::OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
-	_gravity = Gravity;
+	FFreeFallStateRuntime& fallRuntime = runtime.Get<FFreeFallStateRuntime>();
+	if (!fallRuntime.bGravityOverriden)
+		fallRuntime.Gravity = Gravity;
 	if (controller)
-		controller->SetGravity(_gravity, this);
-	_airTime = 0;
+		controller->SetGravity(fallRuntime.Gravity, this);
+	fallRuntime.AirTime = 0;
 }
 
-FVelocity UFreeFallState::ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity UFreeFallState::ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
 	const float inDelta)
 {
+	FFreeFallStateRuntime& fallRuntime = runtime.Get<FFreeFallStateRuntime>();
 	auto inputAxis = moveInput;
 	if (inputAxis.Normalize())
 	{
-		const FVector planarInput = FVector::VectorPlaneProject(inputAxis, Gravity.GetSafeNormal());
+		const FVector planarInput = FVector::VectorPlaneProject(inputAxis, fallRuntime.Gravity.GetSafeNormal());
 		const FVector resultingVector = planarInput * AirControlSpeed;
 		inputAxis = resultingVector;
 	}
-	if (controllerStatusParam.StateModifiers1.X > _airTime)
-		_airTime = controllerStatusParam.StateModifiers1.X;
+	if (controllerStatusParam.StateModifiers1.X > fallRuntime.AirTime)
+		fallRuntime.AirTime = controllerStatusParam.StateModifiers1.X;
 
 	FVector HorizontalVelocity = FVector(0);
 	FVector VerticalVelocity = FVector(0);
@@ -100,7 +112,7 @@ FVelocity UFreeFallState::ProcessState_Implementation(FStatusParameters controll
 	}
 
 	FVector velocity = FVector(0);
-	if (GetWasTheLastFrameControllerState())
+	if (fallRuntime.bWasTheLastFrameBehaviour)
 	{
 		velocity = AirControl(inputAxis, HorizontalVelocity, inDelta);
 	}
@@ -110,43 +122,31 @@ FVelocity UFreeFallState::ProcessState_Implementation(FStatusParameters controll
 		move.Rotation = UStructExtensions::GetProgressiveRotation(inDatas.InitialTransform.GetRotation(), -inDatas.Gravity.GetSafeNormal(), lookDir, AirControlRotationSpeed, inDelta);
 	}
 
-	velocity += AddGravity(VerticalVelocity, inDelta);
-	_airTime += inDelta;
+	velocity += AddGravity(fallRuntime, VerticalVelocity, inDelta);
+	fallRuntime.AirTime += inDelta;
 	move.ConstantLinearVelocity = velocity;
 
-	controllerStatusParam.StateModifiers1.X = _airTime;
+	controllerStatusParam.StateModifiers1.X = fallRuntime.AirTime;
 
 	controllerStatus = controllerStatusParam;
 	return move;
 }
 
-void UFreeFallState::OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void UFreeFallState::OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
-	_airTime = 0;
+	runtime.Get<FFreeFallStateRuntime>().AirTime = 0;
 }
 
 
-FString UFreeFallState::DebugString()
+FString UFreeFallState::DebugString(const FBehaviourRuntimeRef& runtime)
 {
-	return Super::DebugString() + " : " + FString::Printf(TEXT("Air Time (%f)"), _airTime);
+	return Super::DebugString(runtime) + " : " + FString::Printf(TEXT("Air Time (%f)"), GetAirTime(runtime));
 }
 
 
-void UFreeFallState::OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller)
-{
-}
-
-void UFreeFallState::SaveStateSnapShot_Internal()
-{
-	_airTime_saved = _airTime;
-	_gravity_saved = _gravity;
-}
-
-void UFreeFallState::RestoreStateFromSnapShot_Internal()
+void UFreeFallState::OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller)
 {
-	_airTime = _airTime_saved;
-	_gravity = _gravity_saved;
 }
 
 
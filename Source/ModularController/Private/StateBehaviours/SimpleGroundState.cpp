@@ -8,12 +8,12 @@
 //Check if we are on the ground
 #pragma region Check XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 
-bool USimpleGroundState::CheckSurface(const FTransform spacialInfos, const FVector gravity, UModularControllerComponent* controller, const FVector momentum, const float inDelta, bool useMaxDistance)
+bool USimpleGroundState::CheckSurface(FSimpleGroundStateRuntime& runtime, const FTransform spacialInfos, const FVector gravity, UModularControllerComponent* controller, const FVector momentum, const float inDelta, bool useMaxDistance)
 {
 	if (!controller)
 	{
-		t_currentSurfaceInfos = FHitResult();
-		SurfaceInfos.Reset();
+		runtime.CurrentSurfaceHit = FHitResult();
+		runtime.SurfaceInfos.Reset();
 		return false;
 	}
 
@@ -24,20 +24,30 @@ bool USimpleGroundState::CheckSurface(const FTransform spacialInfos, const FVect
 	const float hulloffset = -HullInflation;
 	const float checkDistance = (FloatingGroundDistance + 1) + (useMaxDistance ? MaxCheckDistance : 0);
 
-	const bool haveHit = controller->ComponentTraceCastSingle(surfaceInfos, spacialInfos.GetLocation(), gravityDirection * (checkDistance + hulloffset)
-		, spacialInfos.GetRotation(), HullInflation, controller->bUseComplexCollision);
+	bool haveHit = false;
+	if (bUseAsyncSurfaceCheck && controller->CanUseAsyncProbes()
+		&& ConsumeAsyncSurfaceCheck(runtime, surfaceInfos, spacialInfos, gravityDirection, controller, momentum, inDelta, checkDistance + hulloffset))
+	{
+		haveHit = surfaceInfos.IsValidBlockingHit();
+	}
+	else
+	{
+		const FComponentSweepRequest surfaceProbe(spacialInfos.GetLocation(), gravityDirection * (checkDistance + hulloffset));
+		haveHit = controller->ComponentTraceCastBatch(MakeArrayView(&surfaceInfos, 1), MakeArrayView(&surfaceProbe, 1)
+			, spacialInfos.GetRotation(), HullInflation, controller->bUseComplexCollision) > 0;
+	}
 
 	//Debug
-	if (bDebugState)
+	if (IsDebugging())
 	{
 		UStructExtensions::DrawDebugCircleOnSurface(surfaceInfos, false, 40, useMaxDistance ? FColor::Green : FColor::Yellow, 0, 2, true);
 	}
 
-	t_currentSurfaceInfos = surfaceInfos;
-	SurfaceInfos.UpdateSurfaceInfos(spacialInfos, surfaceInfos, inDelta);
+	runtime.CurrentSurfaceHit = surfaceInfos;
+	runtime.SurfaceInfos.UpdateSurfaceInfos(spacialInfos, surfaceInfos, inDelta);
 
 	//Check if surface is falling faster tha gravity
-	auto surfaceVelocity = SurfaceInfos.GetSurfaceLinearVelocity();
+	auto surfaceVelocity = runtime.SurfaceInfos.GetSurfaceLinearVelocity();
 	if (surfaceVelocity.Length() > 0)
 	{
 		FVector momentumOnGrav = momentum.ProjectOnToNormal(gravityDirection);
@@ -54,6 +64,45 @@ bool USimpleGroundState::CheckSurface(const FTransform spacialInfos, const FVect
 	return haveHit && surfaceInfos.Component.IsValid() && surfaceInfos.Component->CanCharacterStepUpOn;
 }
 
+bool USimpleGroundState::ConsumeAsyncSurfaceCheck(FSimpleGroundStateRuntime& runtime, FHitResult& outHit, const FTransform spacialInfos, const FVector gravityDirection, UModularControllerComponent* controller, const FVector momentum, const float inDelta, const float checkLength)
+{
+	const float hulloffset = -HullInflation;
+	const float maxCheckLength = (FloatingGroundDistance + 1) + MaxCheckDistance + hulloffset;
+	const FVector currentLocation = spacialInfos.GetLocation();
+
+	//Last frame probe
+	FHitResult asyncHit;
+	FTraceHandle lastProbe;
+	lastProbe._Handle = runtime.AsyncSurfaceCheckHandle;
+	const bool available = controller->QueryAsyncComponentTraceCast(lastProbe, asyncHit)
+		&& FVector::Dist(runtime.AsyncSurfaceCheckStart, currentLocation) <= FloatingGroundDistance;
+	runtime.AsyncSurfaceCheckHandle = 0;
+
+	//Next frame probe, always at max distance and filtered on consumption.
+	runtime.AsyncSurfaceCheckStart = currentLocation + momentum * inDelta;
+	runtime.AsyncSurfaceCheckHandle = controller->AsyncComponentTraceCast(runtime.AsyncSurfaceCheckStart, gravityDirection * maxCheckLength
+		, spacialInfos.GetRotation(), HullInflation, controller->bUseComplexCollision)._Handle;
+
+	if (!available)
+		return false;
+
+	//Express the hit from the current location.
+	outHit = asyncHit;
+	outHit.TraceStart = currentLocation;
+	outHit.TraceEnd = currentLocation + gravityDirection * checkLength;
+	if (asyncHit.IsValidBlockingHit())
+	{
+		const float distance = FVector::DotProduct(asyncHit.Location - currentLocation, gravityDirection);
+		if (distance > checkLength)
+		{
+			outHit.bBlockingHit = false;
+			outHit.Location = outHit.TraceEnd;
+		}
+		outHit.Distance = FMath::Max(distance, 0);
+	}
+	return true;
+}
+
 void USimpleGroundState::OnLanding_Implementation(FSurfaceInfos landingSurface, const FKinematicInfos& inDatas,
 	const float delta)
 {
@@ -70,15 +119,15 @@ void USimpleGroundState::OnTakeOff_Implementation(FSurfaceInfos landingSurface,
 #pragma region Surface and Snapping XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 
 
-FVector USimpleGroundState::ComputeSnappingForce(const FKinematicInfos& inDatas, UObject* debugObject) const
+FVector USimpleGroundState::ComputeSnappingForce(const FSimpleGroundStateRuntime& runtime, const FKinematicInfos& inDatas, UObject* debugObject) const
 {
-	if (!t_currentSurfaceInfos.IsValidBlockingHit())
+	if (!runtime.CurrentSurfaceHit.IsValidBlockingHit())
 		return FVector();
-	const FVector offsetEndLocation = t_currentSurfaceInfos.Location + (t_currentSurfaceInfos.TraceStart - t_currentSurfaceInfos.TraceEnd).GetSafeNormal()
+	const FVector offsetEndLocation = runtime.CurrentSurfaceHit.Location + (runtime.CurrentSurfaceHit.TraceStart - runtime.CurrentSurfaceHit.TraceEnd).GetSafeNormal()
 		* (FloatingGroundDistance - HullInflation);
 	const FVector rawSnapForce = offsetEndLocation - inDatas.InitialTransform.GetLocation();
 	FVector snappingForce = rawSnapForce.ProjectOnToNormal(inDatas.Gravity.GetSafeNormal());
-	if (bDebugState && debugObject)
+	if (IsDebugging() && debugObject)
 		UKismetSystemLibrary::DrawDebugArrow(debugObject, inDatas.InitialTransform.GetLocation(), offsetEndLocation, 50, FColor::Yellow, 0, 3);
 	return snappingForce;
 }
@@ -90,30 +139,30 @@ FVector USimpleGroundState::ComputeSnappingForce(const FKinematicInfos& inDatas,
 
 
 
-FVector USimpleGroundState::MoveOnTheGround(const FKinematicInfos& inDatas, FVector desiredMovement, const float acceleration, const float deceleration, const float inDelta)
+FVector USimpleGroundState::MoveOnTheGround(FSimpleGroundStateRuntime& runtime, const FKinematicInfos& inDatas, FVector desiredMovement, const float acceleration, const float deceleration, const float inDelta)
 {
 	FVector hVel = FVector::VectorPlaneProject(inDatas.GetInitialMomentum(), inDatas.Gravity.GetSafeNormal());
 	const FVector vVel = inDatas.Gravity;
-	const float surfaceDrag = t_currentSurfaceInfos.PhysMaterial != nullptr ? t_currentSurfaceInfos.PhysMaterial->Friction : 1;
+	const float surfaceDrag = runtime.CurrentSurfaceHit.PhysMaterial != nullptr ? runtime.CurrentSurfaceHit.PhysMaterial->Friction : 1;
 	FVector inputMove = desiredMovement;
 
 	//Slope handling
-	if (vVel.SquaredLength() > 0.05f && FMath::Abs(FVector::DotProduct(t_currentSurfaceInfos.ImpactNormal, vVel.GetSafeNormal())) < 1)
+	if (vVel.SquaredLength() > 0.05f && FMath::Abs(FVector::DotProduct(runtime.CurrentSurfaceHit.ImpactNormal, vVel.GetSafeNormal())) < 1)
 	{
-		const FVector downHillDirection = FVector::VectorPlaneProject(t_currentSurfaceInfos.ImpactNormal, vVel.GetSafeNormal()).GetSafeNormal();
+		const FVector downHillDirection = FVector::VectorPlaneProject(runtime.CurrentSurfaceHit.ImpactNormal, vVel.GetSafeNormal()).GetSafeNormal();
 		if (bSlopeAffectSpeed && desiredMovement.Length() > 0)
 		{
-			const FVector slopeDesiredMovement = FVector::VectorPlaneProject(desiredMovement, t_currentSurfaceInfos.ImpactNormal);
+			const FVector slopeDesiredMovement = FVector::VectorPlaneProject(desiredMovement, runtime.CurrentSurfaceHit.ImpactNormal);
 			const float diff = FMath::Abs(desiredMovement.Length() - slopeDesiredMovement.Length());
 			const float dirScale = FVector::DotProduct(desiredMovement.GetSafeNormal(), downHillDirection);
 			desiredMovement += desiredMovement.GetSafeNormal() * diff * dirScale;
 			inputMove = slopeDesiredMovement.GetSafeNormal() * desiredMovement.Length();
 		}
 
-		const float angle = (1 - FVector::DotProduct(-vVel.GetSafeNormal(), t_currentSurfaceInfos.ImpactNormal)) * 90;
+		const float angle = (1 - FVector::DotProduct(-vVel.GetSafeNormal(), runtime.CurrentSurfaceHit.ImpactNormal)) * 90;
 		if (angle > MaxSlopeAngle)
 		{
-			const FVector downHillGravity = FVector::VectorPlaneProject(vVel, t_currentSurfaceInfos.ImpactNormal).GetSafeNormal();
+			const FVector downHillGravity = FVector::VectorPlaneProject(vVel, runtime.CurrentSurfaceHit.ImpactNormal).GetSafeNormal();
 			FVector onHillDesiredMove = FVector::VectorPlaneProject(desiredMovement, downHillGravity.GetSafeNormal());
 			onHillDesiredMove = onHillDesiredMove.GetClampedToMaxSize(MaxSlidingSpeed * 0.5);
 			const FVector scaledInputs = UStructExtensions::AccelerateTo(hVel, downHillGravity * MaxSlidingSpeed + onHillDesiredMove, SlidingAcceleration * FMath::Clamp(1 - surfaceDrag, 0.01, 1), inDelta);
@@ -122,27 +171,27 @@ FVector USimpleGroundState::MoveOnTheGround(const FKinematicInfos& inDatas, FVec
 	}
 
 	//void any movement if we are absorbing landing impact
-	if (LandingImpactRemainingForce > 0)
+	if (runtime.LandingImpactRemainingForce > 0)
 	{
-		LandingImpactRemainingForce -= LandingImpactAbsorbtionSpeed * inDelta;
-		if (LandingImpactRemainingForce > LandingImpactMoveThreshold)
+		runtime.LandingImpactRemainingForce -= LandingImpactAbsorbtionSpeed * inDelta;
+		if (runtime.LandingImpactRemainingForce > LandingImpactMoveThreshold)
 		{
-			const FVector scaledInputs = UStructExtensions::AccelerateTo(hVel, FVector::ZeroVector, (LandingImpactMoveThreshold / LandingImpactRemainingForce) * 5 * surfaceDrag, inDelta);
+			const FVector scaledInputs = UStructExtensions::AccelerateTo(hVel, FVector::ZeroVector, (LandingImpactMoveThreshold / runtime.LandingImpactRemainingForce) * 5 * surfaceDrag, inDelta);
 			return scaledInputs;
 		}
 	}
 
-	hVel = FVector::VectorPlaneProject(inDatas.GetInitialMomentum(), t_currentSurfaceInfos.Normal);
+	hVel = FVector::VectorPlaneProject(inDatas.GetInitialMomentum(), runtime.CurrentSurfaceHit.Normal);
 
 	if (inputMove.Length() > 0.05f)
 	{
 		const bool isDecelerating = hVel.SquaredLength() > inputMove.SquaredLength();
 		FVector scaledInputs = UStructExtensions::AccelerateTo(hVel, inputMove, (isDecelerating ? deceleration : acceleration) * surfaceDrag, inDelta);
 
-		if (inDatas.bUsePhysic && t_currentSurfaceInfos.IsValidBlockingHit() && t_currentSurfaceInfos.Component.IsValid() && t_currentSurfaceInfos.Component->IsSimulatingPhysics()
+		if (inDatas.bUsePhysic && runtime.CurrentSurfaceHit.IsValidBlockingHit() && runtime.CurrentSurfaceHit.Component.IsValid() && runtime.CurrentSurfaceHit.Component->IsSimulatingPhysics()
 			&& scaledInputs.Length() > 0)
 		{
-			t_currentSurfaceInfos.Component->AddForceAtLocation(FVector::VectorPlaneProject(-scaledInputs, t_currentSurfaceInfos.Normal) * inDatas.GetMass() * inDelta, t_currentSurfaceInfos.ImpactPoint, t_currentSurfaceInfos.BoneName);
+			runtime.CurrentSurfaceHit.Component->AddForceAtLocation(FVector::VectorPlaneProject(-scaledInputs, runtime.CurrentSurfaceHit.Normal) * inDatas.GetMass() * inDelta, runtime.CurrentSurfaceHit.ImpactPoint, runtime.CurrentSurfaceHit.BoneName);
 		}
 
 		return scaledInputs;
@@ -156,25 +205,25 @@ FVector USimpleGroundState::MoveOnTheGround(const FKinematicInfos& inDatas, FVec
 	}
 }
 
-FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* controller, const FKinematicInfos& inDatas, const FVector attemptedMove,
+FVector USimpleGroundState::MoveToPreventFalling(FSimpleGroundStateRuntime& runtime, UModularControllerComponent* controller, const FKinematicInfos& inDatas, const FVector attemptedMove,
 	const float inDelta, FVector& adjusmentMove)
 {
 	if (!controller)
 		return attemptedMove;
-	if (!t_currentSurfaceInfos.GetActor())
+	if (!runtime.CurrentSurfaceHit.GetActor())
 		return attemptedMove;
 
-	const FVector normalPt = t_currentSurfaceInfos.ImpactPoint + t_currentSurfaceInfos.Normal;
-	const FVector imp_normalPt = t_currentSurfaceInfos.ImpactPoint + t_currentSurfaceInfos.ImpactNormal;
+	const FVector normalPt = runtime.CurrentSurfaceHit.ImpactPoint + runtime.CurrentSurfaceHit.Normal;
+	const FVector imp_normalPt = runtime.CurrentSurfaceHit.ImpactPoint + runtime.CurrentSurfaceHit.ImpactNormal;
 	FVector upVector = inDatas.InitialTransform.GetRotation().GetUpVector();
 	FVector checkDir = FVector::VectorPlaneProject((normalPt - imp_normalPt), upVector);
 	if (!checkDir.Normalize())
 		return attemptedMove;
 
-	FVector planedImpactVec = FVector::VectorPlaneProject(t_currentSurfaceInfos.ImpactNormal, upVector);
+	FVector planedImpactVec = FVector::VectorPlaneProject(runtime.CurrentSurfaceHit.ImpactNormal, upVector);
 	if (planedImpactVec.Normalize())
 	{
-		float bothNormalsLookingSameDir = FVector::DotProduct(planedImpactVec, t_currentSurfaceInfos.Normal);
+		float bothNormalsLookingSameDir = FVector::DotProduct(planedImpactVec, runtime.CurrentSurfaceHit.Normal);
 		if (bothNormalsLookingSameDir > 0)
 		{
 			checkDir = FVector::VectorPlaneProject(checkDir, planedImpactVec);
@@ -191,10 +240,11 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 	const float relativeCheckDistance = 0;// FMath::Clamp(attemptedMove.Length(), 1, TNumericLimits<float>().Max());
 	const float checkDistance = FloatingGroundDistance + MaxCheckDistance;
 
-	bool haveHit = controller->ComponentTraceCastSingle(surfaceInfos, newPos + checkDir * (HullInflation + relativeCheckDistance), gravityDirection * (checkDistance + hullOffset)
-		, inDatas.InitialTransform.GetRotation(), HullInflation, controller->bUseComplexCollision);
+	FComponentSweepRequest fallProbe(newPos + checkDir * (HullInflation + relativeCheckDistance), gravityDirection * (checkDistance + hullOffset));
+	bool haveHit = controller->ComponentTraceCastBatch(MakeArrayView(&surfaceInfos, 1), MakeArrayView(&fallProbe, 1)
+		, inDatas.InitialTransform.GetRotation(), HullInflation, controller->bUseComplexCollision) > 0;
 
-	if (bDebugState)
+	if (IsDebugging())
 	{
 		if (haveHit)
 			UStructExtensions::DrawDebugCircleOnSurface(surfaceInfos, false, 30, FColor::Orange, 0, 1, true);
@@ -205,8 +255,8 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 	if (haveHit)
 	{
 		//Check stair cases mode
-		FVector impactsLinker = t_currentSurfaceInfos.ImpactPoint - surfaceInfos.ImpactPoint;
-		if (surfaceInfos.ImpactNormal == t_currentSurfaceInfos.ImpactNormal && surfaceInfos.ImpactNormal == upVector && impactsLinker.Length() > 0)
+		FVector impactsLinker = runtime.CurrentSurfaceHit.ImpactPoint - surfaceInfos.ImpactPoint;
+		if (surfaceInfos.ImpactNormal == runtime.CurrentSurfaceHit.ImpactNormal && surfaceInfos.ImpactNormal == upVector && impactsLinker.Length() > 0)
 		{
 			impactsLinker = FVector::VectorPlaneProject(impactsLinker, upVector);
 			impactsLinker.Normalize();
@@ -215,10 +265,11 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 			checkDir.Normalize();
 
 			newPos = controller->PointOnShape(checkDir, surfaceInfos.Location);
-			haveHit = controller->ComponentTraceCastSingle(surfaceInfos, newPos + checkDir * (HullInflation + relativeCheckDistance), gravityDirection * (checkDistance + hullOffset)
-				, inDatas.InitialTransform.GetRotation(), HullInflation, controller->bUseComplexCollision);
+			fallProbe.Position = newPos + checkDir * (HullInflation + relativeCheckDistance);
+			haveHit = controller->ComponentTraceCastBatch(MakeArrayView(&surfaceInfos, 1), MakeArrayView(&fallProbe, 1)
+				, inDatas.InitialTransform.GetRotation(), HullInflation, controller->bUseComplexCollision) > 0;
 
-			if (bDebugState)
+			if (IsDebugging())
 			{
 				if (haveHit)
 					UStructExtensions::DrawDebugCircleOnSurface(surfaceInfos, false, 20, FColor::Purple, 0, 1, true);
@@ -230,7 +281,7 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 
 			if (!haveHit)
 			{
-				FVector correctionVec = (t_currentSurfaceInfos.ImpactPoint - newPos).ProjectOnToNormal(checkDir);
+				FVector correctionVec = (runtime.CurrentSurfaceHit.ImpactPoint - newPos).ProjectOnToNormal(checkDir);
 				//adjusmentMove = correctionVec * 0.45f;
 				const FVector newMove = FVector::VectorPlaneProject(attemptedMove, checkDir.GetSafeNormal());
 				return FVector::DotProduct(attemptedMove, checkDir) >= 0 ? newMove + correctionVec * inDelta * 25 : attemptedMove;
@@ -240,7 +291,7 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 	}
 	else
 	{
-		FVector correctionVec = (t_currentSurfaceInfos.ImpactPoint - newPos).ProjectOnToNormal(checkDir);
+		FVector correctionVec = (runtime.CurrentSurfaceHit.ImpactPoint - newPos).ProjectOnToNormal(checkDir);
 		//adjusmentMove = correctionVec * 0.45f;
 		const FVector newMove = FVector::VectorPlaneProject(attemptedMove, checkDir.GetSafeNormal());
 		return FVector::DotProduct(attemptedMove, checkDir) >= 0 ? newMove + correctionVec * inDelta * 5 : attemptedMove;
@@ -256,60 +307,63 @@ FVector USimpleGroundState::MoveToPreventFalling(UModularControllerComponent* co
 #pragma region Functions XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 
 
-bool USimpleGroundState::CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+bool USimpleGroundState::CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus)
 {
-	bool willUseMaxDistance = GetWasTheLastFrameControllerState();
+	FSimpleGroundStateRuntime& groundRuntime = runtime.Get<FSimpleGroundStateRuntime>();
+	bool willUseMaxDistance = groundRuntime.bWasTheLastFrameBehaviour;
 	if (overrideWasLastStateStatus >= 0)
 	{
 		willUseMaxDistance = overrideWasLastStateStatus > 0;
 	}
 
 	FVector lockOnDirection = FVector(0);
-	auto input = inputs->ReadInput(LockOnDirection, bDebugState, this);
+	auto input = inputs->ReadInput(LockOnDirection, IsDebugging(), this);
 	lockOnDirection = input.Axis;
 
 	controllerStatusParam.StateModifiers2 = lockOnDirection;
 
 	currentStatus = controllerStatusParam;
 	const FVector_NetQuantize currentPos = inDatas.InitialTransform.GetLocation();
-	if (currentPos == _lastControlledPosition && willUseMaxDistance && t_savePosDelay <= 0)
+	if (currentPos == groundRuntime.LastControlledPosition && willUseMaxDistance && groundRuntime.SavePosDelay <= 0)
 	{
 		return true;
 	}
 
-	if (t_savePosDelay > 0)
-		t_savePosDelay -= inDelta;
-	_lastControlledPosition = currentPos;
+	if (groundRuntime.SavePosDelay > 0)
+		groundRuntime.SavePosDelay -= inDelta;
+	groundRuntime.LastControlledPosition = currentPos;
 
-	return CheckSurface(inDatas.InitialTransform, inDatas.Gravity, controller, inDatas.GetInitialMomentum(), inDelta, willUseMaxDistance);
+	return CheckSurface(groundRuntime, inDatas.InitialTransform, inDatas.Gravity, controller, inDatas.GetInitialMomentum(), inDelta, willUseMaxDistance);
 }
 
 
-void USimpleGroundState::OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void USimpleGroundState::OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
-	if (inDatas.bUsePhysic && t_currentSurfaceInfos.IsValidBlockingHit() && t_currentSurfaceInfos.Component.IsValid() && t_currentSurfaceInfos.Component->IsSimulatingPhysics()
+	FSimpleGroundStateRuntime& groundRuntime = runtime.Get<FSimpleGroundStateRuntime>();
+	if (inDatas.bUsePhysic && groundRuntime.CurrentSurfaceHit.IsValidBlockingHit() && groundRuntime.CurrentSurfaceHit.Component.IsValid() && groundRuntime.CurrentSurfaceHit.Component->IsSimulatingPhysics()
 		&& inDatas.GetInitialMomentum().Length() > 0)
 	{
-		t_currentSurfaceInfos.Component->AddForceAtLocation(inDatas.GetInitialMomentum() * inDatas.GetMass(), t_currentSurfaceInfos.ImpactPoint, t_currentSurfaceInfos.BoneName);
+		groundRuntime.CurrentSurfaceHit.Component->AddForceAtLocation(inDatas.GetInitialMomentum() * inDatas.GetMass(), groundRuntime.CurrentSurfaceHit.ImpactPoint, groundRuntime.CurrentSurfaceHit.BoneName);
 	}
 
 	if (inDatas.GetInitialMomentum().Length() > 0)
 	{
 		FVector vert = inDatas.GetInitialMomentum().ProjectOnToNormal(inDatas.Gravity.GetSafeNormal());
 		const float scale = FMath::Clamp(FVector::DotProduct(vert.GetSafeNormal(), inDatas.Gravity.GetSafeNormal()), 0, 1);
-		LandingImpactRemainingForce = vert.Length() * scale;
+		groundRuntime.LandingImpactRemainingForce = vert.Length() * scale;
 	}
 
-	t_savePosDelay = 1;
+	groundRuntime.SavePosDelay = 1;
 }
 
 
-FVelocity USimpleGroundState::ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
+FVelocity USimpleGroundState::ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus,
 	const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
 	const float inDelta)
 {
+	FSimpleGroundStateRuntime& groundRuntime = runtime.Get<FSimpleGroundStateRuntime>();
 	FVelocity result = FVelocity();
 	result.Rotation = inDatas.InitialVelocities.Rotation;
 
@@ -320,7 +374,7 @@ FVelocity USimpleGroundState::ProcessState_Implementation(FStatusParameters cont
 	}
 
 	if (controllerStatusParam.StateModifiers1.X > 0)
-		LandingImpactRemainingForce = controllerStatusParam.StateModifiers1.X;
+		groundRuntime.LandingImpactRemainingForce = controllerStatusParam.StateModifiers1.X;
 
 	const FVector horizontalVelocity = FVector::VectorPlaneProject(inDatas.GetInitialMomentum(), inDatas.Gravity.GetSafeNormal());
 	const FVector verticalVelocity = inDatas.GetInitialMomentum().ProjectOnToNormal(inDatas.Gravity.GetSafeNormal());
@@ -358,20 +412,20 @@ FVelocity USimpleGroundState::ProcessState_Implementation(FStatusParameters cont
 
 	const FVector desiredMove = inputMove * speedAcc.X * moveScale;
 
-	FVector moveVec = MoveOnTheGround(inDatas, desiredMove, speedAcc.Y, speedAcc.Z, inDelta);
+	FVector moveVec = MoveOnTheGround(groundRuntime, inDatas, desiredMove, speedAcc.Y, speedAcc.Z, inDelta);
 
 	//Fall prevention
 	FVector preventionForce = FVector(0);
 	if (IsPreventingFalling)
 	{
-		moveVec = MoveToPreventFalling(controller, inDatas, moveVec, inDelta, preventionForce);
+		moveVec = MoveToPreventFalling(groundRuntime, controller, inDatas, moveVec, inDelta, preventionForce);
 	}
 
 	result.ConstantLinearVelocity = moveVec;
 	result.ConstantLinearVelocity *= result._rooMotionScale;
 
 	//Snapping
-	FVector snapForce = ComputeSnappingForce(inDatas, controller);// *50 * inDelta;
+	FVector snapForce = ComputeSnappingForce(groundRuntime, inDatas, controller);// *50 * inDelta;
 	if(controller->ActionInstances.IsValidIndex(controllerStatusParam.ActionIndex) 
 		&& controller->ActionInstances[controllerStatusParam.ActionIndex]->bShouldControllerStateCheckOverride)
 	{
@@ -379,7 +433,7 @@ FVelocity USimpleGroundState::ProcessState_Implementation(FStatusParameters cont
 	}
 	result.InstantLinearVelocity = snapForce + preventionForce;
 
-	controllerStatusParam.StateModifiers1.X = LandingImpactRemainingForce;
+	controllerStatusParam.StateModifiers1.X = groundRuntime.LandingImpactRemainingForce;
 	if (lockedOn)
 		controllerStatusParam.StateModifiers2 = lockOnDirection;
 
@@ -388,36 +442,26 @@ FVelocity USimpleGroundState::ProcessState_Implementation(FStatusParameters cont
 
 }
 
-void USimpleGroundState::OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput,
+void USimpleGroundState::OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput,
 	UModularControllerComponent* controller, const float inDelta)
 {
-	LandingImpactRemainingForce = 0;
-	t_savePosDelay = 1;
-	_lastControlledPosition = FVector(0);
+	FSimpleGroundStateRuntime& groundRuntime = runtime.Get<FSimpleGroundStateRuntime>();
+	groundRuntime.LandingImpactRemainingForce = 0;
+	groundRuntime.SavePosDelay = 1;
+	groundRuntime.LastControlledPosition = FVector(0);
 }
 
 
-void USimpleGroundState::OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority,
+void USimpleGroundState::OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority,
 	UModularControllerComponent* controller)
 {
 
 }
 
-FString USimpleGroundState::DebugString()
-{
-	return Super::DebugString() + " : " + (LandingImpactRemainingForce > LandingImpactMoveThreshold ? FString::Printf(TEXT("Land (-%d)"), static_cast<int>(LandingImpactRemainingForce - LandingImpactMoveThreshold)) : (t_currentSurfaceInfos.PhysMaterial.Get() != nullptr ? FString::Printf(TEXT(" On %s"), *t_currentSurfaceInfos.PhysMaterial.Get()->GetName()) : " On NULL"));
-}
-
-void USimpleGroundState::SaveStateSnapShot_Internal()
-{
-	_landingImpactRemainingForce_saved = LandingImpactRemainingForce;
-	_lastControlledPosition_saved = _lastControlledPosition;
-}
-
-void USimpleGroundState::RestoreStateFromSnapShot_Internal()
+FString USimpleGroundState::DebugString(const FBehaviourRuntimeRef& runtime)
 {
-	LandingImpactRemainingForce = _landingImpactRemainingForce_saved;
-	_lastControlledPosition = _lastControlledPosition_saved;
+	const FSimpleGroundStateRuntime& groundRuntime = runtime.Get<FSimpleGroundStateRuntime>();
+	return Super::DebugString(runtime) + " : " + (groundRuntime.LandingImpactRemainingForce > LandingImpactMoveThreshold ? FString::Printf(TEXT("Land (-%d)"), static_cast<int>(groundRuntime.LandingImpactRemainingForce - LandingImpactMoveThreshold)) : (groundRuntime.CurrentSurfaceHit.PhysMaterial.Get() != nullptr ? FString::Printf(TEXT(" On %s"), *groundRuntime.CurrentSurfaceHit.PhysMaterial.Get()->GetName()) : " On NULL"));
 }
 
 
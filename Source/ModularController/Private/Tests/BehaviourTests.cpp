@@ -0,0 +1,151 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "UObject/Package.h"
+#include "ComponentAndBase/Structs.h"
+#include "ModularControllerTestTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModularControllerSnapShotRingTest, "ModularController.Behaviours.SnapShotRing"
+	, EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FModularControllerSnapShotRingTest::RunTest(const FString& Parameters)
+{
+	//Nothing saved yet: no slot must pass for a saved frame.
+	FBehaviourSnapShotRing emptyRing;
+	emptyRing.Initialize(FControllerStateRuntime::StaticStruct(), 4);
+	TestFalse(TEXT("An empty ring has no frame 0"), emptyRing.Contains(0));
+	TestFalse(TEXT("An empty ring has no simulation frame"), emptyRing.Contains(FBehaviourSnapShotRing::SimulationFrame));
+
+	FBehaviourSnapShotRing noHistoryRing;
+	noHistoryRing.Initialize(FControllerStateRuntime::StaticStruct(), 0);
+	noHistoryRing.Save(0);
+	TestFalse(TEXT("A ring without history keeps no frame"), noHistoryRing.Contains(0));
+
+	FBehaviourSnapShotRing ring;
+	ring.Initialize(FControllerStateRuntime::StaticStruct(), 4);
+	FControllerStateRuntime& runtime = ring.Get<FControllerStateRuntime>();
+	for (int64 frame = 0; frame < 6; frame++)
+	{
+		runtime.NextCheckTime = static_cast<double>(10 + frame);
+		ring.Save(frame);
+	}
+	TestFalse(TEXT("The frames older than the depth are overwritten"), ring.Contains(0) || ring.Contains(1));
+	TestTrue(TEXT("The last frames are kept"), ring.Contains(2) && ring.Contains(5));
+
+	runtime.NextCheckTime = 99;
+	TestTrue(TEXT("A kept frame is restored"), ring.Restore(3));
+	TestEqual(TEXT("The runtime properties are restored as recorded"), runtime.NextCheckTime, 13.0);
+	TestFalse(TEXT("An overwritten frame is not restored"), ring.Restore(1));
+	TestEqual(TEXT("A failed restore leaves the runtime properties"), runtime.NextCheckTime, 13.0);
+
+	//The simulation slot is apart from the history.
+	ring.Save(FBehaviourSnapShotRing::SimulationFrame);
+	runtime.NextCheckTime = 0;
+	TestTrue(TEXT("The simulation frame is restored"), ring.Restore(FBehaviourSnapShotRing::SimulationFrame) && runtime.NextCheckTime == 13.0);
+	TestTrue(TEXT("The simulation frame doesn't overwrite the history"), ring.Contains(2) && ring.Contains(5));
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModularControllerActionTimerScheduleTest, "ModularController.Behaviours.ActionTimerSchedule"
+	, EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FModularControllerActionTimerScheduleTest::RunTest(const FString& Parameters)
+{
+	FActionTimerSchedule schedule;
+	schedule.Reset(2);
+	int actionIndex = INDEX_NONE;
+	EActionPhase phase = ActionPhase_Undetermined;
+	double remaining = 0;
+
+	//0.6s of activation: 0.1 anticipation, 0.2 active, 0.3 recovery.
+	schedule.Schedule(0, 1.0, 0.6, 0.2f, 0.3f);
+	TestTrue(TEXT("The anticipation starts right away"), schedule.PopDuePhase(actionIndex, phase) && actionIndex == 0 && phase == ActionPhase_Anticipation);
+	TestFalse(TEXT("Nothing else is due yet"), schedule.PopDuePhase(actionIndex, phase));
+
+	schedule.Clock = 0.05;
+	TestFalse(TEXT("The active phase is not due before it's time"), schedule.PopDuePhase(actionIndex, phase));
+	schedule.Clock = 0.1;
+	TestTrue(TEXT("The active phase is due on it's time"), schedule.PopDuePhase(actionIndex, phase) && phase == ActionPhase_Active);
+
+	//A late clock pops every boundary passed, in order.
+	schedule.Schedule(1, 0, 0.3, 0.1f, 0.05f);
+	schedule.Clock = 0.5;
+	TArray<EActionPhase> phases;
+	TArray<int> actions;
+	while (schedule.PopDuePhase(actionIndex, phase))
+	{
+		phases.Add(phase);
+		actions.Add(actionIndex);
+	}
+	TestEqual(TEXT("Every boundary passed is popped"), phases.Num(), 4);
+	if (phases.Num() == 4)
+	{
+		TestTrue(TEXT("The boundaries are popped in time order")
+			, phases[0] == ActionPhase_Anticipation && actions[0] == 1
+			&& phases[1] == ActionPhase_Active && actions[1] == 1
+			&& phases[2] == ActionPhase_Recovery && actions[2] == 0
+			&& phases[3] == ActionPhase_Recovery && actions[3] == 1);
+	}
+
+	TestTrue(TEXT("The cooldown runs on the schedule clock"), schedule.IsCoolingDown(0, remaining) && FMath::IsNearlyEqual(remaining, 0.5));
+	TestFalse(TEXT("An action without cooldown is not cooling down"), schedule.IsCoolingDown(1, remaining));
+	schedule.Clock = 1.0;
+	TestFalse(TEXT("The cooldown ends on it's time"), schedule.IsCoolingDown(0, remaining));
+
+	//Rescheduling an action discards it's pending boundaries.
+	schedule.Schedule(0, 0, 1.0, 0.4f, 0.4f);
+	schedule.Schedule(0, 0, 0, 0.4f, 0.4f);
+	schedule.Clock = 5.0;
+	TestFalse(TEXT("The boundaries of a replaced schedule are discarded"), schedule.PopDuePhase(actionIndex, phase));
+	TestFalse(TEXT("An action out of range is never cooling down"), schedule.IsCoolingDown(7, remaining));
+	return true;
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModularControllerScriptBypassTest, "ModularController.Behaviours.ScriptEventsBypass"
+	, EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FModularControllerScriptBypassTest::RunTest(const FString& Parameters)
+{
+	UModularControllerTestState* state = NewObject<UModularControllerTestState>();
+	TestTrue(TEXT("The events go through blueprint until the state is initialized"), state->IsCheckStateInScript() && state->IsProcessStateInScript());
+
+	//A native class doesn't override the events in blueprint.
+	state->InitializeState();
+	TestFalse(TEXT("The native CheckState is called directly"), state->IsCheckStateInScript());
+	TestFalse(TEXT("The native ProcessState is called directly"), state->IsProcessStateInScript());
+
+	FBehaviourSnapShotRing runtime;
+	state->InitializeRuntime(runtime, 0);
+	FStatusParameters status;
+	const bool checked = state->CheckState_Internal(runtime.GetRef(), FKinematicInfos(), FVector::ZeroVector, nullptr, nullptr, status, 1.0f / 60.0f);
+	TestTrue(TEXT("The native CheckState result is returned"), checked);
+	TestEqual(TEXT("The native CheckState ran once"), state->NativeCheckCount, 1);
+
+	//A blueprint class overriding CheckState only, as the blueprint compiler lays it out.
+	UBlueprintGeneratedClass* scriptClass = NewObject<UBlueprintGeneratedClass>(GetTransientPackage(), TEXT("ModularControllerTestScriptState_C"), RF_Transient);
+	scriptClass->SetSuperStruct(UModularControllerTestState::StaticClass());
+	scriptClass->ClassWithin = UObject::StaticClass();
+	const FName checkStateName = GET_FUNCTION_NAME_CHECKED(UBaseControllerState, CheckState);
+	UFunction* scriptCheckState = NewObject<UFunction>(scriptClass, checkStateName, RF_Transient);
+	scriptCheckState->FunctionFlags = FUNC_Event | FUNC_BlueprintEvent | FUNC_Public;
+	scriptCheckState->SetSuperStruct(UBaseControllerState::StaticClass()->FindFunctionByName(checkStateName));
+	scriptClass->AddFunctionToFunctionMap(scriptCheckState, checkStateName);
+	scriptClass->Bind();
+	scriptClass->StaticLink(true);
+
+	UModularControllerTestState* scriptState = NewObject<UModularControllerTestState>(GetTransientPackage(), scriptClass);
+	scriptState->InitializeState();
+	TestTrue(TEXT("The blueprint CheckState override is called through the event"), scriptState->IsCheckStateInScript());
+	TestFalse(TEXT("The ProcessState not overriden in blueprint is called directly"), scriptState->IsProcessStateInScript());
+	return true;
+}
+
+
+#endif
@@ -0,0 +1,206 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+
+#include "Misc/AutomationTest.h"
+#include "ComponentAndBase/Structs.h"
+#include "MallocCountingScope.h"
+#include "ModularControllerTestTypes.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+namespace
+{
+	// Listen, record, read and update the inputs of a simulation frame, then capture them to be sent, like a controller does.
+	void RunInputFrame(UInputEntryPool& pool, FInputFrameRing& ring, FNetInputSnapshot& snapshot, int64 frame, int32 buttonHandle, int32 axisHandle, FName buttonKey)
+	{
+		FInputEntry button;
+		button.Nature = EInputEntryNature::InputEntryNature_Button;
+		button.Type = EInputEntryType::InputEntryType_Buffered;
+		FInputEntry axis;
+		axis.Nature = EInputEntryNature::InputEntryNature_Axis;
+		axis.Axis = FVector(FMath::Sin(frame * 0.1), FMath::Cos(frame * 0.1), 0);
+
+		//Registering an already known key must be a lookup only.
+		UInputEntryPool::RegisterInput(buttonKey);
+		if (frame % 3 == 0)
+			pool.AddOrReplace(buttonHandle, button);
+		pool.AddOrReplace(axisHandle, axis);
+
+		const FVector moveInput = FVector(axis.Axis.X, axis.Axis.Y, 0);
+		ring.Record(frame, moveInput, pool);
+		pool.ReadInput(axisHandle);
+		pool.ConsumeInput(buttonHandle);
+		pool.UpdateInputs(1.0f / 60.0f);
+		snapshot.Capture(pool);
+	}
+
+	// Feed and consume the move direction, then check the actions, like a controller update does.
+	void RunControllerFrame(UModularControllerTestComponent& controller, UInputEntryPool& pool, int64 frame, int32 triggerHandle)
+	{
+		FInputEntry trigger;
+		trigger.Nature = EInputEntryNature::InputEntryNature_Button;
+		if (frame % 2 == 0)
+			pool.AddOrReplace(triggerHandle, trigger);
+
+		controller.MovementInput(FVector(FMath::Sin(frame * 0.1), FMath::Cos(frame * 0.1), 0));
+		const FVector moveInput = controller.ConsumeMovementInput();
+		FKinematicInfos kinematics;
+		FStatusParameters status;
+		controller.CheckControllerActions(kinematics, moveInput, &pool, INDEX_NONE, INDEX_NONE, 1.0f / 60.0f, status);
+		pool.UpdateInputs(1.0f / 60.0f);
+	}
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModularControllerInputAllocationsTest, "ModularController.Inputs.SteadyStateAllocations"
+	, EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FModularControllerInputAllocationsTest::RunTest(const FString& Parameters)
+{
+#if defined(PLATFORM_USES_FIXED_GMalloc_CLASS) && PLATFORM_USES_FIXED_GMalloc_CLASS
+	AddInfo(TEXT("The allocator can't be hooked on this platform, allocations are not counted."));
+	return true;
+#else
+	const FName buttonKey = TEXT("Test_AllocationsButton");
+	const FName axisKey = TEXT("Test_AllocationsAxis");
+	const int32 buttonHandle = UInputEntryPool::RegisterInput(buttonKey);
+	const int32 axisHandle = UInputEntryPool::RegisterInput(axisKey);
+
+	UInputEntryPool* pool = NewObject<UInputEntryPool>();
+	pool->Reserve(UInputEntryPool::GetRegisteredInputCount());
+	FInputFrameRing ring;
+	ring.Initialize(16);
+	FNetInputSnapshot snapshot;
+
+	UModularControllerTestComponent* controller = NewObject<UModularControllerTestComponent>();
+	controller->AddControllerAction(UModularControllerTestAction::StaticClass());
+	UModularControllerTestAction* action = Cast<UModularControllerTestAction>(controller->GetActionByType(UModularControllerTestAction::StaticClass()));
+	const int32 triggerHandle = UInputEntryPool::RegisterInput(UModularControllerTestAction::GetTriggerKey());
+	UInputEntryPool* controllerPool = NewObject<UInputEntryPool>();
+	controllerPool->Reserve(UInputEntryPool::GetRegisteredInputCount());
+
+	//Warm up: the first frames fill the ring, the entries templates and the move direction history.
+	int64 frame = 0;
+	for (; frame < 32; frame++)
+	{
+		RunInputFrame(*pool, ring, snapshot, frame, buttonHandle, axisHandle, buttonKey);
+		RunControllerFrame(*controller, *controllerPool, frame, triggerHandle);
+	}
+
+	int32 allocations = 0;
+	const int32 checksBefore = action ? action->NativeCheckCount : 0;
+	{
+		FMallocCountingScope mallocScope;
+		for (; frame < 32 + 600; frame++)
+		{
+			RunInputFrame(*pool, ring, snapshot, frame, buttonHandle, axisHandle, buttonKey);
+			RunControllerFrame(*controller, *controllerPool, frame, triggerHandle);
+		}
+		allocations = mallocScope.GetAllocationCount();
+	}
+
+	TestEqual(TEXT("Heap allocations over 600 steady state input frames"), allocations, 0);
+	TestTrue(TEXT("The triggered action is checked"), action && action->NativeCheckCount > checksBefore);
+	return true;
+#endif
+}
+
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FModularControllerInputRingTest, "ModularController.Inputs.InputFrameRing"
+	, EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FModularControllerInputRingTest::RunTest(const FString& Parameters)
+{
+	const int32 buttonHandle = UInputEntryPool::RegisterInput(TEXT("Test_RingButton"));
+	const int32 axisHandle = UInputEntryPool::RegisterInput(TEXT("Test_RingAxis"));
+	const FVector moveInput = FVector(0.25, -0.5, 0);
+	const FVector axisValue = FVector(0.125, 0.75, -1);
+
+	UInputEntryPool* pool = NewObject<UInputEntryPool>();
+	FInputEntry button;
+	button.Nature = EInputEntryNature::InputEntryNature_Button;
+	button.Type = EInputEntryType::InputEntryType_Buffered;
+	button.InputBuffer = 0.35f;
+	FInputEntry axis;
+	axis.Nature = EInputEntryNature::InputEntryNature_Axis;
+	axis.Axis = axisValue;
+	pool->AddOrReplace(buttonHandle, button);
+	pool->AddOrReplace(axisHandle, axis);
+
+	FInputFrameRing ring;
+	ring.Initialize(4);
+	ring.Record(5, moveInput, *pool);
+	//Consuming after the record must not change what was recorded.
+	pool->ConsumeInput(buttonHandle);
+	TestTrue(TEXT("The recorded frame is in the ring"), ring.Contains(5));
+	TestFalse(TEXT("A frame never recorded is not in the ring"), ring.Contains(6));
+
+	TArray<uint8> bytes;
+	TestTrue(TEXT("The recorded frame is written"), ring.ToBytes(5, bytes));
+	TArray<uint8> missingBytes;
+	TestFalse(TEXT("A frame not in the ring is not written"), ring.ToBytes(6, missingBytes));
+
+	//A second ring, as on another machine.
+	FInputFrameRing receivedRing;
+	receivedRing.Initialize(8);
+	TestTrue(TEXT("The bytes are read"), receivedRing.FromBytes(bytes));
+	TestFalse(TEXT("Truncated bytes are rejected"), receivedRing.FromBytes(TArrayView<const uint8>(bytes.GetData(), bytes.Num() - 1)));
+
+	UInputEntryPool* replayPool = NewObject<UInputEntryPool>();
+	FVector replayedMove = FVector::ZeroVector;
+	TestTrue(TEXT("The received frame is replayed"), receivedRing.Replay(5, *replayPool, replayedMove));
+	TestTrue(TEXT("The move input is replayed"), replayedMove.Equals(moveInput, FInputFrame::AxisPrecision));
+
+	const FInputEntry replayedButton = replayPool->ReadInput(buttonHandle);
+	TestEqual(TEXT("The button is replayed pressed"), replayedButton.Phase.GetValue(), EInputEntryPhase::InputEntryPhase_Pressed);
+	TestEqual(TEXT("The button keeps it's type"), replayedButton.Type.GetValue(), EInputEntryType::InputEntryType_Buffered);
+	const FInputEntry replayedAxis = replayPool->ReadInput(axisHandle);
+	TestEqual(TEXT("The axis keeps it's nature"), replayedAxis.Nature.GetValue(), EInputEntryNature::InputEntryNature_Axis);
+	TestTrue(TEXT("The axis value is replayed"), replayedAxis.Axis.Equals(axisValue, FInputFrame::AxisPrecision));
+
+	//The ring only keeps it's capacity of frames.
+	ring.Record(9, moveInput, *pool);
+	TestFalse(TEXT("An overwritten frame is not in the ring anymore"), ring.Contains(5));
+	TestFalse(TEXT("An overwritten frame is not replayed"), ring.Replay(5, *replayPool, replayedMove));
+
+	//Any number of buttons and axes, whatever their handles.
+	constexpr int32 wideCount = 80;
+	TArray<int32> wideHandles;
+	UInputEntryPool* widePool = NewObject<UInputEntryPool>();
+	for (int32 i = 0; i < wideCount; i++)
+	{
+		wideHandles.Add(UInputEntryPool::RegisterInput(FName(*FString::Printf(TEXT("Test_RingWideInput_%d"), i))));
+		FInputEntry entry;
+		entry.Nature = i % 2 == 0 ? EInputEntryNature::InputEntryNature_Button : EInputEntryNature::InputEntryNature_Axis;
+		entry.Axis = FVector(i * 0.01, 0, 0);
+		widePool->AddOrReplace(wideHandles[i], entry);
+	}
+	FInputFrameRing wideRing;
+	wideRing.Initialize(2);
+	wideRing.Record(0, moveInput, *widePool);
+
+	//The layout of a frame is it's own: a later frame listening the input differently doesn't change it.
+	FInputEntry bufferedButton;
+	bufferedButton.Nature = EInputEntryNature::InputEntryNature_Button;
+	bufferedButton.Type = EInputEntryType::InputEntryType_Buffered;
+	bufferedButton.InputBuffer = 0.5f;
+	widePool->AddOrReplace(wideHandles[0], bufferedButton);
+	wideRing.Record(1, moveInput, *widePool);
+
+	UInputEntryPool* wideReplayPool = NewObject<UInputEntryPool>();
+	TestTrue(TEXT("The wide frame is replayed"), wideRing.Replay(0, *wideReplayPool, replayedMove));
+	int32 replayedCount = 0;
+	for (const int32 handle : wideHandles)
+	{
+		if (wideReplayPool->IsInputLive(handle))
+			replayedCount++;
+	}
+	TestEqual(TEXT("Every input listened is replayed"), replayedCount, wideCount);
+	TestTrue(TEXT("The last axis value is replayed"), wideReplayPool->ReadInput(wideHandles[wideCount - 1]).Axis.Equals(FVector((wideCount - 1) * 0.01, 0, 0), FInputFrame::AxisPrecision));
+	TestEqual(TEXT("A frame keeps the type the input had on it"), wideReplayPool->ReadInput(wideHandles[0]).Type.GetValue(), EInputEntryType::InputEntryType_Simple);
+	return true;
+}
+
+
+#endif
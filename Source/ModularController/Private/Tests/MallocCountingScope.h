@@ -0,0 +1,98 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+
+/*
+* Count the heap allocations made by the thread that opened the scope, while it's open.
+* Forwards everything to the allocator in place, so memory allocated before or after the scope is freed normally.
+*/
+class FMallocCountingScope : public FMalloc
+{
+public:
+
+	FMallocCountingScope()
+		: _inner(GMalloc)
+		, _threadId(FPlatformTLS::GetCurrentThreadId())
+	{
+		GMalloc = this;
+	}
+
+	virtual ~FMallocCountingScope() override
+	{
+		GMalloc = _inner;
+	}
+
+	// The number of allocations made by the thread of the scope so far.
+	FORCEINLINE int32 GetAllocationCount() const { return _allocationCount.load(); }
+
+	virtual void* Malloc(SIZE_T count, uint32 alignment) override
+	{
+		Count();
+		return _inner->Malloc(count, alignment);
+	}
+
+	virtual void* TryMalloc(SIZE_T count, uint32 alignment) override
+	{
+		Count();
+		return _inner->TryMalloc(count, alignment);
+	}
+
+	virtual void* Realloc(void* original, SIZE_T count, uint32 alignment) override
+	{
+		if (count > 0)
+			Count();
+		return _inner->Realloc(original, count, alignment);
+	}
+
+	virtual void* TryRealloc(void* original, SIZE_T count, uint32 alignment) override
+	{
+		if (count > 0)
+			Count();
+		return _inner->TryRealloc(original, count, alignment);
+	}
+
+	virtual void Free(void* original) override { _inner->Free(original); }
+
+	virtual SIZE_T QuantizeSize(SIZE_T count, uint32 alignment) override { return _inner->QuantizeSize(count, alignment); }
+
+	virtual bool GetAllocationSize(void* original, SIZE_T& sizeOut) override { return _inner->GetAllocationSize(original, sizeOut); }
+
+	virtual void Trim(bool bTrimThreadCaches) override { _inner->Trim(bTrimThreadCaches); }
+
+	virtual void SetupTLSCachesOnCurrentThread() override { _inner->SetupTLSCachesOnCurrentThread(); }
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override { _inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+
+	virtual bool IsInternallyThreadSafe() const override { return _inner->IsInternallyThreadSafe(); }
+
+	virtual bool ValidateHeap() override { return _inner->ValidateHeap(); }
+
+	virtual const TCHAR* GetDescriptiveName() override { return _inner->GetDescriptiveName(); }
+
+private:
+
+	FORCEINLINE void Count()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == _threadId)
+			_allocationCount++;
+	}
+
+	// The allocator in place when the scope opened.
+	FMalloc* _inner;
+
+	// The thread whose allocations are counted.
+	uint32 _threadId;
+
+	std::atomic<int32> _allocationCount = 0;
+};
+
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+#pragma once
+#include "ComponentAndBase/BaseControllerState.h"
+#include "ComponentAndBase/BaseControllerAction.h"
+#include "ComponentAndBase/ModularControllerComponent.h"
+#include "ModularControllerTestTypes.generated.h"
+
+
+
+/**
+ A concrete state for the automation tests, exposing the blueprint events bypass.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UModularControllerTestState : public UBaseControllerState
+{
+	GENERATED_BODY()
+
+public:
+
+	// The number of times the native CheckState ran.
+	int32 NativeCheckCount = 0;
+
+	FORCEINLINE bool IsCheckStateInScript() const { return _checkStateInScript; }
+
+	FORCEINLINE bool IsProcessStateInScript() const { return _processStateInScript; }
+
+	virtual bool CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus = -1) override
+	{
+		NativeCheckCount++;
+		return true;
+	}
+};
+
+
+
+/**
+ A concrete action for the automation tests, only checked while it's trigger input is live. Never activates.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UModularControllerTestAction : public UBaseControllerAction
+{
+	GENERATED_BODY()
+
+public:
+
+	// The input triggering the action.
+	static FName GetTriggerKey() { return TEXT("Test_ActionTrigger"); }
+
+	UModularControllerTestAction()
+	{
+		TriggerInputs.Add(GetTriggerKey());
+	}
+
+	// The number of times the native CheckAction ran.
+	int32 NativeCheckCount = 0;
+
+	virtual bool CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override
+	{
+		NativeCheckCount++;
+		return false;
+	}
+};
+
+
+
+/**
+ A controller for the automation tests, exposing the actions check.
+ */
+UCLASS(Transient, NotBlueprintable, HideDropdown)
+class UModularControllerTestComponent : public UModularControllerComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	using UModularControllerComponent::CheckControllerActions;
+};
@@ -6,6 +6,29 @@
 
 
 
+// The runtime properties of the dash action for one controller.
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FDashActionRuntime : public FControllerActionRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(BlueprintReadOnly, category = "Dash")
+	FVector DashToLocation = FVector(0);
+
+	UPROPERTY()
+	FVector PropulsionLocation = FVector(0);
+
+	UPROPERTY()
+	bool bDashed = false;
+
+	UPROPERTY()
+	FQuat InitialRot = FQuat::Identity;
+};
+
+
+
 UCLASS(BlueprintType, Blueprintable, ClassGroup = "Controller Action Behaviours", abstract)
 class MODULARCONTROLLER_API UBaseDashAction : public UBaseControllerAction
 {
@@ -18,6 +41,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Inputs")
 	FName DashInputCommand;
 
+	// The handle of the dash input, resolved when the action is initialized.
+	int32 _dashInputHandle = INDEX_NONE;
+
 	//[Axis] The Name of the Axis Dash location input. this is the location where the controller will try to Dash to. If a value is set and not used, the controller will always try to Dash to zero location.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Inputs")
 	FName DashLocationInput;
@@ -33,7 +59,7 @@ public:
 	/// </summary>
 	/// <param name="controller"></param>
 	/// <returns></returns>
-	bool CheckDash(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, FStatusParameters controllerStatusParam,
+	bool CheckDash(FDashActionRuntime& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, FStatusParameters controllerStatusParam,
 		FStatusParameters& currentStatus, const float inDelta, UModularControllerComponent* controller);
 
 
@@ -90,24 +116,6 @@ protected:
 
 
 	//------------------------------------------------------------------------------------------
-	
-	FVector _dashToLocation;
-	FVector _dashToLocation_saved;
-
-	FVector _propulsionLocation;
-	FVector _propulsionLocation_saved;
-
-	bool _dashed;
-	bool _dashed_saved;
-
-	FQuat _initialRot;
-	FQuat _initialRot_saved;
-
-
-	/// <summary>
-	/// The end montage delegate.
-	/// </summary>
-	FOnMontageEnded _EndDelegate;
 
 
 	/// <summary>
@@ -123,30 +131,31 @@ protected:
 #pragma region Functions
 public:
 	
+	virtual void InitializeAction() override;
+
+	virtual const UScriptStruct* GetRuntimeStruct() const override { return FDashActionRuntime::StaticStruct(); }
 
-	virtual bool CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	virtual bool CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
+	virtual void GetActionTriggerInputs(TArray<FName>& outInputs) const override;
 
-	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual FVelocity OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
+	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+
+	virtual FVelocity OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
 		, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
 
-	virtual	void OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState) override;
+	virtual	void OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState) override;
 
-	virtual void OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
+	virtual void OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
 		FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
-	virtual void OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
+	virtual void OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller,
 		FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
-	virtual void SaveActionSnapShot_Internal() override;
-
-	virtual void RestoreActionFromSnapShot_Internal() override;
-
 #pragma endregion
 };
@@ -3,10 +3,42 @@
 #pragma once
 #include "Animation/AnimMontage.h"
 #include "ComponentAndBase/BaseControllerAction.h"
+#include "WorldCollision.h"
 #include "JumpActionBase.generated.h"
 
 
 
+// The runtime properties of the jump action for one controller.
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FJumpActionRuntime : public FControllerActionRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	//The asynchronous ceiling probe issued for the next frame. Kept as a raw handle to be part of the runtime properties.
+	UPROPERTY()
+	uint64 AsyncCeilingCheckHandle = 0;
+
+	//The position the asynchronous ceiling probe was issued from.
+	UPROPERTY()
+	FVector AsyncCeilingCheckStart = FVector(0);
+
+	//the normal of the surface we jumped from
+	UPROPERTY()
+	FVector JumpSurfaceNormal = FVector(0);
+
+	//the momentum when entered action
+	UPROPERTY()
+	FVelocity StartMomentum;
+
+	//the jump propulsion just occured
+	UPROPERTY(BlueprintReadOnly, category = "Jump")
+	bool bJumped = false;
+};
+
+
+
 UCLASS(BlueprintType, Blueprintable, ClassGroup = "Controller Action Behaviours", abstract)
 class MODULARCONTROLLER_API UJumpActionBase : public UBaseControllerAction
 {
@@ -19,6 +51,9 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Inputs")
 	FName JumpInputCommand;
 
+	// The handle of the jump input, resolved when the action is initialized.
+	int32 _jumpInputHandle = INDEX_NONE;
+
 	//[Axis] The Name of the jump location Axis input. this is the location where the controller will try to land. If a value is set and not used, the controller will always try to jump at zero location.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Inputs")
 	FName JumpLocationInput;
@@ -28,6 +63,10 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Jump Parameters")
 	bool UsePhysicOnInteractions = true;
 
+	// Should the ceiling be probed asynchronously? The probe for the next frame is issued on this frame and consumed on the next one. Falls back on a blocking probe when the result is missing.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Jump Parameters")
+	bool bUseAsyncCeilingCheck = false;
+
 	//------------------------------------------------------------------------------------------
 
 
@@ -39,7 +78,13 @@ public:
 	/// </summary>
 	/// <param name="controller"></param>
 	/// <returns></returns>
-	bool CheckJump(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, const float inDelta, UModularControllerComponent* controller);
+	bool CheckJump(FJumpActionRuntime& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, const float inDelta, UModularControllerComponent* controller);
+
+	/// <summary>
+	/// Check if the ceiling is too close to jump.
+	/// </summary>
+	/// <param name="probe">Should the ceiling be probed this frame? when false, only keeps the asynchronous probe going.</param>
+	bool CheckCeiling(FJumpActionRuntime& runtime, const FKinematicInfos& inDatas, const float inDelta, UModularControllerComponent* controller, bool probe);
 	
 #pragma endregion
 
@@ -86,24 +131,6 @@ protected:
 
 
 	//------------------------------------------------------------------------------------------
-		
-	//the normal of the surface we jumped from
-	FVector _jumpSurfaceNormal;
-	FVector _jumpSurfaceNormal_saved;
-
-	//the momentum when entered action
-	FVelocity _startMomentum;
-	FVelocity _startMomentum_saved;
-
-	//the jump propulsion just occured
-	bool _jumped;
-	bool _jumped_saved;
-
-
-	/// <summary>
-	/// The end montage delegate.
-	/// </summary>
-	FOnMontageEnded _EndDelegate;
 
 
 	/// <summary>
@@ -121,7 +148,7 @@ public:
 	/// </summary>
 	/// <param name="controller"></param>
 	/// <returns></returns>
-	FVector Jump(const FKinematicInfos inDatas, FVector moveInput, const FVelocity momentum, const float inDelta, FVector customJumpLocation = FVector(NAN));
+	FVector Jump(const FJumpActionRuntime& runtime, const FKinematicInfos inDatas, FVector moveInput, const FVelocity momentum, const float inDelta, FVector customJumpLocation = FVector(NAN));
 	
 
 #pragma endregion
@@ -129,26 +156,28 @@ public:
 #pragma region Functions
 public:
 
-	virtual bool CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
-		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
+	virtual void InitializeAction() override;
 
-	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual const UScriptStruct* GetRuntimeStruct() const override { return FJumpActionRuntime::StaticStruct(); }
 
-	virtual FVelocity OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
-		, UModularControllerComponent* controller, const float inDelta) override;
+	virtual bool CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
-	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual void GetActionTriggerInputs(TArray<FName>& outInputs) const override;
 
+	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+
+	virtual FVelocity OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
+		, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual	void OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState) override;
+	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual void OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
-	virtual void OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
+	virtual	void OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState) override;
 
-	virtual void SaveActionSnapShot_Internal() override;
+	virtual void OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
-	virtual void RestoreActionFromSnapShot_Internal() override;
+	virtual void OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta) override;
 
 #pragma endregion
 
@@ -16,6 +16,50 @@
 
 
 
+///<summary>
+/// The runtime properties of an action for one controller. Actions keeping their own derive it and return it from GetRuntimeStruct, the action definition is left untouched at runtime.
+/// </summary>
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FControllerActionRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	// The action actual phase.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	TEnumAsByte<EActionPhase> CurrentPhase;
+
+	// The anticipation phase duration, remapped at runtime.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	float AnticipationPhaseDuration = 0;
+
+	// The active phase duration, remapped at runtime.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	float ActivePhaseDuration = 0;
+
+	// The recovery phase duration, remapped at runtime.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	float RecoveryPhaseDuration = 0;
+
+	// The time left to the action to be cooling down.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	double CoolDownTimer = 0;
+
+	// The time left to the action to be active.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	double RemainingActivationTimer = 0;
+
+	// Has the action been active in the controller the last frame?
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	bool bWasActiveFrame = false;
+
+	// Is the action running as a part of a simulation? Set while the simulation snapshot waits to be restored.
+	UPROPERTY(BlueprintReadOnly, category = "Action Runtime")
+	bool bIsSimulated = false;
+};
+
+
 ///<summary>
 /// The abstract basic Action behaviour for a Modular controller.
 /// </summary>
@@ -26,7 +70,14 @@ class MODULARCONTROLLER_API UBaseControllerAction : public UDataAsset
 
 public:
 
-	void InitializeAction();
+	// Initialize the action instance. Called once the instance is created, before any controller uses it.
+	virtual void InitializeAction();
+
+	// The runtime struct holding the properties of this action for one controller. Must derive FControllerActionRuntime.
+	virtual const UScriptStruct* GetRuntimeStruct() const { return FControllerActionRuntime::StaticStruct(); }
+
+	// Allocate the runtime properties of a controller using this action, keeping snapShotDepth past frames of them.
+	void InitializeRuntime(FBehaviourSnapShotRing& runtime, int snapShotDepth) const;
 
 	// The State's unique name
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base")
@@ -36,10 +87,6 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base")
 	int ActionPriority = 0;
 
-	
-	// The action actual phase.
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, category = "Base|Timing|Phasing")
-	TEnumAsByte<EActionPhase> CurrentPhase;
 
 	// The action anticipation phase duration
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base|Timing|Phasing", meta = (ClampMin = "0.0", UIMin = "0.0"))
@@ -59,6 +106,16 @@ public:
 
 
 
+	// The inputs that can trigger the action. When the action has trigger inputs, it's only checked while one of them is live in the input pool.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base|Inputs")
+	TArray<FName> TriggerInputs;
+
+	// Check the action every frame, whatever it's trigger inputs.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base|Inputs")
+	bool bAlwaysEvaluate;
+
+
+
 	// The action cool down delay. the duration the action cannot be done again.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base|Timing")
 	float CoolDownDelay = 0.25f;
@@ -101,6 +158,16 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Base|Debug")
 	bool bDebugAction;
 
+	// Is the debug of this action shown? Always false when the debug is compiled out.
+	FORCEINLINE bool IsDebugging() const
+	{
+#if MODULAR_CONTROLLER_DEBUG
+		return bDebugAction;
+#else
+		return false;
+#endif
+	}
+
 
 
 
@@ -109,21 +176,21 @@ public:
 	/// When we enters the action behaviour.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnActionBegins(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
+	void OnActionBegins(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual void OnActionBegins_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
+	virtual void OnActionBegins_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
 
 
 	/// <summary>
 	/// When we exit the action.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnActionEnds(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
+	void OnActionEnds(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual void OnActionEnds_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
+	virtual void OnActionEnds_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -132,12 +199,12 @@ public:
 	/// Check if the action is Valid
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	bool CheckAction(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam
+	bool CheckAction(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam
 		, FStatusParameters& currentStatus, const float inDelta);
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual bool CheckAction_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	virtual bool CheckAction_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta);
 
 
@@ -148,11 +215,11 @@ public:
 	/// Process action's anticipation phase and return velocity.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	FVelocity OnActionProcessAnticipationPhase(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	FVelocity OnActionProcessAnticipationPhase(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
+	virtual FVelocity OnActionProcessAnticipationPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
 		, UModularControllerComponent* controller, const float inDelta);
 
 
@@ -160,11 +227,11 @@ public:
 	/// Process action's active phase and return velocity.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	FVelocity OnActionProcessActivePhase(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	FVelocity OnActionProcessActivePhase(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual FVelocity OnActionProcessActivePhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
+	virtual FVelocity OnActionProcessActivePhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
 		, UModularControllerComponent* controller, const float inDelta);
 
 
@@ -172,11 +239,11 @@ public:
 	/// Process action's recovery phase and return velocity.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	FVelocity OnActionProcessRecoveryPhase(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	FVelocity OnActionProcessRecoveryPhase(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
+	virtual FVelocity OnActionProcessRecoveryPhase_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput
 		, UModularControllerComponent* controller, const float inDelta);
 
 
@@ -188,19 +255,19 @@ public:
 	/// </summary>
 	/// <returns></returns>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnStateChanged(UBaseControllerState* newState, UBaseControllerState* oldState);
+	void OnStateChanged(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState);
 
 	/// <summary>
 	/// Get Notify actions the active action change. whether the action is active or not.
 	/// </summary>
 	/// <returns></returns>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnActionChanged(UBaseControllerAction* newAction, UBaseControllerAction* lastAction);
+	void OnActionChanged(const FBehaviourRuntimeRef& runtime, UBaseControllerAction* newAction, UBaseControllerAction* lastAction);
 
 
 	// Called when the action phase changed while not simulated.
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnActionPhaseChanged(EActionPhase newPhase, EActionPhase lastPhase);
+	void OnActionPhaseChanged(const FBehaviourRuntimeRef& runtime, EActionPhase newPhase, EActionPhase lastPhase);
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -210,27 +277,27 @@ public:
 	/// Is this Action been active in the controller the last frame?
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	bool GetActivatedLastFrame();
+	bool GetActivatedLastFrame(const FBehaviourRuntimeRef& runtime) const;
 
 
 	/// <summary>
 	/// Is this Action been active in the controller the last frame?
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	void SetActivatedLastFrame(bool value);
+	void SetActivatedLastFrame(const FBehaviourRuntimeRef& runtime, bool value) const;
 
 
 	/// <summary>
 	/// Get the time left to the action to still be active.
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	double GetRemainingActivationTime();
+	double GetRemainingActivationTime(const FBehaviourRuntimeRef& runtime) const;
 
 	/// <summary>
 	/// Get the time left to the action to still be cooling down.
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	double GetRemainingCoolDownTime();
+	double GetRemainingCoolDownTime(const FBehaviourRuntimeRef& runtime) const;
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -240,7 +307,7 @@ public:
 	/// Debug
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Debug")
-	virtual FString DebugString();
+	virtual FString DebugString(const FBehaviourRuntimeRef& runtime);
 
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -261,19 +328,29 @@ public:
 
 
 	/// <summary>
-	/// Save a snap shot of the action.
+	/// Save a snap shot of the action's runtime properties, before a simulation.
+	/// </summary>
+	static void SaveActionSnapShot(FBehaviourSnapShotRing& runtime);
+
+	/// <summary>
+	/// Restore the action's runtime properties from their snapShot, if a simulation saved one.
 	/// </summary>
-	void SaveActionSnapShot();
+	static void RestoreActionFromSnapShot(FBehaviourSnapShotRing& runtime);
 
 	/// <summary>
-	/// Restore an action from it's previous snapShot if exist.
+	/// Get the inputs that can trigger the action. No input means the action is checked every frame.
 	/// </summary>
-	void RestoreActionFromSnapShot();
+	virtual void GetActionTriggerInputs(TArray<FName>& outInputs) const;
+
+	/// <summary>
+	/// Enter a phase of the activation, and notify the change. The phases only move forward until the action ends.
+	/// </summary>
+	void EnterPhase(const FBehaviourRuntimeRef& runtime, EActionPhase phase);
 	
 
 
 	UFUNCTION(BlueprintCallable, Category = "Action|Base Events|C++ Implementation")
-	virtual void OnStateChanged_Implementation(UBaseControllerState* newState, UBaseControllerState* oldState);
+	virtual void OnStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, UBaseControllerState* newState, UBaseControllerState* oldState);
 
 
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -285,88 +362,46 @@ public:
 	/// <summary>
 	/// When we enters the action behaviour.
 	/// </summary>
-	void OnActionBegins_Internal(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta);
+	void OnActionBegins_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta);
 
 	/// <summary>
 	/// When we exit the action.
 	/// </summary>
-	void OnActionEnds_Internal(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta);
+	void OnActionEnds_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, FStatusParameters& currentStatus, const float inDelta);
 
 	/// <summary>
 	/// Check if the action is Valid
 	/// </summary>
-	bool CheckAction_Internal(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	bool CheckAction_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 		, FStatusParameters& currentStatus, const float inDelta);
 
 	/// <summary>
 	/// Process action and return velocity.
 	/// </summary>
-	FVelocity OnActionProcess_Internal(FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	FVelocity OnActionProcess_Internal(const FBehaviourRuntimeRef& runtime, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVelocity fromVelocity, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 
 	///Check if this is running as a part of a simulation
 	UFUNCTION(BlueprintCallable, Category = "Action|Others")
-	FORCEINLINE bool IsSimulated() const { return _snapShotSaved; }
+	bool IsSimulated(const FBehaviourRuntimeRef& runtime) const;
 
 	//Remap the durations
 	UFUNCTION(BlueprintCallable, Category = "Action|Others")
-	FORCEINLINE void RemapDuration(float duration, bool tryDontMapAnticipation = false, bool tryDontMapRecovery = false)
-	{
-		const float anticipationScale = _startingDurations.X / (_startingDurations.X + _startingDurations.Y + _startingDurations.Z);
-		const float recoveryScale = _startingDurations.Z / (_startingDurations.X + _startingDurations.Y + _startingDurations.Z);
-		//Anticipation
-		float newAnticipation = duration * anticipationScale;
-		if (tryDontMapAnticipation)
-		{
-			newAnticipation = FMath::Clamp(_startingDurations.X, 0, FMath::Clamp((duration * 0.5f) - 0.05, 0, TNumericLimits<float>().Max()));
-		}
-
-		//Recovery
-		float newRecovery = duration * recoveryScale;
-		if (tryDontMapRecovery)
-		{
-			newRecovery = FMath::Clamp(_startingDurations.Z, 0, FMath::Clamp((duration * 0.5f) - 0.05, 0, TNumericLimits<float>().Max()));
-		}
-
-		const float newDuration = duration - (newAnticipation + newRecovery);
-
-		AnticipationPhaseDuration = newAnticipation;
-		ActivePhaseDuration = newDuration;
-		RecoveryPhaseDuration = newRecovery;
-
-
-		if (bDebugAction)
-		{
-			UKismetSystemLibrary::PrintString(this, FString::Printf(TEXT("Remap from (%s) to (%s)"), *_startingDurations.ToCompactString(), *FVector(AnticipationPhaseDuration, ActivePhaseDuration, RecoveryPhaseDuration).ToCompactString()), true, true, FColor::Orange, 5, "remapingDuration");
-		}
-	}
+	void RemapDuration(const FBehaviourRuntimeRef& runtime, float duration, bool tryDontMapAnticipation = false, bool tryDontMapRecovery = false) const;
 
 protected:
 
-	double _cooldownTimer;
-
-	double _cooldownTimer_saved;
-
-	double _remainingActivationTimer;
-
-	double _remainingActivationTimer_saved;
-
-	int _repeatCount;
-
-	int _repeatCount_saved;
-
-	bool _wasActiveFrame;
-
-	bool _wasActiveFrame_saved;
-
-	bool _snapShotSaved;
-
-	FVector _startingDurations;
+	// Is CheckAction overriden in blueprint? true until the action is initialized.
+	bool _checkActionInScript = true;
 
+	// Is OnActionProcessAnticipationPhase overriden in blueprint? true until the action is initialized.
+	bool _anticipationPhaseInScript = true;
 
-	virtual void SaveActionSnapShot_Internal();
+	// Is OnActionProcessActivePhase overriden in blueprint? true until the action is initialized.
+	bool _activePhaseInScript = true;
 
-	virtual void RestoreActionFromSnapShot_Internal();
+	// Is OnActionProcessRecoveryPhase overriden in blueprint? true until the action is initialized.
+	bool _recoveryPhaseInScript = true;
 
 };
@@ -22,6 +22,34 @@
 class UModularControllerComponent;
 
 
+///<summary>
+/// The runtime properties of a state for one controller. States keeping their own derive it and return it from GetRuntimeStruct, the state definition is left untouched at runtime.
+/// </summary>
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FControllerStateRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	// The informations on the current surface. This is used to track one surface movements
+	UPROPERTY(BlueprintReadOnly, category = "State Runtime")
+	FSurfaceInfos SurfaceInfos;
+
+	// Has the state been the controller state the last frame?
+	UPROPERTY(BlueprintReadOnly, category = "State Runtime")
+	bool bWasTheLastFrameBehaviour = false;
+
+	// Is the state running as a part of a simulation? Set while the simulation snapshot waits to be restored.
+	UPROPERTY(BlueprintReadOnly, category = "State Runtime")
+	bool bIsSimulated = false;
+
+	// The time of the controller from which the state is checked again, when time sliced.
+	UPROPERTY()
+	double NextCheckTime = 0;
+};
+
+
 ///<summary>
 /// The abstract basic state behaviour for a Modular controller.
 /// </summary>
@@ -49,18 +77,28 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Base|Basic State  Parameters")
 	TEnumAsByte<ERootMotionType> RootMotionMode;
 
-	// The informations on the current surface. This is used to track one surface movements
-	UPROPERTY(BlueprintReadOnly, category = "Base|Basic State  Parameters")
-	FSurfaceInfos SurfaceInfos;
-
 	// The state's flag, often used as binary. to relay this State's state over the network.
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, category = "Base|Basic State  Parameters")
 	int StateFlag;
 
+	// The minimum time between two checks of this state while it's not the active state. 0 checks it every update.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Base|Basic State  Parameters", meta = (ClampMin = 0))
+	float CheckInterval = 0;
+
 	// Enable or disable debug for this state
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Base|Basic State  Parameters")
 	bool bDebugState;
 
+	// Is the debug of this state shown? Always false when the debug is compiled out.
+	FORCEINLINE bool IsDebugging() const
+	{
+#if MODULAR_CONTROLLER_DEBUG
+		return bDebugState;
+#else
+		return false;
+#endif
+	}
+
 
 
 
@@ -70,13 +108,13 @@ public:
 	/// When we enters the state.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, category = "State|Basic Events")
-	void OnEnterState(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	void OnEnterState(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 	/// <summary>
 	/// When we exit the state.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, category = "State|Basic Events")
-	void OnExitState(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	void OnExitState(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -85,7 +123,7 @@ public:
 	/// Check if the state is Valid
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, category = "State|Basic Events")
-	bool CheckState(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam
+	bool CheckState(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller, FStatusParameters controllerStatusParam
 		, FStatusParameters& currentStatus, const float inDelta
 		, int overrideWasLastStateStatus = -1);
 
@@ -97,7 +135,7 @@ public:
 	/// Process state and return velocity.
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, category = "State|Basic Events")
-	FVelocity ProcessState(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	FVelocity ProcessState(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 
@@ -108,14 +146,14 @@ public:
 	/// When the controller change a State, it call this function to notify all of it's states the change
 	/// </summary>
 	UFUNCTION(BlueprintNativeEvent, category = "State|Basic Events")
-	void OnControllerStateChanged(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller);
+	void OnControllerStateChanged(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller);
 
 	/// <summary>
 	/// Get Notify actions the active action change. whether the action is active or not.
 	/// </summary>
 	/// <returns></returns>
 	UFUNCTION(BlueprintNativeEvent, Category = "Action|Base Events")
-	void OnActionChanged(UBaseControllerAction* newAction, UBaseControllerAction* lastAction);
+	void OnActionChanged(const FBehaviourRuntimeRef& runtime, UBaseControllerAction* newAction, UBaseControllerAction* lastAction);
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -125,14 +163,20 @@ public:
 	/// Is this behaviour been used by the controller the last frame?
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	bool GetWasTheLastFrameControllerState();
+	bool GetWasTheLastFrameControllerState(const FBehaviourRuntimeRef& runtime) const;
 
 
 	/// <summary>
 	/// Is this behaviour been used by the controller the last frame?
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
-	void SetWasTheLastFrameControllerState(bool value);
+	void SetWasTheLastFrameControllerState(const FBehaviourRuntimeRef& runtime, bool value) const;
+
+	/// <summary>
+	/// Get the informations on the surface the controller is on with this state.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, category = "State|Basic Events")
+	FSurfaceInfos GetSurfaceInfos(const FBehaviourRuntimeRef& runtime) const;
 
 
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -142,7 +186,7 @@ public:
 	/// Debug
 	/// </summary>
 	UFUNCTION(BlueprintCallable, category = "State|Basic Debug")
-	virtual FString DebugString();
+	virtual FString DebugString(const FBehaviourRuntimeRef& runtime);
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -162,14 +206,52 @@ public:
 
 
 	/// <summary>
-	/// Save a snap shot of the state.
+	/// Initialize the state instance. Called once the instance is created, before any controller uses it.
 	/// </summary>
-	void SaveStateSnapShot();
+	void InitializeState();
 
 	/// <summary>
-	/// Restore a state from it's previous snapShot if exist.
+	/// The runtime struct holding the properties of this state for one controller. Must derive FControllerStateRuntime.
 	/// </summary>
-	void RestoreStateFromSnapShot();
+	virtual const UScriptStruct* GetRuntimeStruct() const { return FControllerStateRuntime::StaticStruct(); }
+
+	/// <summary>
+	/// Allocate the runtime properties of a controller using this state.
+	/// </summary>
+	/// <param name="snapShotDepth">The number of past frames of runtime properties to keep</param>
+	void InitializeRuntime(FBehaviourSnapShotRing& runtime, int snapShotDepth) const;
+
+	/// <summary>
+	/// Check if the state is Valid. Skip the blueprint VM when the event is not overriden in blueprint.
+	/// </summary>
+	bool CheckState_Internal(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+		, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus = -1);
+
+	/// <summary>
+	/// Process state and return velocity. Skip the blueprint VM when the event is not overriden in blueprint.
+	/// </summary>
+	FVelocity ProcessState_Internal(const FBehaviourRuntimeRef& runtime, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+
+
+	/// <summary>
+	/// Save a snap shot of the state's runtime properties, before a simulation.
+	/// </summary>
+	static void SaveStateSnapShot(FBehaviourSnapShotRing& runtime);
+
+	/// <summary>
+	/// Restore the state's runtime properties from their snapShot, if a simulation saved one.
+	/// </summary>
+	static void RestoreStateFromSnapShot(FBehaviourSnapShotRing& runtime);
+
+	/// <summary>
+	/// Tell if the state should be checked at this time of the controller. The active state is always checked. Doesn't change the runtime properties.
+	/// </summary>
+	bool IsCheckDue(const FControllerStateRuntime& runtime, const double time, bool isActiveState) const;
+
+	/// <summary>
+	/// Start the check interval from this time of the controller. Called when the state is checked.
+	/// </summary>
+	void ConsumeCheckInterval(FControllerStateRuntime& runtime, const double time) const;
 
 
 
@@ -179,13 +261,13 @@ public:
 	/// </summary>
 
 	UFUNCTION(BlueprintCallable, Category = "State|Base Events|C++ Implementation")
-	virtual void OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	virtual void OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 	/// <summary>
 	/// When we exit the state.
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "State|Base Events|C++ Implementation")
-	virtual void OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	virtual void OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 
@@ -193,7 +275,7 @@ public:
 	/// Check if the state is Valid
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "State|Base Events|C++ Implementation")
-	virtual bool CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	virtual bool CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 		, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus = -1);
 
 
@@ -201,7 +283,7 @@ public:
 	/// Process state and return velocity.
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "State|Base Events|C++ Implementation")
-	virtual FVelocity ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
+	virtual FVelocity ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta);
 
 
 
@@ -210,23 +292,18 @@ public:
 	/// When the controller change a behaviour, it call this function to notify nay of it's bahaviour the change
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "State|Base Events|C++ Implementation")
-	virtual	void OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller);
+	virtual	void OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller);
 
 
 	///Check if this is running as a part of a simulation
 	UFUNCTION(BlueprintCallable, Category = "State|Others")
-	FORCEINLINE bool IsSimulated() { return _snapShotSaved; }
+	bool IsSimulated(const FBehaviourRuntimeRef& runtime) const;
 
 protected:
 
-	bool _wasTheLastFrameBehaviour;
-
-	bool _wasTheLastFrameBehaviour_saved;
-
-	bool _snapShotSaved;
-
-
-	virtual void SaveStateSnapShot_Internal();
+	// Is CheckState overriden in blueprint? true until the state is initialized.
+	bool _checkStateInScript = true;
 
-	virtual void RestoreStateFromSnapShot_Internal();
+	// Is ProcessState overriden in blueprint? true until the state is initialized.
+	bool _processStateInScript = true;
 };
@@ -0,0 +1,133 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InputAction.h"
+#include "Structs.h"
+#include "ControllerInputBridgeComponent.generated.h"
+
+
+class UInputComponent;
+class UEnhancedInputComponent;
+class UModularControllerComponent;
+class APawn;
+class AController;
+struct FInputActionInstance;
+
+
+
+/// <summary>
+/// Feed a controller input from an Enhanced Input action. The input nature follows the action value type: buttons for booleans, values for 1D axes, axes otherwise.
+/// </summary>
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FControllerInputBinding
+{
+	GENERATED_BODY()
+
+public:
+
+	// The action listened.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Input")
+	UInputAction* Action = nullptr;
+
+	// The key of the controller input fed by the action.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Input")
+	FName InputKey;
+
+	// The buffer time of a button input. 0 for a simple button.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Input", meta = (ClampMin = 0))
+	float ButtonBufferTime = 0;
+
+	// The handle of the controller input, once bound.
+	int32 _handle = INDEX_NONE;
+
+	// The input entry listened, once bound.
+	FInputEntry _entry;
+};
+
+
+
+/// <summary>
+/// Bridge Enhanced Input actions to the modular controller of the owner pawn, without going through blueprints.
+/// The actions are mapped to the controller inputs handles once, when the owner's input component is available.
+/// Buttons are listened on their trigger events, axes and values can be read and submitted all at once every frame.
+/// </summary>
+UCLASS(ClassGroup = "Controllers", meta = (DisplayName = "Controller Input Bridge", BlueprintSpawnableComponent))
+class MODULARCONTROLLER_API UControllerInputBridgeComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UControllerInputBridgeComponent();
+
+	// The actions feeding the controller inputs. Changes are applied on the next binding.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Controllers|Inputs")
+	TArray<FControllerInputBinding> InputBindings;
+
+	// Should the axes and values be read and submitted to the controller in a single pass every frame, rather than on each of their trigger events?
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Controllers|Inputs")
+	bool bBulkAxisSubmission = true;
+
+
+	// Bind the actions to an Enhanced Input component. Done automatically with the owner's input component. return false if the component is not an Enhanced Input one.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Inputs")
+	bool BindInputs(UInputComponent* inputComponent);
+
+	// Remove the actions bindings from the input component.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Inputs")
+	void UnbindInputs();
+
+	// Are the actions bound to an input component?
+	UFUNCTION(BlueprintPure, Category = "Controllers|Inputs")
+	FORCEINLINE bool AreInputsBound() const { return _inputComponent.IsValid(); }
+
+protected:
+
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Listen a button, on each frame it's triggered.
+	void OnButtonTriggered(const FInputActionInstance& instance, int32 bindingIndex);
+
+	// Listen an axis or a value, on each frame it's triggered.
+	void OnAxisTriggered(const FInputActionInstance& instance, int32 bindingIndex);
+
+	// Read the values of the axes actions and submit them to the controller at once.
+	void SubmitAxes();
+
+	// Called when the owner pawn's controller changed, to bind the new input component and tick after the new controller.
+	UFUNCTION()
+	void OnOwnerControllerChanged(APawn* pawn, AController* oldController, AController* newController);
+
+	// Tick after a player controller, so the inputs it processed are read on the same frame. nullptr to stop waiting for the current one.
+	void SetTickPrerequisiteController(AController* controller);
+
+private:
+
+	// The controller of the owner.
+	UPROPERTY()
+	UModularControllerComponent* _controller;
+
+	// The input component the actions are bound to.
+	TWeakObjectPtr<UEnhancedInputComponent> _inputComponent;
+
+	// The controller this component ticks after.
+	TWeakObjectPtr<AController> _tickPrerequisiteController;
+
+	// The handles of the actions events bindings, to remove them.
+	TArray<uint32> _eventBindings;
+
+	// The indexes of the bindings read in bulk.
+	TArray<int32> _bulkBindings;
+
+	// The handles submitted in bulk this frame. The storage is reused frame to frame.
+	TArray<int32> _bulkHandles;
+
+	// The entries submitted in bulk this frame. The storage is reused frame to frame.
+	TArray<FInputEntry> _bulkEntries;
+};
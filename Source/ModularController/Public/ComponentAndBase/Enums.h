@@ -97,6 +97,13 @@ enum EControllerDebugType
 	ControllerDebugType_InputDebug,
 };
 
+/*
+* Are the controllers debug traces and logs compiled? Never in shipping and test builds. Can be forced from the build rules.
+*/
+#ifndef MODULAR_CONTROLLER_DEBUG
+#define MODULAR_CONTROLLER_DEBUG !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+#endif
+
 
 /// <summary>
 /// The type of compatibility mode an controller action.
@@ -121,4 +128,43 @@ enum EActionPhase
 	ActionPhase_Anticipation,
 	ActionPhase_Active,
 	ActionPhase_Recovery,
-};
\ No newline at end of file
+};
+
+/// <summary>
+/// The update group of a controller, based on it's net mode and role.
+/// </summary>
+UENUM(BlueprintType)
+enum EControllerUpdateGroup
+{
+	ControllerUpdateGroup_StandAlone,
+	ControllerUpdateGroup_ListenServer,
+	ControllerUpdateGroup_DedicatedServer,
+	ControllerUpdateGroup_AutonomousProxy,
+	ControllerUpdateGroup_SimulatedProxy,
+	ControllerUpdateGroup_MAX UMETA(Hidden),
+};
+
+
+/// <summary>
+/// The rate at which a controller is updated, from it's significance.
+/// </summary>
+UENUM(BlueprintType)
+enum EControllerUpdateTier
+{
+	ControllerUpdateTier_EveryFrame,
+	ControllerUpdateTier_EverySecondFrame,
+	ControllerUpdateTier_EveryFourthFrame,
+	ControllerUpdateTier_EveryEighthFrame,
+	ControllerUpdateTier_InterpolateOnly,
+};
+
+
+/// <summary>
+/// How the controller states are checked, from the highest priority to the lowest.
+/// </summary>
+UENUM(BlueprintType)
+enum EStateEvaluationMode
+{
+	StateEvaluationMode_AllStates,
+	StateEvaluationMode_FirstSuccess,
+};
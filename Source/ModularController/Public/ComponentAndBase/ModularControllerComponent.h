@@ -9,6 +9,8 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "GameFramework/GameStateBase.h"
 #include "GameFramework/NavMovementComponent.h"
+#include "WorldCollision.h"
+#include "StateTransitionGraph.h"
 
 #ifndef BASE_ACTION
 #define BASE_ACTION
@@ -57,12 +59,35 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+	// Called when the component moved changes. The component traces are rebuilt for the new one.
+	virtual void SetUpdatedComponent(USceneComponent* NewUpdatedComponent) override;
+
+protected:
+
 	// Called to initialize the component
 	void Initialize();
 
 	// Called to Update the component logics
 	void MainUpdateComponent(float delta);
 
+	// Evaluate the update group of the controller, based on it's net mode and role.
+	EControllerUpdateGroup EvaluateUpdateGroup();
+
+	// Called when the owner pawn's controller changed, to refresh the update group.
+	UFUNCTION()
+	void OnOwnerControllerChanged(APawn* pawn, AController* oldController, AController* newController);
+
+	//Should the controller be updated by the world's controller subsystem, along with all the other controllers, rather than by it's own tick.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Core")
+	bool bUseSubsystemUpdate = true;
+
+	//The update group of the controller, cached from it's net mode and role.
+	TEnumAsByte<EControllerUpdateGroup> _updateGroup;
+
 	//Use this to offset rotation. useful when using skeletal mesh without as root primitive.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core")
 	FRotator RotationOffset;
@@ -80,6 +105,15 @@ public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// Report the objects referenced by the behaviours runtime properties, kept out of the reflected properties.
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	// Update the controller for a frame. Called by the component's tick, or by the controller subsystem when batched.
+	void UpdateComponent(float delta);
+
+	// Get the update group of the controller.
+	FORCEINLINE EControllerUpdateGroup GetUpdateGroup() const { return _updateGroup; }
+
 
 
 	// Get the controller's actor custom Transform
@@ -121,6 +155,248 @@ public:
 
 
 
+#pragma region Update Phases
+
+protected:
+
+	//The data passed between the update phases of the current frame.
+	FControllerPhasedUpdate _phasedUpdate;
+
+	//When true, the physic interactions made while evaluating the move are kept for the commit phase instead of being applied.
+	bool _deferPhysicInteractions = false;
+
+public:
+
+	/// <summary>
+	/// Begin the update of the controller: root motions, then the sensing and decision phase for locally simulated controllers.
+	/// Remote and physic simulated controllers are fully updated here.
+	/// </summary>
+	/// <returns>True if the integration and commit phases must follow.</returns>
+	bool BeginPhasedUpdate(float delta);
+
+	/// <summary>
+	/// Sensing and decision phase: consume inputs, evaluate and process the controller status. Game thread only, since it runs the behaviours events.
+	/// </summary>
+	/// <returns>True if the integration and commit phases must follow.</returns>
+	bool SenseAndDecidePhase(float delta);
+
+	/// <summary>
+	/// Integration phase: rotation and collision resolved move. Only reads the scene and writes the controller's own frame data, so it can run on a worker thread.
+	/// </summary>
+	void IntegrationPhase();
+
+	/// <summary>
+	/// Commit phase: move the component, apply the physic interactions and send the network commands. Game thread only.
+	/// </summary>
+	void CommitPhase();
+
+	/// <summary>
+	/// End the update of a controller that went through all the phases. On fixed time step, begins the next step of the frame if any.
+	/// </summary>
+	/// <returns>True if another step began, and the integration and commit phases must follow again.</returns>
+	bool EndPhasedUpdate();
+
+	// Can the integration phase of this controller run outside of the game thread? Debugging controllers draw, so they don't.
+	FORCEINLINE bool CanIntegrateInParallel() const { return !IsDebugEnabled(); }
+
+	/// <summary>
+	/// Notify the behaviours and listeners of the transitions queued, in order. Called once per frame, after every controller committed.
+	/// </summary>
+	void FlushTransitionEvents();
+
+
+#pragma region Fixed Time Step
+
+public:
+
+	//Should the locally simulated controller move by fixed time steps? The visual component is interpolated between the last two steps.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|Fixed Time Step")
+	bool bUseFixedTimeStep = false;
+
+	//The component moved to show the interpolated and extrapolated poses. It can be attached anywhere under the updated primitive. When not set, the main skeletal mesh is.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Core|Fixed Time Step", meta = (UseComponentPicker, AllowedClasses = "SceneComponent"))
+	FComponentReference VisualComponent;
+
+	//The number of fixed time steps per second.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|Fixed Time Step", meta = (ClampMin = 1, UIMin = 1))
+	float FixedTimeStepRate = 60;
+
+	//The maximum number of fixed time steps simulated in a frame. The time exceeding it is dropped.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|Fixed Time Step", meta = (ClampMin = 1, UIMin = 1))
+	int MaxFixedStepsPerFrame = 4;
+
+	// Get the delta time of a fixed time step.
+	FORCEINLINE float GetFixedStepDelta() const { return 1.0f / FMath::Max(FixedTimeStepRate, 1.0f); }
+
+	// Get the number of steps simulated since the beginning.
+	FORCEINLINE int64 GetSimulationFrame() const { return _simulationFrame; }
+
+protected:
+
+	//The time not yet simulated by fixed steps.
+	float _fixedStepAccumulator = 0;
+
+	//The number of simulation steps left in the current frame.
+	int _stepsRemaining = 0;
+
+	//The move made on the step before the last one, to interpolate from.
+	FKinematicInfos _previousMoveMade;
+
+	//The number of steps simulated since the beginning.
+	int64 _simulationFrame = 0;
+
+	// Add a frame delta time to the accumulator, and get the number of fixed steps to simulate.
+	int ConsumeFixedSteps(float delta);
+
+	// Scale the root motions extracted this frame, to spread them over several steps.
+	void ScaleRootMotions(float scale);
+
+	//The visual offset from the updated primitive, if any.
+	TWeakObjectPtr<USceneComponent> _offsetVisual;
+
+	//The relative transform of the visual, before it was offset.
+	FTransform _visualRelativeTransform;
+
+	//The transform of the visual relative to the updated primitive, before it was offset.
+	FTransform _visualPrimitiveTransform;
+
+	//Is the controller moving it's updated primitive itself? Those moves don't wake it up.
+	bool _isMovingSelf = false;
+
+	// Place the visual between the last two steps, according to the time left in the accumulator.
+	void InterpolateFixedSteps();
+
+	// Get the visual component, or the main skeletal mesh. nullptr if it's not attached under the updated primitive.
+	USceneComponent* GetVisualComponent();
+
+	// Place the visual where it would be with the updated primitive at a pose. Only the visual moves, the updated primitive and it's collision stay on the simulated pose.
+	void SetVisualOffset(const FVector& location, const FQuat& rotation);
+
+	// Put the visual back in place on the updated primitive.
+	void ClearVisualOffset();
+
+#pragma endregion
+
+
+#pragma region Update LOD
+
+public:
+
+	//Should the controller update rate be lowered with it's distance to the viewers? Only applies when updated by the controller subsystem.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|LOD")
+	bool bUseUpdateLOD = true;
+
+	//The viewer distances from which the controller updates every 2nd, 4th, 8th frames, then only interpolates.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|LOD")
+	TArray<float> UpdateTierDistances = { 2500, 5000, 10000, 20000 };
+
+	//The longest time the frames skipped can accumulate. Beyond it, the time is dropped instead of being simulated or extrapolated at once.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|LOD")
+	float MaxSkippedFramesTime = 0.25f;
+
+	// Get the update tier matching a distance to the closest viewer.
+	EControllerUpdateTier GetUpdateTierForDistance(const float viewerDistance) const;
+
+	// Set the update tier of the controller. Controllers moved by a local player and remote players on the server always update every frame.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Core|LOD")
+	void SetUpdateTier(EControllerUpdateTier tier);
+
+	// Get the current update tier of the controller.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Core|LOD")
+	FORCEINLINE EControllerUpdateTier GetUpdateTier() const { return _updateTier; }
+
+	// Should the controller be simulated on this frame, according to it's update tier?
+	bool IsUpdateFrame(const uint32 frameCounter) const;
+
+	// Get the delta time to simulate with on an update frame, including the time accumulated by the skipped frames.
+	float ConsumeUpdateDelta(float delta);
+
+	// Called instead of the update on frames skipped by the update tier. accumulate the delta time and keep the visual moving, without moving the collision.
+	void SkipUpdateFrame(float delta);
+
+protected:
+
+	//The current update tier.
+	TEnumAsByte<EControllerUpdateTier> _updateTier = ControllerUpdateTier_EveryFrame;
+
+	//The time accumulated by the frames skipped.
+	float _lodAccumulatedDelta = 0;
+
+	//Offset the update frames of the controller, so controllers on the same tier don't all update on the same frame.
+	uint32 _lodFrameOffset = 0;
+
+#pragma endregion
+
+
+#pragma region Sleep
+
+public:
+
+	//Can the controller fall asleep when idle? A sleeping controller skips it's update until woken up by an input, a collision, a gravity change or it's surface moving.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|Sleep")
+	bool bCanSleep = true;
+
+	//The time the controller must stay idle before falling asleep.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Core|Sleep", meta = (ClampMin = 0, UIMin = 0))
+	float SleepDelay = 0.5;
+
+	// Wake up the controller if sleeping.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Core|Sleep")
+	void WakeUp();
+
+	// Is the controller sleeping?
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Core|Sleep")
+	FORCEINLINE bool IsSleeping() const { return _isSleeping; }
+
+	// Wake up the sleeping controller if it's surface is gone or stopped simulating. Called on each frame the controller sleeps.
+	void ValidateSleepSurface();
+
+protected:
+
+	//Is the controller currently sleeping?
+	bool _isSleeping = false;
+
+	//The time the controller have been idle.
+	float _idleTime = 0;
+
+	//The world time when the controller fell asleep, to catch up the elapsed time on wake up.
+	double _sleepStartTime = 0;
+
+	//The surface primitive watched while sleeping.
+	TWeakObjectPtr<UPrimitiveComponent> _sleepSurface;
+
+	//Was the surface simulating physics when the controller fell asleep?
+	bool _sleepSurfaceSimulating = false;
+
+	//Was the component tick disabled by the sleep? When not updated by the controller subsystem.
+	bool _tickDisabledBySleep = false;
+
+	// Is the controller idle this frame? no input, no velocity, no moving surface and no action.
+	bool IsIdle() const;
+
+	// Accumulate the idle time and fall asleep after the sleep delay.
+	void EvaluateSleep(float delta);
+
+	// Put the controller to sleep, and start watching it's surface and updated primitive.
+	void FallAsleep();
+
+	// Called when a watched component moved while sleeping.
+	void OnSleepWatchedComponentMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	// Called when the physic state of the surface watched while sleeping changed, e.g. when destroyed.
+	UFUNCTION()
+	void OnSleepSurfacePhysicsStateChanged(UPrimitiveComponent* ChangedComponent, EComponentPhysicsStateChange StateChange);
+
+	// Called when the actor of the surface watched while sleeping is destroyed.
+	UFUNCTION()
+	void OnSleepSurfaceActorDestroyed(AActor* DestroyedActor);
+
+#pragma endregion
+
+#pragma endregion
+
+
+
 #pragma region Input Handling
 
 private:
@@ -129,8 +405,11 @@ private:
 	UPROPERTY()
 	UInputEntryPool* _user_inputPool;
 
-	//The history of direction the user is willing to move.
-	TArray<FVector_NetQuantize10> _userMoveDirectionHistory;
+	//The history of direction the user is willing to move. Only a few frames are pending at once, kept inline.
+	TArray<FVector_NetQuantize10, TInlineAllocator<8>> _userMoveDirectionHistory;
+
+	//The inputs listened on the last simulation frames.
+	FInputFrameRing _inputHistory;
 
 public:
 
@@ -141,6 +420,25 @@ public:
 	// Lister to user input and Add input to the inputs pool
 	void ListenInput(const FName key, const FInputEntry entry);
 
+	// Lister to user input and Add input to the inputs pool, by input handle. See UInputEntryPool::RegisterInput.
+	void ListenInput(const int32 handle, const FInputEntry entry);
+
+	// Lister to user inputs and Add them all to the inputs pool at once, by input handles. The entries are paired with the handles by index.
+	void ListenInputs(TArrayView<const int32> handles, TArrayView<const FInputEntry> entries);
+
+	// Get the user input pool.
+	FORCEINLINE UInputEntryPool* GetInputPool() const { return _user_inputPool; }
+
+	// The number of past simulation frames of user inputs recorded, to replay or resimulate them. 0 disables the history.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Inputs", meta = (ClampMin = 0))
+	int InputHistoryDepth = 0;
+
+	// Get the inputs listened on the last simulation frames.
+	FORCEINLINE const FInputFrameRing& GetInputHistory() const { return _inputHistory; }
+
+	// Update the user input pool at the end of the frame.
+	void UpdateUserInputs(float delta);
+
 	// Lister to user input button and Add input to the inputs pool
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Inputs")
 	void ListenButtonInput(const FName key, const float buttonBufferTime = 0);
@@ -153,6 +451,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Inputs")
 	void ListenAxisInput(const FName key, const FVector axis);
 
+	// Lister to several user input axes and Add them to the inputs pool at once. The axes are paired with the keys by index.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Inputs")
+	void ListenAxisInputs(const TArray<FName>& keys, const TArray<FVector>& axes);
+
 
 	// Consume the movement input. Movement input history will be consumed if it has 2 or more items.
 	FVector ConsumeMovementInput();
@@ -200,6 +502,36 @@ private:
 	TArray<FClientNetMoveCommand> _clientcmdHistory;
 	TArray<FClientNetMoveCommand> _servercmdCheckPool;
 
+	//The inputs of the last command received from the remote user.
+	UPROPERTY()
+	UInputEntryPool* _remoteInputsReceived;
+
+	//The inputs of the command received before the last one, to extrapolate the remote inputs from.
+	UPROPERTY()
+	UInputEntryPool* _remoteInputsBefore;
+
+	//The remote user inputs, extrapolated ahead of the last command received. Used to evaluate the remote controllers status.
+	UPROPERTY()
+	UInputEntryPool* _remote_inputPool;
+
+	//The move input of the command received before the last one.
+	FVector _remoteMoveInputBefore = FVector(0);
+
+	//The time between the last two commands received, on the remote user side.
+	float _remoteCommandInterval = 0;
+
+	//The local time the last command was received.
+	double _lastCmdReceivedTime = 0;
+
+	//Are the remote inputs received since the last update? The pressed buttons are only seen by the update right after they are received.
+	bool _remoteInputsFresh = false;
+
+	//The inputs to send with the next command: the user's captured, or the remote user's received to relay them. The storage is reused.
+	FNetInputSnapshot _inputsToSend;
+
+	//The inputs sent with the last command that carried them.
+	FNetInputSnapshot _inputsSent;
+
 
 public:
 
@@ -215,6 +547,16 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Network")
 	int MaxSimulationCount = 500;
 
+	// Should the dedicated server and simulated proxies apply the received status directly, without checking the states and actions?
+	// Only the state of the received status is checked then, to keep it's surface infos up to date.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Network")
+	bool bStatusDrivenRemotes = true;
+
+	// How far ahead of the last command received the simulated proxies extrapolate the remote inputs and location, in seconds. 0 disables the extrapolation.
+	// The extrapolated inputs only drive the states and actions checks with bStatusDrivenRemotes off, the received status is applied as is otherwise.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Network", meta = (ClampMin = 0))
+	float MaxRemoteExtrapolationTime = 0;
+
 
 	// Used to replicate some properties.
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
@@ -254,6 +596,37 @@ protected:
 	FStatusParameters EvaluateControllerStatus(FKinematicInfos kinematicInfos, FVector moveInput, UInputEntryPool* usedInputPool, float delta, FStatusParameters statusOverride = FStatusParameters(), bool simulate = false, int simulatedInitialStateIndex = -1, int simulatedInitialActionIndexes = -1);
 
 
+	/**
+	 * @brief Apply a status to the controller without checking the states and actions. Only the transitions to the status state and action are made.
+	 * @param kinematicInfos informations about the movement, location and rotation
+	 * @param delta the delta time
+	 * @param status the status to apply. A negative state index keeps the current state.
+	 */
+	void ApplyControllerStatus(FKinematicInfos kinematicInfos, FVector moveInput, float delta, FStatusParameters status);
+
+
+	// Apply the received status when the remotes are status driven, re-sensing the surface of it's state only. Evaluate it otherwise with the remote inputs.
+	void EvaluateRemoteStatus(FKinematicInfos kinematicInfos, FVector moveInput, float delta, FStatusParameters status);
+
+	// Store the inputs of a command received from the remote user, keeping the previous ones to extrapolate from. Must be called before the command is set as the last received.
+	void ReceiveRemoteInputs(const FClientNetMoveCommand& command);
+
+	// Get the time to run ahead of the last command received: the time since it was received plus half the local round trip, clamped by MaxRemoteExtrapolationTime.
+	float GetRemoteExtrapolationTime();
+
+	// Do the remote machines use the inputs sent with the commands? Only to extrapolate them, or to check the states and actions when the remotes are not status driven.
+	FORCEINLINE bool ShouldSendInputs() const { return MaxRemoteExtrapolationTime > 0 || !bStatusDrivenRemotes; }
+
+	// Extrapolate the remote inputs pool over a time ahead of the last command received. return the extrapolated move input.
+	FVector ExtrapolateRemoteInputs(float aheadTime);
+
+	// Set the inputs to send in a command if they changed since the last ones sent, leaving them unset otherwise.
+	void PackInputsToSend(FClientNetMoveCommand& command);
+
+	// Get the remote user inputs pool if any inputs were received, the user's one otherwise.
+	FORCEINLINE UInputEntryPool* GetRemoteInputPool() const { return _remote_inputPool ? _remote_inputPool : _user_inputPool; }
+
+
 	/**
 	 * @brief Process velocity based on input status infos
 	 * @param inStatus the input status parameter to process
@@ -292,6 +665,9 @@ protected:
 	// Called to Update the component logic in Listened Server Mode
 	void ListenServerUpdateComponent(float delta);
 
+	// Called on the commit phase to multicast the move made in Listened Server Mode
+	void ListenServerSendCommand(float delta);
+
 
 #pragma endregion
 
@@ -334,6 +710,12 @@ protected:
 	// Called to Update the component logic in Autonomous Proxy Mode
 	void AutonomousProxyUpdateComponent(float delta);
 
+	// Called on the decision phase to handle the starting location and the server corrections in Autonomous Proxy Mode. return false if the controller can't move yet.
+	bool AutonomousProxyPrepareUpdate(bool& corrected);
+
+	// Called on the commit phase to send the move made to the server in Autonomous Proxy Mode
+	void AutonomousProxySendCommand(float delta);
+
 #pragma endregion
 
 
@@ -341,8 +723,8 @@ protected:
 
 protected:
 
-	// Called to Update the component logic in Simulated Proxy Mode
-	void SimulatedProxyUpdateComponent(float delta);
+	// Called to Update the component logic in Simulated Proxy Mode. the status is only evaluated on update frames of the controller's update tier.
+	void SimulatedProxyUpdateComponent(float delta, bool evaluateStatus = true);
 
 #pragma endregion
 
@@ -412,6 +794,8 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Physic")
 	FORCEINLINE void SetGravity(FVector gravity, UBaseControllerState* gravityStateOverride = nullptr)
 	{
+		if (_isSleeping && !_gravityVector.Equals(gravity))
+			WakeUp();
 		_gravityVector = gravity;
 		if (gravityStateOverride)
 			_currentActiveGravityState = gravityStateOverride;
@@ -488,6 +872,75 @@ public:
 	void SetOverrideRootMotionMode(USkeletalMeshComponent* caller, const ERootMotionType translationMode, const ERootMotionType rotationMode);
 
 
+	// The number of past simulation frames of the states and actions runtime properties kept, to roll them back. 0 disables the history.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Behaviours", meta = (ClampMin = 0))
+	int SnapShotHistoryDepth = 0;
+
+	// Share the states and actions definitions with every controller of the world. The definitions are never written at runtime, each controller keeps the runtime properties of it's behaviours.
+	// Behaviours with blueprint variables are never shared.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Behaviours")
+	bool bShareBehaviourDefinitions = false;
+
+	/// <summary>
+	/// Get the runtime properties of one of this controller's states or actions.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Behaviours")
+	FBehaviourRuntimeRef GetBehaviourRuntime(const UObject* behaviour) const;
+
+	/// <summary>
+	/// Restore the runtime properties of every state and action as they were at the end of a simulation frame.
+	/// </summary>
+	/// <param name="frame">The simulation frame to restore</param>
+	/// <returns>false if the frame is not in the history anymore, nothing is restored then.</returns>
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Behaviours")
+	bool RestoreBehavioursFrame(int64 frame);
+
+protected:
+
+	// Record the runtime properties of every state and action for a simulation frame.
+	void RecordBehavioursFrame(int64 frame);
+
+	// The runtime properties of the states and actions, per behaviour.
+	TMap<const UObject*, TUniquePtr<FBehaviourSnapShotRing>> _behaviourRuntimes;
+
+	// The runtime properties of the states, by state index.
+	TArray<FBehaviourSnapShotRing*> _stateRuntimes;
+
+	// The runtime properties of the actions, by action index.
+	TArray<FBehaviourSnapShotRing*> _actionRuntimes;
+
+	// Create the state instance used by this controller, or get the shared one, and allocate it's runtime properties.
+	UBaseControllerState* CreateStateInstance(TSubclassOf<UBaseControllerState> stateClass);
+
+	// Create the action instance used by this controller, or get the shared one, and allocate it's runtime properties.
+	UBaseControllerAction* CreateActionInstance(TSubclassOf<UBaseControllerAction> actionClass);
+
+	// Index the runtime properties of the states and actions. Called every time the instances change.
+	void CacheBehaviourRuntimes();
+
+	// Get the runtime properties of a behaviour. nullptr if it's not one of this controller's.
+	FBehaviourSnapShotRing* FindBehaviourRing(const UObject* behaviour) const;
+
+	// Release the runtime properties of a state or action.
+	void ReleaseBehaviourRuntime(const UObject* behaviour);
+
+
+public:
+
+	// When several transitions happen before the events are notified, only notify the change from the first origin to the last behaviour, per kind.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Behaviours")
+	bool bCoalesceTransitionEvents = false;
+
+protected:
+
+	// The state and action transitions of the frame, notified once the frame is committed.
+	UPROPERTY(Transient)
+	TArray<FBehaviourTransitionEvent> _pendingTransitions;
+
+	// Queue a transition to be notified on the next flush.
+	void QueueTransitionEvent(bool isAction, UObject* newBehaviour, UObject* oldBehaviour);
+
+
 #pragma endregion
 
 
@@ -508,6 +961,20 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, category = "Controllers|Controller State")
 	int CurrentStateIndex = -1;
 
+	// How the states are checked. AllStates checks every state of the highest passing priority, the last one wins. FirstSuccess stops at the first passing state.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Controller State")
+	TEnumAsByte<EStateEvaluationMode> StateEvaluationMode = StateEvaluationMode_AllStates;
+
+	// The transitions allowed between the states. When set, only the states reachable from the current one are checked.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, category = "Controllers|Controller State")
+	UStateTransitionGraph* StateTransitionGraph = nullptr;
+
+	/// <summary>
+	/// Change the transitions allowed between the states. null checks every state.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Controller State")
+	void SetStateTransitionGraph(UStateTransitionGraph* graph);
+
 	// The state Behaviour changed event
 	UPROPERTY(BlueprintAssignable, Category = "Controllers|Controller State|Events")
 	FControllerStateChangedSignature OnControllerStateChangedEvent;
@@ -720,9 +1187,58 @@ protected:
 	 * @param actionInstance The action to verify
 	 * @param stateIndex the controller state index used
 	 * @param actionIndex the action array used
+	 * @param candidateIndex the index of the action to verify, used to read it's precomputed compatibility masks
 	 * @return true if it's compatible
 	 */
-	bool CheckActionCompatibility(UBaseControllerAction* actionInstance, int stateIndex, int actionIndex);
+	bool CheckActionCompatibility(UBaseControllerAction* actionInstance, int stateIndex, int actionIndex, int candidateIndex = INDEX_NONE);
+
+	// Resolve the compatible states and actions names of every action, the actions trigger inputs and the state transition graph. Must be called every time the states or actions arrays change.
+	void BuildCompatibilityMasks();
+
+	// For each trigger input handle, the indexes of the actions it can trigger, by priority.
+	TMap<int32, TArray<int>> _actionTriggerIndex;
+
+	// The actions checked whatever the inputs, the ones without trigger inputs.
+	TBitArray<> _ungatedActions;
+
+	// The actions to check this frame, from the live trigger inputs.
+	TBitArray<> _actionsToCheck;
+
+	// Gather the actions to check from the inputs live in the pool.
+	void GatherActionsToCheck(const UInputEntryPool* inputs);
+
+	// For each state, the bitmask of the states reachable from it. Empty without a transition graph.
+	TArray<uint64> _stateTransitionMasks;
+
+	// Are the state transition masks usable? false when there is more than 64 states, the graph is asked by names instead.
+	bool _stateTransitionMasksValid = false;
+
+	// Can the state be checked while the controller is on another? always true without a transition graph.
+	bool IsStateReachable(int fromStateIndex, int toStateIndex) const;
+
+	// The time of the controller the time sliced states checks are scheduled on. Only advanced by the checks not simulated.
+	double _stateChecksClock = 0;
+
+	// For each action, the bitmask of the compatible states indexes.
+	TArray<uint64> _actionStatesMasks;
+
+	// For each action, the bitmask of the compatible actions indexes.
+	TArray<uint64> _actionActionsMasks;
+
+	// Are the compatibility masks usable? false when there is more than 64 states or actions, names are compared instead.
+	bool _compatibilityMasksValid = false;
+
+	// The cooldowns and phases boundaries of the actions.
+	FActionTimerSchedule _actionTimers;
+
+	// Rebuild the actions timers from the actions runtime values. Must be called every time the actions array or their runtime values change.
+	void ResetActionTimers();
+
+	// Replace the timers of an action from it's runtime values.
+	void ScheduleActionTimers(int actionIndex);
+
+	// Notify the actions of the phases boundaries reached by the timers clock.
+	void DispatchActionTimers();
 
 	/// Change actions from action index 1 to 2
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Controller Action|Events")
@@ -873,6 +1389,26 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Debug")
 	TEnumAsByte<EControllerDebugType> DebugType;
 
+	// Is this type of debug shown? Always false when the debug is compiled out, so the debug code gets stripped.
+	FORCEINLINE bool IsDebugging(const EControllerDebugType type) const
+	{
+#if MODULAR_CONTROLLER_DEBUG
+		return DebugType == type;
+#else
+		return false;
+#endif
+	}
+
+	// Is any type of debug shown?
+	FORCEINLINE bool IsDebugEnabled() const
+	{
+#if MODULAR_CONTROLLER_DEBUG
+		return DebugType != ControllerDebugType_None;
+#else
+		return false;
+#endif
+	}
+
 
 	/// Check for collision at a position and rotation in a direction. return true if collision occurs
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
@@ -886,6 +1422,50 @@ public:
 
 
 
+	/// <summary>
+	/// Sweep the component for a batch of requests sharing the same shape, rotation and query parameters, built once for the whole batch.
+	/// </summary>
+	/// <param name="outHits">The hits, in the order of the requests. Only valid if blocking.</param>
+	/// <param name="stopOnHit">Should the batch stop on the first blocking hit? The hits of the requests left are not added.</param>
+	/// <returns>The number of blocking hits.</returns>
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
+	int ComponentTraceCastBatch(TArray<FHitResult>& outHits, const TArray<FComponentSweepRequest>& requests, FQuat rotation, double inflation = 0.100, bool traceComplex = false, bool stopOnHit = false);
+
+	/// <summary>
+	/// Sweep the component for a batch of requests, without allocating. The traces of this frame are reused from the trace cache.
+	/// </summary>
+	/// <param name="outHits">The hits, in the slot of their request. Must be at least as long as the requests.</param>
+	/// <param name="stopOnHit">Should the batch stop on the first blocking hit? The slots of the requests left are not written.</param>
+	/// <returns>The number of blocking hits.</returns>
+	int ComponentTraceCastBatch(TArrayView<FHitResult> outHits, TConstArrayView<FComponentSweepRequest> requests, FQuat rotation, double inflation = 0.100, bool traceComplex = false, bool stopOnHit = false);
+
+
+	/// <summary>
+	/// Request an asynchronous component trace. The result is available on the next frame, with QueryAsyncComponentTraceCast.
+	/// </summary>
+	/// <returns>The handle of the request, invalid if it could not be issued.</returns>
+	FTraceHandle AsyncComponentTraceCast(FVector position, FVector direction, FQuat rotation, double inflation = 0.100, bool traceComplex = false);
+
+
+	/// <summary>
+	/// Get the result of an asynchronous component trace.
+	/// </summary>
+	/// <returns>True if the result was available. the hit is only valid if blocking.</returns>
+	bool QueryAsyncComponentTraceCast(const FTraceHandle& handle, FHitResult& outHit) const;
+
+
+	// Can the behaviours use asynchronous probes? Only during the controller's own sense and decide phase, simulations and remote evaluations probe synchronously.
+	FORCEINLINE bool CanUseAsyncProbes() const { return _asyncProbesAllowed; }
+
+protected:
+
+	//Are the asynchronous probes allowed for the current evaluation?
+	bool _asyncProbesAllowed = false;
+
+public:
+
+
+
 	/// <summary>
 	/// Trace component along a path
 	/// </summary>
@@ -923,6 +1503,80 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
 	FVector PointOnShape(FVector direction, const FVector inLocation);
 
+	//Should the identical single component traces of a frame be cached? Repeated probes (simulations, state checks) then reuse the first result.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Controllers|Tools & Utils")
+	bool bUseTraceCache = true;
+
+	/// Get the component trace cache statistics, since the last reset.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
+	void GetTraceCacheStats(int& hits, int& misses) const { hits = _traceCacheHits; misses = _traceCacheMisses; }
+
+	/// Reset the component trace cache statistics.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
+	void ResetTraceCacheStats() { _traceCacheHits = 0; _traceCacheMisses = 0; }
+
+	// Clear the component trace cache. Called on each frame and when the controller moves.
+	FORCEINLINE void InvalidateTraceCache() { _traceCache.Reset(); }
+
+	/// Clear the prebuilt query parameters and shapes of the component traces. They are rebuilt on the next trace.
+	/// Must be called after resizing or scaling the updated primitive, or editing it's move ignored actors directly.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
+	void InvalidateTraceQueryCache();
+
+	/// Make the updated primitive ignore an actor when moving, and the component traces with it.
+	UFUNCTION(BlueprintCallable, Category = "Controllers|Tools & Utils")
+	void SetMoveIgnoreActor(AActor* actor, bool shouldIgnore);
+
+protected:
+
+	// Get the query parameters and shape of the component traces. Returns false if the component can't be traced.
+	bool GetComponentTraceQuery(const FCollisionQueryParams*& outParams, FCollisionShape& outShape, double inflation, bool traceComplex, bool returnPhysicalMaterial = true);
+
+	// Get the prebuilt query parameters ignoring the owner and the primitive's move ignored actors. Rebuilt when the owner changed or once invalidated.
+	const FCollisionQueryParams* GetComponentTraceParams(bool traceComplex, bool returnPhysicalMaterial);
+
+	// Get the prebuilt shape of the updated primitive for an inflation. Rebuilt when the primitive changed or once invalidated. Only shape components are cached.
+	bool GetComponentTraceShape(FCollisionShape& outShape, double inflation);
+
+	//The maximum number of inflations the shape is cached for.
+	static constexpr int TraceShapeCacheCapacity = 4;
+
+	//The query parameters, per trace complex and return physical material flags.
+	TOptional<FCollisionQueryParams> _traceParams[4];
+
+	//The owner the query parameters ignore.
+	TWeakObjectPtr<const AActor> _traceParamsOwner;
+
+	//The shapes of the updated primitive, per inflation.
+	TArray<TPair<double, FCollisionShape>, TInlineAllocator<TraceShapeCacheCapacity>> _traceShapes;
+
+	//The primitive the shapes were built from.
+	TWeakObjectPtr<const UPrimitiveComponent> _traceShapeSource;
+
+	// A single component trace result, kept for the frame.
+	struct FComponentTraceCacheEntry
+	{
+		FVector Position;
+		FVector Direction;
+		FQuat Rotation;
+		double Inflation;
+		bool bTraceComplex;
+		bool bHit;
+		FHitResult Hit;
+	};
+
+	//The maximum number of traces cached in a frame.
+	static constexpr int TraceCacheCapacity = 16;
+
+	//The single component traces made this frame.
+	TArray<FComponentTraceCacheEntry, TInlineAllocator<TraceCacheCapacity>> _traceCache;
+
+	//The number of traces answered by the cache.
+	int _traceCacheHits = 0;
+
+	//The number of traces that went to the scene with the cache on.
+	int _traceCacheMisses = 0;
+
 
 #pragma endregion
 
@@ -0,0 +1,170 @@
+// Copyright © 2023 by Tyni Boat. All Rights Reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Enums.h"
+#include "ModularControllerSubsystem.generated.h"
+
+
+class UModularControllerComponent;
+class UModularControllerSubsystem;
+class UBaseControllerState;
+class UBaseControllerAction;
+
+
+/// <summary>
+/// Hook to evaluate the update tier of a controller from the distance to it's closest viewer, e.g. from a significance manager.
+/// </summary>
+DECLARE_DELEGATE_RetVal_TwoParams(EControllerUpdateTier, FEvaluateControllerUpdateTier, const UModularControllerComponent*, float);
+
+
+
+/// <summary>
+/// The tick function driving all the controllers registered to the subsystem at once.
+/// </summary>
+USTRUCT()
+struct FModularControllerBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	// The subsystem this tick function updates.
+	UModularControllerSubsystem* Subsystem = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	virtual FString DiagnosticMessage() override;
+
+	virtual FName DiagnosticContext(bool bDetailed) override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FModularControllerBatchTickFunction> : public TStructOpsTypeTraitsBase2<FModularControllerBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+
+
+/// <summary>
+/// A group of controllers sharing the same update path.
+/// </summary>
+USTRUCT()
+struct FModularControllerUpdateGroup
+{
+	GENERATED_BODY()
+
+	// The controllers of the group.
+	UPROPERTY()
+	TArray<UModularControllerComponent*> Controllers;
+};
+
+
+
+/// <summary>
+/// World subsystem updating every registered modular controller from a single tick, grouped by net role.
+/// Locally simulated controllers are updated in phases: sense and decide, integrate (in parallel), then commit.
+/// </summary>
+UCLASS()
+class MODULARCONTROLLER_API UModularControllerSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	// Register a controller to be updated by the subsystem.
+	void RegisterController(UModularControllerComponent* controller);
+
+	// Unregister a controller from the subsystem. safe to call during the update.
+	void UnregisterController(UModularControllerComponent* controller);
+
+	// Request a rebuild of the update groups before the next update. Called when a controller's update group changed.
+	FORCEINLINE void MarkUpdateGroupsDirty() { _updateGroupsDirty = true; }
+
+	// Update all the registered controllers.
+	void UpdateControllers(float delta);
+
+	// Get the number of controllers registered to the subsystem.
+	FORCEINLINE int32 GetRegisteredControllerCount() const { return _registeredControllers.Num(); }
+
+	// When bound, replace the distance based update tier of the controllers.
+	FEvaluateControllerUpdateTier EvaluateUpdateTierOverride;
+
+	// Get the state definition shared by the controllers of the world, created on first use. nullptr if the state can't be shared.
+	UBaseControllerState* GetSharedState(TSubclassOf<UBaseControllerState> stateClass);
+
+	// Get the action definition shared by the controllers of the world, created on first use. nullptr if the action can't be shared.
+	UBaseControllerAction* GetSharedAction(TSubclassOf<UBaseControllerAction> actionClass);
+
+	// Can a behaviour definition be shared? Only native properties are, blueprint variables being written at runtime.
+	static bool CanShareDefinition(const UClass* behaviourClass);
+
+	// Get half the round trip of the local player, read once per frame for all the controllers.
+	double GetLocalNetLatency();
+
+	// Make the controllers update wait for a tick function, e.g. one feeding the controllers inputs.
+	void AddUpdatePrerequisite(UObject* targetObject, FTickFunction& targetTickFunction);
+
+	// Stop the controllers update from waiting for a tick function.
+	void RemoveUpdatePrerequisite(UObject* targetObject, FTickFunction& targetTickFunction);
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Rebuild the update groups from the registered controllers.
+	void RebuildUpdateGroups();
+
+	// Evaluate the update tier of every controller from it's distance to the local and connections viewpoints.
+	void EvaluateUpdateTiers();
+
+private:
+
+	// The tick function driving the controllers.
+	FModularControllerBatchTickFunction _batchTickFunction;
+
+	// All the controllers registered.
+	UPROPERTY()
+	TArray<UModularControllerComponent*> _registeredControllers;
+
+	// The registered controllers, grouped by update group.
+	UPROPERTY()
+	TArray<FModularControllerUpdateGroup> _updateGroups;
+
+	// Should the update groups be rebuilt before the next update?
+	bool _updateGroupsDirty = false;
+
+	// The controllers going through the integration and commit phases this frame.
+	TArray<UModularControllerComponent*> _phasedControllers;
+
+	// The controllers of the frame whose integration phase can run on worker threads.
+	TArray<UModularControllerComponent*> _parallelControllers;
+
+	// The number of frames updated, used to dispatch the controllers update tiers.
+	uint32 _frameCounter = 0;
+
+	// Half the round trip of the local player.
+	double _localNetLatency = 0;
+
+	// The engine frame the local latency was read on.
+	uint64 _netLatencyFrame = MAX_uint64;
+
+	// The viewpoints of the players, refreshed with the update tiers.
+	TArray<FVector> _viewLocations;
+
+	// The states definitions shared by the controllers, per class.
+	UPROPERTY()
+	TMap<UClass*, UBaseControllerState*> _sharedStates;
+
+	// The actions definitions shared by the controllers, per class.
+	UPROPERTY()
+	TMap<UClass*, UBaseControllerAction*> _sharedActions;
+};
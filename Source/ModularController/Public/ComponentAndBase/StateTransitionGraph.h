@@ -0,0 +1,61 @@
+// Copyright  2023 by Tyni Boat. All Rights Reserved.
+
+#pragma once
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "StateTransitionGraph.generated.h"
+
+
+
+/// <summary>
+/// An allowed transition from a state to another, by states names.
+/// </summary>
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FStateTransitionEdge
+{
+	GENERATED_BODY()
+
+public:
+
+	// The name of the state transitioned from.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition")
+	FName FromState;
+
+	// The name of the state transitioned to.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transition")
+	FName ToState;
+};
+
+
+
+///<summary>
+/// The transitions allowed between the states of a controller. Only the states reachable from the current one are checked.
+/// A state without any transition from it in the graph can go to every state.
+/// </summary>
+UCLASS(BlueprintType, ClassGroup = "Modular Controller States")
+class MODULARCONTROLLER_API UStateTransitionGraph : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	// The allowed transitions between states.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transitions")
+	TArray<FStateTransitionEdge> Transitions;
+
+	// The states checked whatever the current state is, e.g. a free fall state.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Transitions")
+	TArray<FName> AlwaysCheckedStates;
+
+	/// <summary>
+	/// Is there any transition from this state in the graph?
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Transitions")
+	bool HasTransitionsFrom(FName fromState) const;
+
+	/// <summary>
+	/// Can the controller go from a state to another? A state can always stay itself.
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Transitions")
+	bool IsTransitionAllowed(FName fromState, FName toState) const;
+};
@@ -260,8 +260,28 @@ public:
 };
 
 
+/*
+* An input slot of a pool. The input received this frame, and the input tracked over the last frames.
+*/
+struct FInputEntrySlot
+{
+	//The input received this frame
+	FInputEntry Pending;
+
+	//The input tracked over the last frames
+	FInputEntry Last;
+
+	//Was the input received this frame?
+	bool bPending = false;
+
+	//Is the input tracked?
+	bool bHasLast = false;
+};
+
+
 /*
 * Represent a pack of input entry, tracking inputs. Used locally only. not intended to be used remotely
+* Inputs keys are registered once as handles, shared by every pool, indexing a flat array of slots.
 */
 UCLASS(BlueprintType)
 class MODULARCONTROLLER_API UInputEntryPool: public UObject
@@ -269,66 +289,125 @@ class MODULARCONTROLLER_API UInputEntryPool: public UObject
 	GENERATED_BODY()
 
 public:
-	//FORCEINLINE UInputEntryPool() {}
 
-	//FORCEINLINE UInputEntryPool(const UInputEntryPool& ref)
-	//{
-	//	_inputPool.Empty();
-	//	_inputPool_last.Empty();
+	//The inputs slots, indexed by input handle. Never shrunk, the storage is reused frame to frame.
+	TArray<FInputEntrySlot> _slots;
 
-	//	for (auto entry : ref._inputPool)
-	//		_inputPool.Add(entry.Key, entry.Value);
-	//	for (auto entry : ref._inputPool_last)
-	//		_inputPool_last.Add(entry.Key, entry.Value);
-	//}
 
-	//The input pool
-	TMap<FName, FInputEntry> _inputPool;
+	/// <summary>
+	/// Register an input key and get it's handle, valid in every pool. INDEX_NONE for a None key. Game thread only.
+	/// </summary>
+	static int32 RegisterInput(FName key);
 
-	//The input pool of the last frame
-	TMap<FName, FInputEntry> _inputPool_last;
+	/// <summary>
+	/// Get the handle of an input key. INDEX_NONE if it's not registered.
+	/// </summary>
+	static int32 FindInput(FName key);
 
+	/// <summary>
+	/// Get the key of an input handle.
+	/// </summary>
+	static FName GetInputKey(int32 handle);
 
+	/// <summary>
+	/// Get the number of inputs keys registered.
+	/// </summary>
+	static int32 GetRegisteredInputCount();
 
 	/// <summary>
-	/// Add input to the input pool. return true when added not replaced
+	/// Get the network id of an input handle. Computed from the key, so the same on every machine, unlike the handle. 0 if the handle is not registered. Two keys with the same id are a fatal error on registration.
 	/// </summary>
-	FORCEINLINE bool AddOrReplace(FName key, FInputEntry entry)
-	{
-		if (key.IsNone())
-			return false;
+	static uint32 GetInputNetId(int32 handle);
 
-		//entry.Axis = entry.Axis.GetClampedToMaxSize(1);
-		entry.Axis = entry.Axis;
+	/// <summary>
+	/// Get the handle of an input from it's network id. INDEX_NONE if no registered key has this id.
+	/// </summary>
+	static int32 FindInputByNetId(uint32 netId);
+
+
+	/// <summary>
+	/// Make room for a number of inputs handles, so no allocation happens when they are first added.
+	/// </summary>
+	FORCEINLINE void Reserve(int32 inputCount)
+	{
+		if (inputCount <= _slots.Num())
+			return;
+		_slots.SetNum(inputCount);
+	}
 
-		if (_inputPool.Contains(key))
+	/// <summary>
+	/// Clear every input of the pool, keeping the storage.
+	/// </summary>
+	FORCEINLINE void Reset()
+	{
+		for (FInputEntrySlot& slot : _slots)
 		{
-			entry.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
-			_inputPool[key] = entry;
+			slot.bPending = false;
+			slot.bHasLast = false;
 		}
-		else
+	}
+
+	/// <summary>
+	/// Copy the inputs of another pool, reusing the storage.
+	/// </summary>
+	FORCEINLINE void CopyFrom(const UInputEntryPool& other)
+	{
+		Reserve(other._slots.Num());
+		for (int32 handle = 0; handle < _slots.Num(); handle++)
 		{
-			entry.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
-			_inputPool.Add(key, entry);
+			if (other._slots.IsValidIndex(handle))
+			{
+				_slots[handle] = other._slots[handle];
+			}
+			else
+			{
+				_slots[handle].bPending = false;
+				_slots[handle].bHasLast = false;
+			}
 		}
+	}
+
+
+	/// <summary>
+	/// Add input to the input pool. return true when added not replaced
+	/// </summary>
+	FORCEINLINE bool AddOrReplace(int32 handle, FInputEntry entry)
+	{
+		if (handle < 0)
+			return false;
+		if (handle >= _slots.Num())
+			Reserve(FMath::Max(handle + 1, GetRegisteredInputCount()));
+
+		entry.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
+		_slots[handle].Pending = entry;
+		_slots[handle].bPending = true;
 		return true;
 	}
 
+	/// <summary>
+	/// Add input to the input pool. return true when added not replaced
+	/// </summary>
+	FORCEINLINE bool AddOrReplace(FName key, FInputEntry entry)
+	{
+		return AddOrReplace(RegisterInput(key), entry);
+	}
+
 	/// <summary>
 	/// Get input from the inputs pool
 	/// </summary>
-	FORCEINLINE FInputEntry ReadInput(FName key, bool debug = false, UObject* worldContext = NULL) const
+	FORCEINLINE FInputEntry ReadInput(int32 handle, bool debug = false, UObject* worldContext = NULL) const
 	{
 		FInputEntry entry = FInputEntry();
 		bool validInput = false;
-		if (_inputPool_last.Contains(key))
+		const FInputEntrySlot* slot = _slots.IsValidIndex(handle) ? &_slots[handle] : nullptr;
+		if (slot && slot->bHasLast)
 		{
-			entry.Nature = _inputPool_last[key].Nature;
-			entry.Type = _inputPool_last[key].Type;
-			entry.Phase = _inputPool_last[key].Phase;
-			entry.Axis = _inputPool_last[key].Axis;
-			entry._bufferChrono = _inputPool_last[key]._bufferChrono;
-			entry._activeDuration = _inputPool_last[key]._activeDuration;
+			entry.Nature = slot->Last.Nature;
+			entry.Type = slot->Last.Type;
+			entry.Phase = slot->Last.Phase;
+			entry.Axis = slot->Last.Axis;
+			entry._bufferChrono = slot->Last._bufferChrono;
+			entry._activeDuration = slot->Last._activeDuration;
 			if (entry.Type == EInputEntryType::InputEntryType_Buffered && entry.Phase == EInputEntryPhase::InputEntryPhase_Released && entry._bufferChrono > 0)
 			{
 				entry.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
@@ -339,14 +418,14 @@ public:
 			}
 			validInput = true;
 		}
-		else if (_inputPool.Contains(key))
+		else if (slot && slot->bPending)
 		{
-			entry.Nature = _inputPool[key].Nature;
-			entry.Type = _inputPool[key].Type;
-			entry.Phase = _inputPool[key].Phase;
-			entry.Axis = _inputPool[key].Axis;
-			entry._bufferChrono = _inputPool[key]._bufferChrono;
-			entry._activeDuration = _inputPool[key]._activeDuration;
+			entry.Nature = slot->Pending.Nature;
+			entry.Type = slot->Pending.Type;
+			entry.Phase = slot->Pending.Phase;
+			entry.Axis = slot->Pending.Axis;
+			entry._bufferChrono = slot->Pending._bufferChrono;
+			entry._activeDuration = slot->Pending._activeDuration;
 			if (entry.Type == EInputEntryType::InputEntryType_Buffered && entry.Phase == EInputEntryPhase::InputEntryPhase_Released)
 			{
 				entry.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
@@ -362,8 +441,9 @@ public:
 		}
 
 
-		if (debug && worldContext && validInput)
+		if (MODULAR_CONTROLLER_DEBUG && debug && worldContext && validInput)
 		{
+			const FName key = GetInputKey(handle);
 			float bufferChrono = entry._bufferChrono;
 			float activeDuration = entry._activeDuration;
 			FColor debugColor;
@@ -386,6 +466,30 @@ public:
 		return entry;
 	}
 
+	/// <summary>
+	/// Get input from the inputs pool
+	/// </summary>
+	FORCEINLINE FInputEntry ReadInput(FName key, bool debug = false, UObject* worldContext = NULL) const
+	{
+		return ReadInput(FindInput(key), debug, worldContext);
+	}
+
+	/// <summary>
+	/// Read an input and consume it.
+	/// </summary>
+	/// <param name="handle"></param>
+	/// <returns></returns>
+	FORCEINLINE FInputEntry ConsumeInput(int32 handle, bool debug = false, UObject* worldContext = NULL)
+	{
+		const FInputEntry entry = ReadInput(handle, debug, worldContext);
+		if (_slots.IsValidIndex(handle))
+		{
+			_slots[handle].bHasLast = false;
+			_slots[handle].bPending = false;
+		}
+		return entry;
+	}
+
 	/// <summary>
 	/// Read an input and consume it.
 	/// </summary>
@@ -393,95 +497,130 @@ public:
 	/// <returns></returns>
 	FORCEINLINE FInputEntry ConsumeInput(FName key, bool debug = false, UObject* worldContext = NULL)
 	{
-		FInputEntry entry = FInputEntry();
-		entry = ReadInput(key, debug, worldContext);
-		if (_inputPool_last.Contains(key))
-			_inputPool_last.Remove(key);
-		if (_inputPool.Contains(key))
-			_inputPool.Remove(key);
-		return entry;
+		return ConsumeInput(FindInput(key), debug, worldContext);
 	}
 
 	/// <summary>
-	/// Update the inputs pool
+	/// Update the inputs pool, in a single pass over the slots.
 	/// </summary>
 	FORCEINLINE void UpdateInputs(float delta)
 	{
-		//Update Existing
-		for (auto& entry : _inputPool_last)
+		for (FInputEntrySlot& slot : _slots)
 		{
-			if (_inputPool_last[entry.Key]._bufferChrono > 0)
-				_inputPool_last[entry.Key]._bufferChrono -= delta;
-		}
-
-		//New comers
-		for (auto& entry : _inputPool)
-		{
-			if (!_inputPool_last.Contains(entry.Key))
+			if (slot.bPending)
 			{
-				auto input = entry.Value;
-				input.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
-				input._activeDuration = 0;
-				input._bufferChrono = input.InputBuffer;
-				_inputPool_last.Add(entry.Key, input);
+				if (!slot.bHasLast)
+				{
+					//New comer
+					slot.Last = slot.Pending;
+					slot.Last.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
+					slot.Last._activeDuration = 0;
+					slot.Last._bufferChrono = slot.Last.InputBuffer;
+					slot.bHasLast = true;
+				}
+				else
+				{
+					slot.Last.Phase = EInputEntryPhase::InputEntryPhase_Pressed;
+					slot.Last._activeDuration += delta;
+					slot.Last.Axis = slot.Pending.Axis;
+					slot.Last._bufferChrono = slot.Last.InputBuffer;
+				}
+				slot.bPending = false;
 			}
-			else
+			else if (slot.bHasLast)
 			{
-				_inputPool_last[entry.Key].Phase = EInputEntryPhase::InputEntryPhase_Pressed;
-				_inputPool_last[entry.Key]._activeDuration += delta;
-				_inputPool_last[entry.Key].Axis = entry.Value.Axis;
-				_inputPool_last[entry.Key]._bufferChrono = _inputPool_last[entry.Key].InputBuffer;
+				//Gone
+				if (slot.Last._bufferChrono > 0)
+					slot.Last._bufferChrono -= delta;
+				slot.Last.Phase = EInputEntryPhase::InputEntryPhase_Released;
+				slot.Last._activeDuration = 0;
 			}
 		}
+	}
 
-		//Gones
-		for (auto& entry : _inputPool_last)
+	/// <summary>
+	/// Is there any input pending, active or still buffered in the pool?
+	/// </summary>
+	FORCEINLINE bool HasActiveInputs() const
+	{
+		for (const FInputEntrySlot& slot : _slots)
 		{
-			if (!_inputPool.Contains(entry.Key))
-			{
-				_inputPool_last[entry.Key].Phase = EInputEntryPhase::InputEntryPhase_Released;
-				_inputPool_last[entry.Key]._activeDuration = 0;
-			}
+			if (slot.bPending)
+				return true;
+			if (slot.bHasLast && (slot.Last.Phase != EInputEntryPhase::InputEntryPhase_Released || slot.Last._bufferChrono > 0))
+				return true;
 		}
+		return false;
+	}
 
-		_inputPool.Empty();
+	/// <summary>
+	/// Is the input pending, active or still buffered in the pool? Reading it would not give a None or Released phase.
+	/// </summary>
+	FORCEINLINE bool IsInputLive(int32 handle) const
+	{
+		if (!_slots.IsValidIndex(handle))
+			return false;
+		const FInputEntrySlot& slot = _slots[handle];
+		return slot.bPending || (slot.bHasLast && (slot.Last.Phase != EInputEntryPhase::InputEntryPhase_Released || slot.Last._bufferChrono > 0));
 	}
 
-	FORCEINLINE void PredictInputs(UInputEntryPool from, float time, float delta)
+	/// <summary>
+	/// Is the input pending, active or still buffered in the pool? Reading it would not give a None or Released phase.
+	/// </summary>
+	FORCEINLINE bool IsInputLive(FName key) const
+	{
+		return IsInputLive(FindInput(key));
+	}
+
+	/// <summary>
+	/// Extrapolate the inputs of the pool over a time, from their trend since a previous state of the pool.
+	/// Axes and values continue their change, pressed buttons are released once their buffer is out and held buttons stay held.
+	/// </summary>
+	/// <param name="from">The pool as it was a delta time before this one</param>
+	/// <param name="time">The time to extrapolate over</param>
+	/// <param name="delta">The time between the previous pool and this one</param>
+	FORCEINLINE void PredictInputs(const UInputEntryPool& from, float time, float delta)
 	{
-		for (auto input : from._inputPool_last)
+		for (int32 handle = 0; handle < _slots.Num(); handle++)
 		{
-			if (!_inputPool_last.Contains(input.Key))
+			if (!_slots[handle].bHasLast)
 				continue;
-			switch (input.Value.Nature)
+			const bool hasTrend = delta > 0 && from._slots.IsValidIndex(handle) && from._slots[handle].bHasLast;
+			const FInputEntry& fromInput = hasTrend ? from._slots[handle].Last : _slots[handle].Last;
+			FInputEntry& input = _slots[handle].Last;
+			switch (input.Nature)
 			{
 			case EInputEntryNature::InputEntryNature_Axis:
-				_inputPool_last[input.Key].Axis += (_inputPool_last[input.Key].Axis - input.Value.Axis) * (time / delta);
-				_inputPool_last[input.Key].Axis = _inputPool_last[input.Key].Axis.GetClampedToMaxSize(1);
+				if (!hasTrend)
+					break;
+				input.Axis += (input.Axis - fromInput.Axis) * (time / delta);
+				input.Axis = input.Axis.GetClampedToMaxSize(1);
 				break;
 			case EInputEntryNature::InputEntryNature_Value:
-				_inputPool_last[input.Key].Axis.X += (_inputPool_last[input.Key].Axis.X - input.Value.Axis.X) * (time / delta);
-				_inputPool_last[input.Key].Axis = _inputPool_last[input.Key].Axis.GetClampedToMaxSize(1);
+				if (!hasTrend)
+					break;
+				input.Axis.X += (input.Axis.X - fromInput.Axis.X) * (time / delta);
+				input.Axis = input.Axis.GetClampedToMaxSize(1);
 				break;
 			case EInputEntryNature::InputEntryNature_Button:
 			{
-				if (_inputPool_last[input.Key].Type == EInputEntryType::InputEntryType_Buffered)
+				if (input.Type == EInputEntryType::InputEntryType_Buffered)
 				{
-					_inputPool_last[input.Key]._bufferChrono += time;
-					if (_inputPool_last[input.Key]._bufferChrono >= _inputPool_last[input.Key].InputBuffer)
+					input._bufferChrono -= time;
+					if (input._bufferChrono <= 0)
 					{
-						if (_inputPool_last[input.Key].Phase == InputEntryPhase_Pressed)
-							_inputPool_last[input.Key].Phase = InputEntryPhase_Released;
-						if (_inputPool_last[input.Key].Phase == InputEntryPhase_Held)
-							_inputPool_last[input.Key]._activeDuration += time;
+						if (input.Phase == InputEntryPhase_Pressed)
+							input.Phase = InputEntryPhase_Released;
+						if (input.Phase == InputEntryPhase_Held)
+							input._activeDuration += time;
 					}
 				}
 				else
 				{
-					if (_inputPool_last[input.Key].Phase == InputEntryPhase_Pressed)
-						_inputPool_last[input.Key].Phase = InputEntryPhase_Released;
-					if (_inputPool_last[input.Key].Phase == InputEntryPhase_Held)
-						_inputPool_last[input.Key]._activeDuration += time;
+					if (input.Phase == InputEntryPhase_Pressed)
+						input.Phase = InputEntryPhase_Released;
+					if (input.Phase == InputEntryPhase_Held)
+						input._activeDuration += time;
 				}
 			}
 			break;
@@ -491,6 +630,182 @@ public:
 };
 
 
+/*
+* An input listened during a simulation frame, compacted. The axis is only used by the axes and values.
+*/
+struct MODULARCONTROLLER_API FInputFrameSlot
+{
+	// The axis or value, quantized.
+	FIntVector Axis = FIntVector::ZeroValue;
+
+	// The input buffer of the entry.
+	float InputBuffer = 0;
+
+	// The nature of the entry.
+	TEnumAsByte<EInputEntryNature> Nature = EInputEntryNature::InputEntryNature_Button;
+
+	// The type of the entry.
+	TEnumAsByte<EInputEntryType> Type = EInputEntryType::InputEntryType_Simple;
+};
+
+
+/*
+* The inputs listened during a simulation frame, compacted: a bit per input slot listened and the slot of each input as it was listened.
+* The slots are local to the ring holding the frame. See FInputFrameRing::ToBytes to move a frame between machines.
+*/
+struct MODULARCONTROLLER_API FInputFrame
+{
+	// The precision of the quantized axes.
+	static constexpr double AxisPrecision = 0.001;
+
+	// The simulation frame, -1 for an empty frame.
+	int64 Frame = -1;
+
+	// The move input, quantized.
+	FIntVector MoveInput = FIntVector::ZeroValue;
+
+	// A bit per input slot of the ring, set when the input was listened this frame.
+	TBitArray<> Listened;
+
+	// The inputs by slot of the ring. Only valid where listened.
+	TArray<FInputFrameSlot, TInlineAllocator<8>> Slots;
+
+	// Make room for a number of slots. The storage is kept from a frame to the other.
+	FORCEINLINE void SetSlotCount(int32 slotCount)
+	{
+		if (Listened.Num() < slotCount)
+			Listened.Add(false, slotCount - Listened.Num());
+		if (Slots.Num() < slotCount)
+			Slots.SetNum(slotCount);
+	}
+
+	FORCEINLINE static FIntVector Quantize(const FVector& vector)
+	{
+		return FIntVector(FMath::RoundToInt32(FMath::Clamp(vector.X / AxisPrecision, (double)MIN_int32, (double)MAX_int32))
+			, FMath::RoundToInt32(FMath::Clamp(vector.Y / AxisPrecision, (double)MIN_int32, (double)MAX_int32))
+			, FMath::RoundToInt32(FMath::Clamp(vector.Z / AxisPrecision, (double)MIN_int32, (double)MAX_int32)));
+	}
+
+	FORCEINLINE static FVector Dequantize(const FIntVector& vector)
+	{
+		return FVector(vector.X, vector.Y, vector.Z) * AxisPrecision;
+	}
+};
+
+
+/*
+* A fixed capacity ring of the inputs listened each simulation frame, indexed by frame.
+* Replaying a frame in a pool, then updating it, gives the pool as it was on that frame.
+*/
+struct MODULARCONTROLLER_API FInputFrameRing
+{
+public:
+
+	// Set the number of frames kept, clearing the ring. 0 disables the ring.
+	void Initialize(int capacity);
+
+	// Record the inputs listened in a pool this frame. Must be called before the inputs are consumed and the pool updated.
+	void Record(int64 frame, const FVector& moveInput, const UInputEntryPool& pool);
+
+	// Is the frame still in the ring?
+	FORCEINLINE bool Contains(int64 frame) const { return _frames.Num() > 0 && frame >= 0 && _frames[frame % _frames.Num()].Frame == frame; }
+
+	// Get a recorded frame, null if it's not in the ring anymore.
+	FORCEINLINE const FInputFrame* Find(int64 frame) const { return Contains(frame) ? &_frames[frame % _frames.Num()] : nullptr; }
+
+	// Listen the inputs of a recorded frame in a pool, and get it's move input. false if the frame is not in the ring anymore.
+	bool Replay(int64 frame, UInputEntryPool& pool, FVector& moveInput) const;
+
+	// Write a recorded frame as bytes, field by field. The inputs are written by network id with their nature, type and buffer, so the bytes are valid on any machine. false if the frame is not in the ring anymore.
+	bool ToBytes(int64 frame, TArray<uint8>& outBytes) const;
+
+	// Store a frame from it's bytes, e.g. received from the network. The inputs whose keys are not registered locally are ignored. false if the bytes are malformed.
+	bool FromBytes(TArrayView<const uint8> bytes);
+
+private:
+
+	// Get the slot of an input handle in the frames, adding it on first use.
+	int32 GetOrAddSlot(int32 handle);
+
+	// The frames, by frame modulo the capacity.
+	TArray<FInputFrame> _frames;
+
+	// The input handle of each slot of the frames, buttons and axes alike. Slots are only added, so a frame's slots stay valid.
+	TArray<int32> _slotsHandles;
+
+	// The slot of each input handle, INDEX_NONE if never recorded.
+	TArray<int32> _handlesSlots;
+};
+
+
+/*
+* An input tracked by a pool, as sent over the network.
+*/
+USTRUCT()
+struct MODULARCONTROLLER_API FNetInputEntry
+{
+	GENERATED_BODY()
+
+public:
+
+	// The network id of the input key. see UInputEntryPool::GetInputNetId.
+	UPROPERTY()
+	uint32 InputId = 0;
+
+	UPROPERTY()
+	TEnumAsByte<EInputEntryNature> Nature = EInputEntryNature::InputEntryNature_Button;
+
+	UPROPERTY()
+	TEnumAsByte<EInputEntryType> Type = EInputEntryType::InputEntryType_Simple;
+
+	UPROPERTY()
+	TEnumAsByte<EInputEntryPhase> Phase = EInputEntryPhase::InputEntryPhase_None;
+
+	UPROPERTY()
+	FVector_NetQuantize100 Axis = FVector(0);
+
+	// The time the input have been active, in milliseconds.
+	UPROPERTY()
+	uint16 ActiveDuration = 0;
+
+	// The buffer time remaining, in milliseconds.
+	UPROPERTY()
+	uint16 BufferChrono = 0;
+};
+
+
+/*
+* The inputs live in a pool, compacted to be sent with the move commands. Used to evaluate and extrapolate the remote controllers inputs.
+*/
+USTRUCT()
+struct MODULARCONTROLLER_API FNetInputSnapshot
+{
+	GENERATED_BODY()
+
+public:
+
+	// The live inputs, in handle order.
+	UPROPERTY()
+	TArray<FNetInputEntry> Inputs;
+
+	// Are the inputs set? The inputs are only sent when they changed, the receiver keeps the previous ones otherwise.
+	UPROPERTY()
+	bool bIsSet = false;
+
+	// Capture the live inputs of a pool, once it's updated. Reuses the storage.
+	void Capture(const UInputEntryPool& pool);
+
+	// Set a pool to the captured inputs. The inputs whose keys are not registered locally are ignored.
+	void Apply(UInputEntryPool& pool) const;
+
+	// Did an input start, stop or change phase since another snapshot? the axes values are not compared.
+	bool HasChanged(const FNetInputSnapshot& other) const;
+
+	// Are the inputs the same as another snapshot's, axes values included? The active and buffer times are not compared.
+	bool Equals(const FNetInputSnapshot& other) const;
+};
+
+
 #pragma endregion
 
 
@@ -775,6 +1090,207 @@ public:
 };
 
 
+/// <summary>
+/// A reference to the runtime properties of a state or an action for the controller using it. Only valid during the call it's passed to.
+/// </summary>
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FBehaviourRuntimeRef
+{
+	GENERATED_BODY()
+
+public:
+
+	FORCEINLINE FBehaviourRuntimeRef() {}
+
+	FORCEINLINE FBehaviourRuntimeRef(void* data, const UScriptStruct* runtimeStruct) : _data(data), _struct(runtimeStruct) {}
+
+	// Is there runtime properties referenced?
+	FORCEINLINE bool IsValid() const { return _data != nullptr; }
+
+	// Get the runtime properties as a runtime struct type. nullptr if they are not of this type.
+	template<typename T>
+	FORCEINLINE T* GetPtr() const
+	{
+		return _data != nullptr && _struct->IsChildOf(T::StaticStruct()) ? static_cast<T*>(_data) : nullptr;
+	}
+
+	// Get the runtime properties as a runtime struct type. They must be of this type.
+	template<typename T>
+	FORCEINLINE T& Get() const
+	{
+		T* runtime = GetPtr<T>();
+		check(runtime != nullptr);
+		return *runtime;
+	}
+
+private:
+
+	void* _data = nullptr;
+
+	const UScriptStruct* _struct = nullptr;
+};
+
+
+/// <summary>
+/// The runtime properties of a behaviour for one controller, with a ring of their snapshots indexed by simulation frame.
+/// An extra slot is kept for the simulation snapshot. Every property of the runtime struct the behaviour returns is saved, the struct being the explicit opt in.
+/// </summary>
+struct MODULARCONTROLLER_API FBehaviourSnapShotRing
+{
+public:
+
+	FBehaviourSnapShotRing() {}
+
+	FBehaviourSnapShotRing(const FBehaviourSnapShotRing&) = delete;
+
+	FBehaviourSnapShotRing& operator=(const FBehaviourSnapShotRing&) = delete;
+
+	~FBehaviourSnapShotRing() { Release(); }
+
+	// The frame of the simulation slot.
+	static constexpr int64 SimulationFrame = -1;
+
+	// The frame of a slot nothing was saved in. Distinct from every frame that can be saved.
+	static constexpr int64 EmptyFrame = MIN_int64;
+
+	// Allocate the live runtime properties of the runtime struct and the ring.
+	void Initialize(const UScriptStruct* runtimeStruct, int depth);
+
+	// Destroy the stored values and free the ring.
+	void Release();
+
+	// Copy the live runtime properties in the slot of the frame.
+	void Save(int64 frame);
+
+	// Copy the runtime properties saved for the frame back to the live ones. false if the frame is not in the ring anymore.
+	bool Restore(int64 frame);
+
+	// Is the frame still in the ring?
+	bool Contains(int64 frame) const;
+
+	// Report the objects referenced by the live runtime properties and every snapshot to the garbage collector.
+	void AddReferencedObjects(FReferenceCollector& collector, const UObject* owner);
+
+	// The runtime struct of the properties.
+	FORCEINLINE const UScriptStruct* GetStruct() const { return _struct; }
+
+	// The live runtime properties.
+	FORCEINLINE void* GetLive() const { return _struct ? const_cast<uint8*>(_buffer.GetData()) + _frames.Num() * _slotSize : nullptr; }
+
+	// A reference to the live runtime properties, passed to the behaviour.
+	FORCEINLINE FBehaviourRuntimeRef GetRef() const { return FBehaviourRuntimeRef(GetLive(), _struct); }
+
+	// The live runtime properties, as a runtime struct type they must be of.
+	template<typename T>
+	FORCEINLINE T& Get() const { return GetRef().Get<T>(); }
+
+private:
+
+	// Get the slot of a frame.
+	FORCEINLINE int GetSlot(int64 frame) const
+	{
+		if (frame == SimulationFrame)
+			return _depth;
+		return static_cast<int>(frame % _depth);
+	}
+
+	// Can the frame be stored in the ring?
+	FORCEINLINE bool IsValidFrame(int64 frame) const
+	{
+		if (_frames.Num() <= 0)
+			return false;
+		if (frame == SimulationFrame)
+			return true;
+		return frame >= 0 && _depth > 0;
+	}
+
+	// The runtime struct of the properties.
+	const UScriptStruct* _struct = nullptr;
+
+	// The size of a slot, aligned.
+	int32 _slotSize = 0;
+
+	// The number of frames kept.
+	int _depth = 0;
+
+	// The frame stored in each slot, the live slot excepted.
+	TArray<int64> _frames;
+
+	// The slots values, the live one last.
+	TArray<uint8, TAlignedHeapAllocator<16>> _buffer;
+};
+
+
+/// <summary>
+/// The cooldowns and phases boundaries of a controller's actions, by timestamp on the schedule clock.
+/// Lets the controller skip the actions cooling down and notify phase changes without visiting every action every frame.
+/// </summary>
+struct MODULARCONTROLLER_API FActionTimerSchedule
+{
+public:
+
+	// The time of the schedule, advanced with the live updates only.
+	double Clock = 0;
+
+	// Clear the schedule, for a number of actions.
+	void Reset(int actionCount);
+
+	// Replace the timers of an action, from it's remaining cooldown and activation times.
+	void Schedule(int actionIndex, double coolDown, double remainingActivation, float activePhaseDuration, float recoveryPhaseDuration);
+
+	// Is the action cooling down? remaining is set to the cooldown time left.
+	bool IsCoolingDown(int actionIndex, double& remaining) const;
+
+	// Pop the next phase boundary reached by the clock, if any.
+	bool PopDuePhase(int& actionIndex, EActionPhase& phase);
+
+private:
+
+	// A phase boundary of an action.
+	struct FPhaseEvent
+	{
+		double Time = 0;
+		int ActionIndex = 0;
+		uint32 Generation = 0;
+		EActionPhase Phase = ActionPhase_Undetermined;
+
+		FORCEINLINE bool operator<(const FPhaseEvent& other) const { return Time < other.Time; }
+	};
+
+	// The phases boundaries, as a min heap on time.
+	TArray<FPhaseEvent> _phaseEvents;
+
+	// The end of the cooldown of each action.
+	TArray<double> _coolDownEnds;
+
+	// The generation of each action timers. events from an older generation are discarded.
+	TArray<uint32> _generations;
+};
+
+
+/*
+* A state or action transition waiting to be notified to the behaviours and listeners.
+*/
+USTRUCT()
+struct MODULARCONTROLLER_API FBehaviourTransitionEvent
+{
+	GENERATED_BODY()
+
+public:
+
+	// Is it an action transition? otherwise it's a state transition.
+	bool bIsAction = false;
+
+	// The behaviour transitioned to. Can be null.
+	UPROPERTY()
+	UObject* NewBehaviour = nullptr;
+
+	// The behaviour transitioned from. Can be null.
+	UPROPERTY()
+	UObject* OldBehaviour = nullptr;
+};
+
+
 #pragma endregion
 
 
@@ -1116,7 +1632,7 @@ public:
 	/// </summary>
 	/// <param name="otherCmd"></param>
 	/// <returns></returns>
-	FORCEINLINE bool HasChanged(FClientNetMoveCommand otherCmd, double minLocationOffset = 10, double minAngularOffset = 10, double velocityOffset = 10, FVector* debugValues = NULL)
+	FORCEINLINE bool HasChanged(const FClientNetMoveCommand& otherCmd, double minLocationOffset = 10, double minAngularOffset = 10, double velocityOffset = 10, FVector* debugValues = NULL) const
 	{
 		double locationOffset = (ToLocation - otherCmd.ToLocation).Length();
 		double angularOffset = FMath::RadiansToDegrees(ToRotation.Quaternion().AngularDistance(otherCmd.ToRotation.Quaternion()));
@@ -1161,6 +1677,10 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "NetMoveCommand")
 	FStatusParameters ControllerStatus;
 
+	// The inputs of the user when the command was made.
+	UPROPERTY()
+	FNetInputSnapshot Inputs;
+
 };
 
 
@@ -1261,6 +1781,86 @@ struct FServerNetCorrectionData
 
 
 
+/*
+* The data of a controller's frame, passed from an update phase to the next.
+*/
+USTRUCT()
+struct MODULARCONTROLLER_API FControllerPhasedUpdate
+{
+	GENERATED_BODY()
+
+public:
+
+	// Should the integration and commit phases run?
+	bool bIsValid = false;
+
+	// Was a server correction applied this frame?
+	bool bCorrected = false;
+
+	// The delta time of the frame.
+	float Delta = 0;
+
+	// The user move input consumed this frame.
+	FVector MoveInput = FVector(0);
+
+	// The movement being built.
+	FKinematicInfos Movement;
+
+	// The status evaluated on the decision phase.
+	FStatusParameters Status;
+
+	// The motion from the status, altered by root motion.
+	FVelocity AlteredMotion;
+
+	// The collision resolved move from the integration phase.
+	FVelocity ResultingMove;
+
+	// The component to push, from the integration phase.
+	TWeakObjectPtr<UPrimitiveComponent> PushedComponent;
+
+	// The force to apply to the pushed component.
+	FVector PushForce = FVector(0);
+
+	// The location where to push the component.
+	FVector PushLocation = FVector(0);
+
+	// The bone of the pushed component.
+	FName PushBoneName;
+};
+
+
+
+/*
+* A component sweep of a batch. All the sweeps of a batch share the shape, rotation and query parameters.
+*/
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FComponentSweepRequest
+{
+	GENERATED_BODY()
+
+public:
+
+	FORCEINLINE FComponentSweepRequest()
+	{
+	}
+
+	FORCEINLINE FComponentSweepRequest(const FVector position, const FVector direction)
+	{
+		Position = position;
+		Direction = direction;
+	}
+
+	// The start of the sweep.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Param")
+	FVector Position = FVector(0);
+
+	// The direction and length of the sweep.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Param")
+	FVector Direction = FVector(0);
+};
+
+
+
 #pragma endregion
 
 
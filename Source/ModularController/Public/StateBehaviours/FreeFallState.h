@@ -6,6 +6,30 @@
 
 
 
+/**
+ The runtime properties of the free fall state for one controller.
+ */
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FFreeFallStateRuntime : public FControllerStateRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	//The time spend in the air
+	UPROPERTY(BlueprintReadOnly, category = "Free Fall")
+	float AirTime = 0;
+
+	//the gravity vector
+	UPROPERTY(BlueprintReadOnly, category = "Free Fall")
+	FVector Gravity = FVector(0);
+
+	//Was the gravity set by SetGravityForce? Kept when entering the state then.
+	UPROPERTY()
+	bool bGravityOverriden = false;
+};
+
+
 /**
  A Free fall behaviour for the Modular controller component
  */
@@ -35,23 +59,6 @@ protected:
 
 #pragma endregion
 
-#pragma region LiveAttributes
-private:
-	//The time spend in the air
-	float _airTime;
-
-	//the gravity vector
-	FVector _gravity;
-
-#pragma endregion
-
-#pragma region SnapShot
-private:
-	float _airTime_saved;
-	FVector _gravity_saved;
-
-#pragma endregion
-
 #pragma region Air Velocity and Checks
 public:
 
@@ -68,42 +75,40 @@ public:
 	/// </summary>
 	/// <param name="delta"></param>
 	/// <returns></returns>
-	virtual FVector AddGravity(FVector verticalVelocity, float delta);
+	virtual FVector AddGravity(const FFreeFallStateRuntime& runtime, FVector verticalVelocity, float delta);
 	
 
 	/// <summary>
 	/// Get the time spend in the air.
 	/// </summary>
 	UFUNCTION(BlueprintCallable, Category = "Properties")
-	FORCEINLINE float GetAirTime() { return _airTime; }
+	float GetAirTime(const FBehaviourRuntimeRef& runtime) const;
 
-	//Set new gravity force.
+	//Set new gravity force of a controller.
 	UFUNCTION(BlueprintCallable, Category="Gravity Control")
-	void SetGravityForce(FVector newGravity, UModularControllerComponent* controller = NULL);
+	void SetGravityForce(FVector newGravity, UModularControllerComponent* controller);
 	
 
 #pragma endregion
 
 #pragma region Functions
 public:
+
+	virtual const UScriptStruct* GetRuntimeStruct() const override { return FFreeFallStateRuntime::StaticStruct(); }
 	
-	virtual  bool CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs
+	virtual  bool CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs
 		, UModularControllerComponent* controller, FStatusParameters controllerStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus) override;
 
-	virtual void OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual void OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 	
-	virtual FVelocity ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual FVelocity ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual void OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual void OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 	
-	virtual FString DebugString() override;
-
-
-	virtual	void OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller) override;
+	virtual FString DebugString(const FBehaviourRuntimeRef& runtime) override;
 
 
-	virtual void SaveStateSnapShot_Internal() override;
-	virtual void RestoreStateFromSnapShot_Internal() override;
+	virtual	void OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller) override;
 
 #pragma endregion
 
@@ -4,8 +4,45 @@
 
 #include "CoreMinimal.h"
 #include "ComponentAndBase/BaseControllerState.h"
+#include "WorldCollision.h"
 #include "SimpleGroundState.generated.h"
 
+/**
+ * The runtime properties of the simple ground state for one controller.
+ */
+USTRUCT(BlueprintType)
+struct MODULARCONTROLLER_API FSimpleGroundStateRuntime : public FControllerStateRuntime
+{
+	GENERATED_BODY()
+
+public:
+
+	//The asynchronous ground probe issued for the next frame. Kept as a raw handle to be part of the runtime properties.
+	UPROPERTY()
+	uint64 AsyncSurfaceCheckHandle = 0;
+
+	//The position the asynchronous ground probe was issued from.
+	UPROPERTY()
+	FVector AsyncSurfaceCheckStart = FVector(0);
+
+	//The current surface's infos.
+	UPROPERTY()
+	FHitResult CurrentSurfaceHit;
+
+	//Delay the save position.
+	UPROPERTY()
+	float SavePosDelay = 0;
+
+	// The landing impact force remaining. it decrease over time at Landing Impact Absorption Speed
+	UPROPERTY(BlueprintReadOnly, category = "Movement")
+	float LandingImpactRemainingForce = 0;
+
+	//The last position the ground was checked from.
+	UPROPERTY()
+	FVector_NetQuantize LastControlledPosition = FVector(0);
+};
+
+
 /**
  * The SImple ground base movement state using component shape.
  */
@@ -37,6 +74,10 @@ protected:
 	// The ground collision Channel.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Main")
 	TEnumAsByte<ECollisionChannel> ChannelGround;
+
+	// Should the ground be probed asynchronously? The probe for the next frame is issued on this frame and consumed on the next one. Falls back on a blocking probe when the result is missing or the controller went too far from the predicted position.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, category = "Main")
+	bool bUseAsyncSurfaceCheck = false;
 	
 
 	//------------------------------------------------------------------------------------------
@@ -49,7 +90,13 @@ public:
 	/// </summary>
 	/// <param name="controller"></param>
 	/// <returns></returns>
-	virtual bool CheckSurface(const FTransform spacialInfos, const FVector gravity, UModularControllerComponent* controller, const FVector momentum, const float inDelta, bool useMaxDistance = false);
+	virtual bool CheckSurface(FSimpleGroundStateRuntime& runtime, const FTransform spacialInfos, const FVector gravity, UModularControllerComponent* controller, const FVector momentum, const float inDelta, bool useMaxDistance = false);
+
+	/// <summary>
+	/// Consume the asynchronous ground probe issued on the last frame, and issue the one for the next frame.
+	/// </summary>
+	/// <returns>True if the probe result was usable, false if a blocking probe is needed.</returns>
+	bool ConsumeAsyncSurfaceCheck(FSimpleGroundStateRuntime& runtime, FHitResult& outHit, const FTransform spacialInfos, const FVector gravityDirection, UModularControllerComponent* controller, const FVector momentum, const float inDelta, const float checkLength);
 
 	/// <summary>
 	/// Called when we land on a surface
@@ -77,14 +124,6 @@ public:
 
 #pragma region Surface and Snapping XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 
-protected:
-
-	//The current surface's infos.
-	FHitResult t_currentSurfaceInfos;
-
-	//Delay the save position.
-	float t_savePosDelay;
-	
 public:
 
 	/**
@@ -92,7 +131,7 @@ public:
 	 * @param inDatas The input datas
 	 * @return The instant force needed to snap the controller on the suarface at FloatingGroundDistance
 	 */
-	FVector ComputeSnappingForce(const FKinematicInfos& inDatas, UObject* debugObject = NULL) const;
+	FVector ComputeSnappingForce(const FSimpleGroundStateRuntime& runtime, const FKinematicInfos& inDatas, UObject* debugObject = NULL) const;
 
 #pragma endregion
 
@@ -116,10 +155,6 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, category = "Movement")
 	float LandingImpactMoveThreshold = 981;
 
-	// The landing impact force remaining. it decrease over time at Landing Impact Absorption Speed
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, category = "Movement")
-	float LandingImpactRemainingForce;
-
 
 public:
 
@@ -134,7 +169,7 @@ public:
 	 * @param changedState
 	 * @return vector corresponding to the linear movement
 	 */
-	virtual FVector MoveOnTheGround(const FKinematicInfos& inDatas, FVector desiredMovement, const float acceleration, const float deceleration, const float inDelta);
+	virtual FVector MoveOnTheGround(FSimpleGroundStateRuntime& runtime, const FKinematicInfos& inDatas, FVector desiredMovement, const float acceleration, const float deceleration, const float inDelta);
 
 	/**
 	 * @brief Correct movement to prevent falling.
@@ -144,21 +179,10 @@ public:
 	 * @param inDelta delta time
 	 * @return the corrected move
 	 */
-	virtual FVector MoveToPreventFalling(UModularControllerComponent* controller, const FKinematicInfos& inDatas, const FVector attemptedMove, const float inDelta, FVector& adjusmentMove);
+	virtual FVector MoveToPreventFalling(FSimpleGroundStateRuntime& runtime, UModularControllerComponent* controller, const FKinematicInfos& inDatas, const FVector attemptedMove, const float inDelta, FVector& adjusmentMove);
 
 #pragma endregion
 
-#pragma region SnapShot
-private:
-
-	float _landingImpactRemainingForce_saved;
-
-	FVector_NetQuantize _lastControlledPosition;
-	FVector_NetQuantize _lastControlledPosition_saved;
-
-#pragma endregion
-
-
 #pragma region Slope And Sliding XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 protected:
 
@@ -207,24 +231,22 @@ protected:
 #pragma region Functions XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX
 public:
 	
+	virtual const UScriptStruct* GetRuntimeStruct() const override { return FSimpleGroundStateRuntime::StaticStruct(); }
 	
-	virtual bool CheckState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
+	virtual bool CheckState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UInputEntryPool* inputs, UModularControllerComponent* controller
 		, FStatusParameters currentStatusParam, FStatusParameters& currentStatus, const float inDelta, int overrideWasLastStateStatus) override;
 
-	virtual void OnEnterState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual void OnEnterState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
 
-	virtual FVelocity ProcessState_Implementation(FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
+	virtual FVelocity ProcessState_Implementation(const FBehaviourRuntimeRef& runtime, FStatusParameters controllerStatusParam, FStatusParameters& controllerStatus, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 	
-	virtual void OnExitState_Implementation(const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
-
-	virtual	void OnControllerStateChanged_Implementation(FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller) override;
+	virtual void OnExitState_Implementation(const FBehaviourRuntimeRef& runtime, const FKinematicInfos& inDatas, const FVector moveInput, UModularControllerComponent* controller, const float inDelta) override;
 
-	virtual FString DebugString() override;
+	virtual	void OnControllerStateChanged_Implementation(const FBehaviourRuntimeRef& runtime, FName newBehaviourDescName, int newPriority, UModularControllerComponent* controller) override;
 
+	virtual FString DebugString(const FBehaviourRuntimeRef& runtime) override;
 
-	virtual void SaveStateSnapShot_Internal() override;
-	virtual void RestoreStateFromSnapShot_Internal() override;
 	
 
 #pragma endregion